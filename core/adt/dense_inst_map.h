@@ -0,0 +1,355 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/iterator.h>
+
+#include "core/block.h"
+#include "core/func.h"
+#include "core/inst.h"
+
+
+
+/**
+ * Map keyed by instruction sub-values, backed by flat tables.
+ *
+ * Entries are stored in one table per function, indexed by the dense index
+ * of the instruction within its function. Tables are split into fixed-size
+ * chunks which are allocated when first written, so maps populated with few
+ * values of a large function remain small. Lookups of keys from the most
+ * recently accessed function bypass hashing altogether.
+ *
+ * Keys are stored along with values, so slots reused after the indices of a
+ * function were compacted are not confused for one another. Values can be
+ * found and erased even after their instructions were detached, but only
+ * instructions attached to a function can be inserted. Chunks never move,
+ * thus pointers to values remain valid until the values are erased.
+ */
+template <typename T>
+class DenseInstMap final {
+public:
+  /// Key-value pair stored in the map.
+  using value_type = std::pair<ConstRef<Inst>, T>;
+
+private:
+  /// Number of entries in a chunk, as a power of two.
+  static constexpr unsigned kChunkBits = 6;
+  /// Number of entries in a chunk.
+  static constexpr unsigned kChunkSize = 1u << kChunkBits;
+  /// Chunk of entries.
+  using Chunk = std::array<std::optional<value_type>, kChunkSize>;
+
+  /// Table of entries for a single function.
+  struct Table {
+    /// Chunks, allocated on demand.
+    std::vector<std::unique_ptr<Chunk>> Chunks;
+
+    Table() = default;
+    Table(Table &&) = default;
+    Table &operator=(Table &&) = default;
+
+    Table(const Table &that)
+    {
+      for (const auto &chunk : that.Chunks) {
+        Chunks.emplace_back(chunk ? std::make_unique<Chunk>(*chunk) : nullptr);
+      }
+    }
+
+    Table &operator=(const Table &that)
+    {
+      Table copy(that);
+      return *this = std::move(copy);
+    }
+
+    /// Returns a slot, if its chunk was allocated.
+    std::optional<value_type> *Find(unsigned slot)
+    {
+      const unsigned idx = slot >> kChunkBits;
+      if (idx >= Chunks.size() || !Chunks[idx]) {
+        return nullptr;
+      }
+      return &(*Chunks[idx])[slot & (kChunkSize - 1)];
+    }
+  };
+
+  /// Mapping from function identifiers to tables.
+  using TableMap = llvm::DenseMap<unsigned, Table>;
+
+public:
+  /// Iterator over the entries of the map.
+  class const_iterator : public llvm::iterator_facade_base
+      < const_iterator
+      , std::forward_iterator_tag
+      , const value_type
+      >
+  {
+  public:
+    bool operator==(const const_iterator &that) const
+    {
+      return table_ == that.table_ && slot_ == that.slot_;
+    }
+
+    const value_type &operator*() const
+    {
+      const auto &chunk = *table_->second.Chunks[slot_ >> kChunkBits];
+      return *chunk[slot_ & (kChunkSize - 1)];
+    }
+
+    const_iterator &operator++()
+    {
+      ++slot_;
+      Skip();
+      return *this;
+    }
+
+  private:
+    friend class DenseInstMap;
+
+    const_iterator(
+        typename TableMap::const_iterator table,
+        typename TableMap::const_iterator end)
+      : table_(table)
+      , end_(end)
+      , slot_(0)
+    {
+      Skip();
+    }
+
+    /// Advances to the next set entry.
+    void Skip()
+    {
+      for (; table_ != end_; ++table_, slot_ = 0) {
+        const auto &chunks = table_->second.Chunks;
+        while ((slot_ >> kChunkBits) < chunks.size()) {
+          const auto &chunk = chunks[slot_ >> kChunkBits];
+          if (!chunk) {
+            slot_ = ((slot_ >> kChunkBits) + 1) << kChunkBits;
+            continue;
+          }
+          if ((*chunk)[slot_ & (kChunkSize - 1)]) {
+            return;
+          }
+          ++slot_;
+        }
+      }
+    }
+
+  private:
+    /// Current table.
+    typename TableMap::const_iterator table_;
+    /// End of the tables.
+    typename TableMap::const_iterator end_;
+    /// Index into the current table.
+    size_t slot_;
+  };
+
+public:
+  /// Creates an empty map.
+  DenseInstMap() : size_(0), lastID_(0), last_(nullptr) {}
+
+  DenseInstMap(const DenseInstMap &that)
+    : tables_(that.tables_)
+    , size_(that.size_)
+    , lastID_(0)
+    , last_(nullptr)
+  {
+  }
+
+  DenseInstMap(DenseInstMap &&that)
+    : tables_(std::move(that.tables_))
+    , size_(that.size_)
+    , lastID_(0)
+    , last_(nullptr)
+  {
+    that.Clear();
+  }
+
+  DenseInstMap &operator=(const DenseInstMap &that)
+  {
+    tables_ = that.tables_;
+    size_ = that.size_;
+    last_ = nullptr;
+    return *this;
+  }
+
+  DenseInstMap &operator=(DenseInstMap &&that)
+  {
+    tables_ = std::move(that.tables_);
+    size_ = that.size_;
+    last_ = nullptr;
+    that.Clear();
+    return *this;
+  }
+
+  /// Finds the value mapped to a key, returning nullptr if missing.
+  T *Find(ConstRef<Inst> ref)
+  {
+    auto *entry = FindEntry(ref);
+    return entry ? &(*entry)->second : nullptr;
+  }
+
+  /// Finds the value mapped to a key, returning nullptr if missing.
+  const T *Find(ConstRef<Inst> ref) const
+  {
+    return const_cast<DenseInstMap *>(this)->Find(ref);
+  }
+
+  /// Checks if a key is in the map.
+  bool Contains(ConstRef<Inst> ref) const { return Find(ref) != nullptr; }
+
+  /// Inserts a value if the key is missing.
+  template <typename... Args>
+  std::pair<T *, bool> Emplace(ConstRef<Inst> ref, Args &&... args)
+  {
+    auto &entry = GetEntry(ref);
+    if (entry) {
+      if (entry->first == ref) {
+        return { &entry->second, false };
+      }
+      // The slot is held by a stale key, whose index was reassigned.
+      entry.reset();
+      --size_;
+    }
+    entry.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(ref),
+        std::forward_as_tuple(std::forward<Args>(args)...)
+    );
+    ++size_;
+    return { &entry->second, true };
+  }
+
+  /// Returns the value mapped to a key, default-constructing it if missing.
+  T &operator[](ConstRef<Inst> ref) { return *Emplace(ref).first; }
+
+  /// Erases a key, returning true if it was present.
+  bool Erase(ConstRef<Inst> ref)
+  {
+    auto *entry = FindEntry(ref);
+    if (!entry) {
+      return false;
+    }
+    entry->reset();
+    --size_;
+    return true;
+  }
+
+  /// Removes all entries.
+  void Clear()
+  {
+    tables_.clear();
+    size_ = 0;
+    last_ = nullptr;
+  }
+
+  /// Returns the number of entries.
+  size_t Size() const { return size_; }
+  /// Checks if the map is empty.
+  bool Empty() const { return size_ == 0; }
+
+  // Iterators over entries, in no particular order.
+  const_iterator begin() const
+  {
+    return const_iterator(tables_.begin(), tables_.end());
+  }
+  const_iterator end() const
+  {
+    return const_iterator(tables_.end(), tables_.end());
+  }
+
+private:
+  /// Returns the slot of a sub-value.
+  static unsigned GetSlot(ConstRef<Inst> ref)
+  {
+    return ref->GetDenseIndex() + ref.Index();
+  }
+
+  /// Returns the table of a function, creating it if requested.
+  Table *GetTable(const Func &func, bool create)
+  {
+    const unsigned id = func.GetID();
+    if (last_ && lastID_ == id) {
+      return last_;
+    }
+    if (create) {
+      last_ = &tables_.try_emplace(id).first->second;
+    } else {
+      auto it = tables_.find(id);
+      if (it == tables_.end()) {
+        return nullptr;
+      }
+      last_ = &it->second;
+    }
+    lastID_ = id;
+    return last_;
+  }
+
+  /// Finds the set entry of a key.
+  std::optional<value_type> *FindEntry(ConstRef<Inst> ref)
+  {
+    const unsigned slot = GetSlot(ref);
+    auto match = [&](std::optional<value_type> *entry) {
+      return entry && *entry && (*entry)->first == ref;
+    };
+
+    // Instructions in a function are looked up in its table.
+    const Block *block = ref->getParent();
+    if (block && block->getParent()) {
+      if (Table *table = GetTable(*block->getParent(), false)) {
+        if (auto *entry = table->Find(slot); match(entry)) {
+          return entry;
+        }
+      }
+      return nullptr;
+    }
+
+    // Detached instructions retain their index, but their function is not
+    // known: the key is searched for in all tables.
+    for (auto &[id, table] : tables_) {
+      if (auto *entry = table.Find(slot); match(entry)) {
+        return entry;
+      }
+    }
+    return nullptr;
+  }
+
+  /// Returns the entry of a key, allocating its chunk if needed.
+  std::optional<value_type> &GetEntry(ConstRef<Inst> ref)
+  {
+    const Block *block = ref->getParent();
+    assert(block && block->getParent() && "instruction not in a function");
+    const Func &func = *block->getParent();
+    Table &table = *GetTable(func, true);
+    const unsigned slot = GetSlot(ref);
+    const unsigned idx = slot >> kChunkBits;
+    if (idx >= table.Chunks.size()) {
+      const unsigned bound = std::max(slot + 1, func.GetInstBound());
+      table.Chunks.resize((bound + kChunkSize - 1) >> kChunkBits);
+    }
+    auto &chunk = table.Chunks[idx];
+    if (!chunk) {
+      chunk = std::make_unique<Chunk>();
+    }
+    return (*chunk)[slot & (kChunkSize - 1)];
+  }
+
+private:
+  /// Per-function tables.
+  TableMap tables_;
+  /// Number of entries.
+  size_t size_;
+  /// Identifier of the function accessed last.
+  unsigned lastID_;
+  /// Table of the function accessed last.
+  Table *last_;
+};
@@ -0,0 +1,140 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/adt/dense_inst_map.h"
+#include "core/parser.h"
+#include "core/prog.h"
+
+
+
+namespace {
+
+/// Parses a function with a number of moves.
+std::unique_ptr<Prog> Build(unsigned n)
+{
+  std::string src = "\t.section .text\nf:\n";
+  for (unsigned i = 0; i < n; ++i) {
+    src += "\tmov.i64 $" + std::to_string(i) + ", " + std::to_string(i) + "\n";
+  }
+  src += "\tret\n";
+  return Parser(src, "test").Parse();
+}
+
+/// Returns the instructions of the first function.
+std::vector<Inst *> Insts(Prog &prog)
+{
+  std::vector<Inst *> insts;
+  for (Block &block : *prog.begin()) {
+    for (Inst &inst : block) {
+      insts.push_back(&inst);
+    }
+  }
+  return insts;
+}
+
+TEST(DenseInstMapTest, Insert) {
+  auto prog = Build(4);
+  auto insts = Insts(*prog);
+
+  DenseInstMap<int> map;
+  EXPECT_TRUE(map.Empty());
+  EXPECT_TRUE(map.Emplace(insts[0], 1).second);
+  EXPECT_FALSE(map.Emplace(insts[0], 2).second);
+  map[insts[2]] = 3;
+  EXPECT_EQ(2u, map.Size());
+  EXPECT_EQ(1, *map.Find(insts[0]));
+  EXPECT_EQ(nullptr, map.Find(insts[1]));
+  EXPECT_EQ(3, *map.Find(insts[2]));
+
+  EXPECT_TRUE(map.Erase(insts[0]));
+  EXPECT_FALSE(map.Erase(insts[0]));
+  EXPECT_FALSE(map.Contains(insts[0]));
+  EXPECT_EQ(1u, map.Size());
+}
+
+TEST(DenseInstMapTest, StaleSlot) {
+  auto prog = Build(4);
+  auto insts = Insts(*prog);
+
+  DenseInstMap<int> map;
+  map[insts[0]] = 1;
+
+  // Compaction moves the last instruction into the slot of the first.
+  for (unsigned i = 0; i < 4; ++i) {
+    insts[i]->eraseFromParent();
+  }
+  Func &func = *prog->begin();
+  func.CompactInsts();
+  Inst *ret = insts[4];
+  ASSERT_EQ(0u, ret->GetDenseIndex());
+
+  EXPECT_EQ(nullptr, map.Find(ret));
+  EXPECT_TRUE(map.Emplace(ret, 2).second);
+  EXPECT_EQ(2, *map.Find(ret));
+  EXPECT_EQ(1u, map.Size());
+}
+
+TEST(DenseInstMapTest, Detached) {
+  auto prog = Build(4);
+  auto insts = Insts(*prog);
+
+  DenseInstMap<int> map;
+  map[insts[1]] = 1;
+  map[insts[2]] = 2;
+
+  // Entries of detached instructions can still be found and erased.
+  insts[1]->removeFromParent();
+  EXPECT_EQ(1, *map.Find(insts[1]));
+  EXPECT_TRUE(map.Erase(insts[1]));
+  EXPECT_FALSE(map.Erase(insts[1]));
+  EXPECT_EQ(1u, map.Size());
+  delete insts[1];
+}
+
+TEST(DenseInstMapTest, Sparse) {
+  auto prog = Build(1000);
+  auto insts = Insts(*prog);
+
+  DenseInstMap<int> map;
+  map[insts[10]] = 10;
+  map[insts[999]] = 999;
+
+  // Entries are visited in index order, skipping empty chunks.
+  std::vector<int> values;
+  for (auto &[inst, value] : map) {
+    values.push_back(value);
+  }
+  EXPECT_EQ(std::vector<int>({ 10, 999 }), values);
+}
+
+TEST(DenseInstMapTest, CopyMove) {
+  auto prog = Build(4);
+  auto insts = Insts(*prog);
+
+  DenseInstMap<int> map;
+  map[insts[0]] = 1;
+  ASSERT_EQ(1, *map.Find(insts[0]));
+
+  DenseInstMap<int> copy(map);
+  copy[insts[0]] = 2;
+  EXPECT_EQ(1, *map.Find(insts[0]));
+  EXPECT_EQ(2, *copy.Find(insts[0]));
+
+  DenseInstMap<int> moved(std::move(map));
+  EXPECT_EQ(1, *moved.Find(insts[0]));
+  EXPECT_TRUE(map.Empty());
+  EXPECT_EQ(nullptr, map.Find(insts[0]));
+
+  copy = std::move(moved);
+  EXPECT_EQ(1, *copy.Find(insts[0]));
+  EXPECT_EQ(nullptr, moved.Find(insts[0]));
+}
+
+}
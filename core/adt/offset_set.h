@@ -0,0 +1,91 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+
+
+/**
+ * Set of [start, end) ranges of offsets into an object.
+ *
+ * Overlapping and adjacent ranges are coalesced, thus the set is a balanced
+ * tree of disjoint intervals, keyed by their start offsets. Insertion and
+ * lookup are logarithmic in the number of disjoint intervals, regardless of
+ * the number of accesses which were added.
+ */
+class OffsetSet final {
+private:
+  /// Mapping from the start of an interval to its end.
+  using RangeMap = std::map<int64_t, int64_t>;
+
+public:
+  /// Iterator over the (start, end) pairs of the intervals.
+  using iterator = RangeMap::const_iterator;
+
+public:
+  /// Checks whether the set is empty.
+  bool Empty() const { return ranges_.empty(); }
+  /// Returns the number of disjoint intervals.
+  size_t Size() const { return ranges_.size(); }
+
+  /// Adds an interval to the set.
+  void Insert(int64_t start, int64_t end)
+  {
+    assert(start < end && "invalid interval");
+
+    // Absorb the interval ending at or after the start.
+    auto it = ranges_.upper_bound(start);
+    if (it != ranges_.begin()) {
+      if (auto prev = std::prev(it); prev->second >= start) {
+        start = prev->first;
+        it = prev;
+      }
+    }
+    // Absorb the intervals starting before the end.
+    while (it != ranges_.end() && it->first <= end) {
+      end = std::max(end, it->second);
+      it = ranges_.erase(it);
+    }
+    ranges_.emplace_hint(it, start, end);
+  }
+
+  /// Adds all the intervals of another set.
+  void Union(const OffsetSet &that)
+  {
+    for (auto [start, end] : that.ranges_) {
+      Insert(start, end);
+    }
+  }
+
+  /// Checks whether an interval overlaps any interval of the set.
+  bool Overlaps(int64_t start, int64_t end) const
+  {
+    auto it = ranges_.lower_bound(end);
+    if (it == ranges_.begin()) {
+      return false;
+    }
+    return std::prev(it)->second > start;
+  }
+
+  /// Iterator to the first interval.
+  iterator begin() const { return ranges_.begin(); }
+  /// Iterator past the last interval.
+  iterator end() const { return ranges_.end(); }
+
+  /// Checks whether two sets are equal.
+  bool operator==(const OffsetSet &that) const
+  {
+    return ranges_ == that.ranges_;
+  }
+
+private:
+  /// Disjoint intervals, ordered by their start offsets.
+  RangeMap ranges_;
+};
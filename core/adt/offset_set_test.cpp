@@ -0,0 +1,75 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/adt/offset_set.h"
+
+
+
+namespace {
+
+using Ranges = std::vector<std::pair<int64_t, int64_t>>;
+
+Ranges Collect(const OffsetSet &set)
+{
+  return Ranges(set.begin(), set.end());
+}
+
+TEST(OffsetSetTest, Disjoint) {
+  OffsetSet set;
+  set.Insert(16, 24);
+  set.Insert(0, 8);
+  set.Insert(32, 40);
+  EXPECT_EQ(3u, set.Size());
+  EXPECT_EQ(Ranges({{0, 8}, {16, 24}, {32, 40}}), Collect(set));
+}
+
+TEST(OffsetSetTest, Coalesce) {
+  OffsetSet set;
+  set.Insert(0, 8);
+  set.Insert(8, 16);
+  set.Insert(24, 32);
+  set.Insert(28, 36);
+  set.Insert(0, 4);
+  EXPECT_EQ(Ranges({{0, 16}, {24, 36}}), Collect(set));
+
+  set.Insert(12, 26);
+  EXPECT_EQ(Ranges({{0, 36}}), Collect(set));
+}
+
+TEST(OffsetSetTest, Negative) {
+  OffsetSet set;
+  set.Insert(-8, 0);
+  set.Insert(-16, -12);
+  set.Insert(-12, -8);
+  EXPECT_EQ(Ranges({{-16, 0}}), Collect(set));
+}
+
+TEST(OffsetSetTest, Overlaps) {
+  OffsetSet set;
+  set.Insert(8, 16);
+  set.Insert(32, 40);
+  EXPECT_FALSE(set.Overlaps(0, 8));
+  EXPECT_TRUE(set.Overlaps(0, 9));
+  EXPECT_TRUE(set.Overlaps(15, 20));
+  EXPECT_FALSE(set.Overlaps(16, 32));
+  EXPECT_TRUE(set.Overlaps(20, 48));
+  EXPECT_FALSE(set.Overlaps(40, 48));
+}
+
+TEST(OffsetSetTest, Union) {
+  OffsetSet a;
+  a.Insert(0, 8);
+  a.Insert(32, 40);
+  OffsetSet b;
+  b.Insert(4, 12);
+  b.Insert(48, 56);
+  a.Union(b);
+  EXPECT_EQ(Ranges({{0, 12}, {32, 40}, {48, 56}}), Collect(a));
+}
+
+}
@@ -0,0 +1,149 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+
+#include <llvm/Support/ErrorHandling.h>
+
+#include "core/adt/slab.h"
+
+
+
+// -----------------------------------------------------------------------------
+namespace {
+
+/// Arena targeted by allocations on the current thread.
+thread_local SlabArena *kCurrent = nullptr;
+
+/// Returns the size class of an object.
+size_t GetClass(size_t size)
+{
+  constexpr size_t kGranularity = SlabAllocator::kGranularity;
+  return (size + kGranularity - 1) / kGranularity - 1;
+}
+
+/// Arena for objects allocated outside of functions, shared by all threads.
+struct SharedArena {
+  /// Lock guarding the arena.
+  std::mutex Lock;
+  /// Underlying arena.
+  SlabArena Arena;
+};
+
+/// Returns the shared arena, which is never freed.
+SharedArena &GetShared()
+{
+  static SharedArena *shared = new SharedArena();
+  return *shared;
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+void *SlabAllocator::Allocate(size_t size)
+{
+  if (size == 0 || size > kMaxSize) {
+    return malloc(size);
+  }
+  if (kCurrent) {
+    return kCurrent->Allocate(GetClass(size));
+  }
+  SharedArena &shared = GetShared();
+  std::lock_guard<std::mutex> guard(shared.Lock);
+  return shared.Arena.Allocate(GetClass(size));
+}
+
+// -----------------------------------------------------------------------------
+void SlabAllocator::Deallocate(void *ptr, size_t size)
+{
+  if (!ptr) {
+    return;
+  }
+  if (size == 0 || size > kMaxSize) {
+    free(ptr);
+    return;
+  }
+
+  // The owning arena is found through the header of the aligned page.
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(ptr) & ~(kPageSize - 1);
+  SlabArena *arena = reinterpret_cast<SlabArena::Page *>(addr)->Arena;
+  SharedArena &shared = GetShared();
+  if (arena == &shared.Arena) {
+    std::lock_guard<std::mutex> guard(shared.Lock);
+    arena->Deallocate(ptr, GetClass(size));
+  } else {
+    arena->Deallocate(ptr, GetClass(size));
+  }
+}
+
+// -----------------------------------------------------------------------------
+SlabArena::Scope::Scope(SlabArena *arena)
+  : prev_(kCurrent)
+{
+  kCurrent = arena;
+}
+
+// -----------------------------------------------------------------------------
+SlabArena::Scope::~Scope()
+{
+  kCurrent = prev_;
+}
+
+// -----------------------------------------------------------------------------
+SlabArena::SlabArena()
+  : free_{}
+  , pages_(nullptr)
+  , ptr_(nullptr)
+  , end_(nullptr)
+{
+}
+
+// -----------------------------------------------------------------------------
+SlabArena::~SlabArena()
+{
+  for (Page *page = pages_; page; ) {
+    Page *next = page->Next;
+    free(page);
+    page = next;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void *SlabArena::Allocate(size_t cls)
+{
+  // Recycle a free object.
+  if (Node *node = free_[cls]) {
+    free_[cls] = node->Next;
+    return node;
+  }
+
+  // Bump-allocate from the current page, starting a new one if it is full.
+  // The space left over at the end of a page is abandoned.
+  const size_t rounded = (cls + 1) * SlabAllocator::kGranularity;
+  if (ptr_ + rounded > end_) {
+    constexpr size_t kPageSize = SlabAllocator::kPageSize;
+    Page *page = static_cast<Page *>(aligned_alloc(kPageSize, kPageSize));
+    if (!page) {
+      llvm::report_bad_alloc_error("cannot allocate slab page");
+    }
+    page->Arena = this;
+    page->Next = pages_;
+    pages_ = page;
+    ptr_ = reinterpret_cast<char *>(page + 1);
+    end_ = reinterpret_cast<char *>(page) + kPageSize;
+  }
+  void *ptr = ptr_;
+  ptr_ += rounded;
+  return ptr;
+}
+
+// -----------------------------------------------------------------------------
+void SlabArena::Deallocate(void *ptr, size_t cls)
+{
+  Node *node = static_cast<Node *>(ptr);
+  node->Next = free_[cls];
+  free_[cls] = node;
+}
@@ -0,0 +1,96 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+
+
+
+class SlabArena;
+
+/**
+ * Size-class slab allocator for small, frequently recycled IR objects.
+ *
+ * Objects are bump-allocated from the pages of the arena which is active on
+ * the current thread, or from a shared arena if none is. Functions own
+ * arenas: the objects built for a function are adjacent in memory and their
+ * pages are returned in bulk once the function is deleted. Freed objects are
+ * recycled through the size-class free lists of the arena they came from.
+ */
+class SlabAllocator final {
+public:
+  /// Granularity of size classes.
+  static constexpr size_t kGranularity = 16;
+  /// Largest size served from slabs, larger objects use malloc.
+  static constexpr size_t kMaxSize = 512;
+  /// Number of size classes.
+  static constexpr size_t kNumClasses = kMaxSize / kGranularity;
+  /// Size and alignment of the pages objects are carved from.
+  static constexpr size_t kPageSize = 4096;
+
+  /// Allocates an object of a given size.
+  static void *Allocate(size_t size);
+  /// Frees an object, given its size.
+  static void Deallocate(void *ptr, size_t size);
+};
+
+/**
+ * Set of pages owned by a function.
+ *
+ * Pages are allocated on first use and are all freed along with the arena.
+ * A function is only ever modified by a single thread at a time, thus the
+ * arenas of functions are not locked. The shared arena, which serves the
+ * allocations made outside of function scopes, is guarded by a lock.
+ */
+class SlabArena final {
+public:
+  /// Directs the allocations of the current thread to an arena.
+  class Scope final {
+  public:
+    Scope(SlabArena *arena);
+    ~Scope();
+
+  private:
+    /// Arena active before the scope was entered.
+    SlabArena *prev_;
+  };
+
+public:
+  /// Creates an empty arena.
+  SlabArena();
+  /// Frees all the pages, along with the objects still in them.
+  ~SlabArena();
+
+private:
+  friend class SlabAllocator;
+
+  /// Node of a free list, stored in the freed object.
+  struct Node {
+    Node *Next;
+  };
+
+  /// Header at the start of each page.
+  struct alignas(SlabAllocator::kGranularity) Page {
+    /// Arena the page belongs to.
+    SlabArena *Arena;
+    /// Next page of the arena.
+    Page *Next;
+  };
+
+  /// Allocates an object of a size class.
+  void *Allocate(size_t cls);
+  /// Frees an object of a size class.
+  void Deallocate(void *ptr, size_t cls);
+
+private:
+  /// Free lists for each size class.
+  Node *free_[SlabAllocator::kNumClasses];
+  /// List of pages.
+  Page *pages_;
+  /// Start of the free space in the current page.
+  char *ptr_;
+  /// End of the current page.
+  char *end_;
+};
@@ -0,0 +1,122 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/adt/slab.h"
+
+
+
+namespace {
+
+TEST(SlabAllocatorTest, RecyclesSameClass) {
+  void *a = SlabAllocator::Allocate(40);
+  SlabAllocator::Deallocate(a, 40);
+  void *b = SlabAllocator::Allocate(48);
+  EXPECT_EQ(a, b);
+  SlabAllocator::Deallocate(b, 48);
+}
+
+TEST(SlabAllocatorTest, Alignment) {
+  std::vector<std::pair<void *, size_t>> ptrs;
+  for (size_t size = 1; size <= SlabAllocator::kMaxSize; size += 7) {
+    void *ptr = SlabAllocator::Allocate(size);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % 16);
+    memset(ptr, 0xFF, size);
+    ptrs.emplace_back(ptr, size);
+  }
+  for (auto [ptr, size] : ptrs) {
+    SlabAllocator::Deallocate(ptr, size);
+  }
+}
+
+TEST(SlabAllocatorTest, Contiguous) {
+  // Fresh arenas start with an empty page.
+  SlabArena arena;
+  SlabArena::Scope scope(&arena);
+  void *a = SlabAllocator::Allocate(272);
+  void *b = SlabAllocator::Allocate(272);
+  EXPECT_EQ(static_cast<char *>(a) + 272, static_cast<char *>(b));
+  SlabAllocator::Deallocate(a, 272);
+  SlabAllocator::Deallocate(b, 272);
+}
+
+TEST(SlabAllocatorTest, Large) {
+  void *ptr = SlabAllocator::Allocate(SlabAllocator::kMaxSize + 1);
+  memset(ptr, 0, SlabAllocator::kMaxSize + 1);
+  SlabAllocator::Deallocate(ptr, SlabAllocator::kMaxSize + 1);
+}
+
+TEST(SlabAllocatorTest, CrossThread) {
+  std::vector<void *> ptrs;
+  for (unsigned i = 0; i < 1000; ++i) {
+    ptrs.push_back(SlabAllocator::Allocate(96));
+  }
+  std::thread([&] {
+    for (void *ptr : ptrs) {
+      SlabAllocator::Deallocate(ptr, 96);
+    }
+  }).join();
+
+  // Objects freed by the exited thread are recycled.
+  std::vector<void *> reused;
+  for (unsigned i = 0; i < 1000; ++i) {
+    reused.push_back(SlabAllocator::Allocate(96));
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  std::sort(reused.begin(), reused.end());
+  EXPECT_EQ(ptrs, reused);
+  for (void *ptr : reused) {
+    SlabAllocator::Deallocate(ptr, 96);
+  }
+}
+
+TEST(SlabAllocatorTest, ReturnsToOwner) {
+  SlabArena a, b;
+
+  // Objects are recycled by the arena they were allocated from.
+  void *ptr;
+  {
+    SlabArena::Scope scope(&a);
+    ptr = SlabAllocator::Allocate(64);
+  }
+  {
+    SlabArena::Scope scope(&b);
+    SlabAllocator::Deallocate(ptr, 64);
+    void *other = SlabAllocator::Allocate(64);
+    EXPECT_NE(ptr, other);
+    SlabAllocator::Deallocate(other, 64);
+  }
+  {
+    SlabArena::Scope scope(&a);
+    EXPECT_EQ(ptr, SlabAllocator::Allocate(64));
+    SlabAllocator::Deallocate(ptr, 64);
+  }
+}
+
+TEST(SlabAllocatorTest, FreedWithArena) {
+  // Objects left in an arena are released along with its pages.
+  auto arena = std::make_unique<SlabArena>();
+  {
+    SlabArena::Scope scope(arena.get());
+    for (unsigned i = 0; i < 1000; ++i) {
+      memset(SlabAllocator::Allocate(128), 0xFF, 128);
+    }
+  }
+  arena.reset();
+
+  // Allocations outside of the scope are not affected.
+  void *ptr = SlabAllocator::Allocate(128);
+  memset(ptr, 0xFF, 128);
+  SlabAllocator::Deallocate(ptr, 128);
+}
+
+}
@@ -0,0 +1,162 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <cstring>
+#include <limits>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/xxhash.h>
+
+#include "core/adt/string_interner.h"
+
+
+
+// -----------------------------------------------------------------------------
+StringInterner::Table::Table(size_t size)
+  : Mask(size - 1)
+  , Buckets(new std::atomic<Handle>[size])
+{
+  for (size_t i = 0; i < size; ++i) {
+    Buckets[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+// -----------------------------------------------------------------------------
+StringInterner::StringInterner()
+  : size_(0)
+{
+  for (unsigned i = 0; i < kNumSegments; ++i) {
+    segments_[i].store(nullptr, std::memory_order_relaxed);
+  }
+  tables_.push_back(std::make_unique<Table>(1 << kFirstBits));
+  table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+StringInterner::~StringInterner()
+{
+  for (unsigned i = 0; i < kNumSegments; ++i) {
+    delete[] segments_[i].load(std::memory_order_relaxed);
+  }
+}
+
+// -----------------------------------------------------------------------------
+uint32_t StringInterner::Hash(std::string_view str)
+{
+  return llvm::xxHash64(llvm::StringRef(str.data(), str.size()));
+}
+
+// -----------------------------------------------------------------------------
+size_t StringInterner::Probe(
+    const Table &table,
+    std::string_view str,
+    uint32_t hash) const
+{
+  // Buckets are published after their entries, with release semantics.
+  for (size_t i = hash & table.Mask; ; i = (i + 1) & table.Mask) {
+    const Handle bucket = table.Buckets[i].load(std::memory_order_acquire);
+    if (bucket == 0) {
+      return i;
+    }
+    const Entry &entry = GetEntry(bucket - 1);
+    if (entry.Hash == hash && Get(bucket - 1) == str) {
+      return i;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void StringInterner::Grow()
+{
+  const Table &table = *tables_.back();
+  auto grown = std::make_unique<Table>((table.Mask + 1) * 2);
+  for (size_t i = 0; i <= table.Mask; ++i) {
+    const Handle bucket = table.Buckets[i].load(std::memory_order_relaxed);
+    if (bucket == 0) {
+      continue;
+    }
+    size_t j = GetEntry(bucket - 1).Hash & grown->Mask;
+    while (grown->Buckets[j].load(std::memory_order_relaxed) != 0) {
+      j = (j + 1) & grown->Mask;
+    }
+    grown->Buckets[j].store(bucket, std::memory_order_relaxed);
+  }
+
+  // Readers probing the old table still find all strings interned so far.
+  table_.store(grown.get(), std::memory_order_release);
+  tables_.push_back(std::move(grown));
+}
+
+// -----------------------------------------------------------------------------
+StringInterner::Handle StringInterner::Intern(std::string_view str)
+{
+  const uint32_t hash = Hash(str);
+
+  // Most strings are already interned: try to find them without locking.
+  {
+    const Table &table = *table_.load(std::memory_order_acquire);
+    const Handle bucket = table.Buckets[Probe(table, str, hash)].load(
+        std::memory_order_acquire
+    );
+    if (bucket != 0) {
+      return bucket - 1;
+    }
+  }
+
+  // Look again under the lock, as the string might have been added since.
+  std::lock_guard<std::mutex> guard(lock_);
+  Table &table = *tables_.back();
+  const size_t bucket = Probe(table, str, hash);
+  if (const Handle h = table.Buckets[bucket].load(std::memory_order_relaxed)) {
+    return h - 1;
+  }
+
+  // Find the segment holding the new entry, allocating it if needed.
+  const size_t n = size_.load(std::memory_order_relaxed);
+  if (n >= std::numeric_limits<Handle>::max() - (1u << kFirstBits)) {
+    llvm::report_fatal_error("too many interned strings");
+  }
+  const uint64_t v = static_cast<uint64_t>(n) + (1ull << kFirstBits);
+  const unsigned msb = 63 - __builtin_clzll(v);
+  const unsigned segment = msb - kFirstBits;
+  Entry *entries = segments_[segment].load(std::memory_order_relaxed);
+  if (!entries) {
+    entries = new Entry[1ull << msb];
+    segments_[segment].store(entries, std::memory_order_release);
+  }
+
+  // Copy the string and record it.
+  char *data = alloc_.Allocate<char>(str.size() + 1);
+  std::memcpy(data, str.data(), str.size());
+  data[str.size()] = '\0';
+  Entry &entry = entries[v - (1ull << msb)];
+  entry.Data = data;
+  entry.Size = str.size();
+  entry.Hash = hash;
+  size_.store(n + 1, std::memory_order_release);
+
+  // Publish the handle, keeping the load factor below one half.
+  const Handle handle = n;
+  table.Buckets[bucket].store(handle + 1, std::memory_order_release);
+  if ((n + 1) * 2 > table.Mask + 1) {
+    Grow();
+  }
+  return handle;
+}
+
+// -----------------------------------------------------------------------------
+std::optional<StringInterner::Handle>
+StringInterner::Find(std::string_view str) const
+{
+  const uint32_t hash = Hash(str);
+  const Table &table = *table_.load(std::memory_order_acquire);
+  const Handle bucket = table.Buckets[Probe(table, str, hash)].load(
+      std::memory_order_acquire
+  );
+  if (bucket == 0) {
+    return std::nullopt;
+  }
+  return bucket - 1;
+}
@@ -0,0 +1,118 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <llvm/Support/Allocator.h>
+
+
+
+/**
+ * Thread-safe table of unique strings, identified by 32-bit handles.
+ *
+ * Strings are hashed once, when interned, and are never released: the
+ * views returned for a handle remain valid for the lifetime of the table.
+ * Handles are dense and are resolved to strings without locking, through
+ * a segmented array whose segments never move once allocated.
+ *
+ * Lookups do not lock either: since strings are never removed, a bucket
+ * which was set is never cleared, thus readers can probe the hash table
+ * concurrently with insertions. Insertions are serialised by a lock and
+ * publish a new hash table when growing; old tables are retained until the
+ * interner is destroyed, as readers might still be probing them.
+ */
+class StringInterner final {
+public:
+  /// Type of handles identifying strings.
+  using Handle = uint32_t;
+
+public:
+  /// Creates an empty table.
+  StringInterner();
+  /// Frees all strings.
+  ~StringInterner();
+
+  /// Returns the handle of a string, adding it if missing.
+  Handle Intern(std::string_view str);
+  /// Returns the handle of a string, if it was interned.
+  std::optional<Handle> Find(std::string_view str) const;
+
+  /// Returns the string identified by a handle.
+  std::string_view Get(Handle handle) const
+  {
+    const Entry &entry = GetEntry(handle);
+    return std::string_view(entry.Data, entry.Size);
+  }
+  /// Returns the hash of the string identified by a handle.
+  uint32_t GetHash(Handle handle) const { return GetEntry(handle).Hash; }
+
+  /// Returns the number of interned strings.
+  size_t Size() const { return size_.load(std::memory_order_acquire); }
+
+private:
+  /// Interned string.
+  struct Entry {
+    /// Pointer to the characters.
+    const char *Data;
+    /// Length of the string.
+    uint32_t Size;
+    /// Hash of the string.
+    uint32_t Hash;
+  };
+
+  /// Log2 of the number of entries in the first segment.
+  static constexpr unsigned kFirstBits = 10;
+  /// Maximal number of segments, each twice as large as the previous one.
+  static constexpr unsigned kNumSegments = 32 - kFirstBits;
+
+  /// Returns the entry of a handle.
+  const Entry &GetEntry(Handle handle) const
+  {
+    const uint64_t v = static_cast<uint64_t>(handle) + (1ull << kFirstBits);
+    const unsigned msb = 63 - __builtin_clzll(v);
+    const unsigned segment = msb - kFirstBits;
+    const Entry *entries = segments_[segment].load(std::memory_order_acquire);
+    return entries[v - (1ull << msb)];
+  }
+
+  /// Open-addressing hash table of handles, offset by one to mark empty.
+  struct Table {
+    /// Mask to map hashes to buckets.
+    size_t Mask;
+    /// Buckets, set once.
+    std::unique_ptr<std::atomic<Handle>[]> Buckets;
+
+    /// Creates an empty table with a number of buckets.
+    Table(size_t size);
+  };
+
+  /// Hashes a string.
+  static uint32_t Hash(std::string_view str);
+  /// Finds the bucket of a string, or the empty bucket to insert it into.
+  size_t Probe(const Table &table, std::string_view str, uint32_t hash) const;
+  /// Doubles the size of the hash table.
+  void Grow();
+
+private:
+  /// Lock serialising insertions.
+  std::mutex lock_;
+  /// Storage for the characters.
+  llvm::BumpPtrAllocator alloc_;
+  /// Segments of the entry array.
+  std::atomic<Entry *> segments_[kNumSegments];
+  /// Number of interned strings.
+  std::atomic<size_t> size_;
+  /// Current hash table.
+  std::atomic<Table *> table_;
+  /// All hash tables allocated so far.
+  std::vector<std::unique_ptr<Table>> tables_;
+};
@@ -0,0 +1,110 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/adt/string_interner.h"
+
+
+
+namespace {
+
+TEST(StringInternerTest, Unique) {
+  StringInterner interner;
+  auto a = interner.Intern("caml_main");
+  auto b = interner.Intern("caml_start");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, interner.Intern(std::string("caml_") + "main"));
+  EXPECT_EQ("caml_main", interner.Get(a));
+  EXPECT_EQ("caml_start", interner.Get(b));
+  EXPECT_EQ(2u, interner.Size());
+}
+
+TEST(StringInternerTest, Find) {
+  StringInterner interner;
+  EXPECT_FALSE(interner.Find("main"));
+  auto h = interner.Intern("main");
+  EXPECT_EQ(h, interner.Find("main"));
+  EXPECT_FALSE(interner.Find("mai"));
+  EXPECT_EQ(1u, interner.Size());
+}
+
+TEST(StringInternerTest, Empty) {
+  StringInterner interner;
+  auto h = interner.Intern("");
+  EXPECT_EQ("", interner.Get(h));
+  EXPECT_EQ(h, interner.Intern(""));
+}
+
+TEST(StringInternerTest, ManySegments) {
+  StringInterner interner;
+  std::vector<StringInterner::Handle> handles;
+  for (unsigned i = 0; i < 100000; ++i) {
+    handles.push_back(interner.Intern(".L" + std::to_string(i)));
+  }
+  for (unsigned i = 0; i < 100000; ++i) {
+    EXPECT_EQ(i, handles[i]);
+    EXPECT_EQ(".L" + std::to_string(i), interner.Get(handles[i]));
+  }
+}
+
+TEST(StringInternerTest, Concurrent) {
+  StringInterner interner;
+  std::vector<std::vector<StringInterner::Handle>> handles(4);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < handles.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (unsigned i = 0; i < 10000; ++i) {
+        auto h = interner.Intern("sym" + std::to_string(i));
+        EXPECT_EQ("sym" + std::to_string(i), interner.Get(h));
+        handles[t].push_back(h);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (unsigned t = 1; t < handles.size(); ++t) {
+    EXPECT_EQ(handles[0], handles[t]);
+  }
+  EXPECT_EQ(10000u, interner.Size());
+}
+
+TEST(StringInternerTest, FindWhileGrowing) {
+  StringInterner interner;
+  std::atomic<unsigned> published(0);
+  std::thread writer([&] {
+    for (unsigned i = 0; i < 50000; ++i) {
+      interner.Intern("sym" + std::to_string(i));
+      published.store(i + 1, std::memory_order_release);
+    }
+  });
+
+  // Strings interned before a lookup starts must be found, even if the
+  // hash table is being replaced concurrently.
+  std::vector<std::thread> readers;
+  for (unsigned t = 0; t < 3; ++t) {
+    readers.emplace_back([&, t] {
+      unsigned n;
+      while ((n = published.load(std::memory_order_acquire)) < 50000) {
+        for (unsigned i = t; i < n; i += 97) {
+          auto h = interner.Find("sym" + std::to_string(i));
+          ASSERT_TRUE(h);
+          EXPECT_EQ(i, *h);
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+}
@@ -0,0 +1,208 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/iterator.h>
+
+
+
+/**
+ * Open-addressing map from 32-bit symbol handles to objects.
+ *
+ * Handles are unique integers, thus they are hashed by a single multiply
+ * instead of re-hashing strings. Buckets are probed linearly and erased
+ * entries leave tombstones, which are dropped when the table is rebuilt.
+ */
+template <typename T>
+class SymbolMap final {
+public:
+  /// Type of keys.
+  using Handle = uint32_t;
+
+private:
+  /// Marker for empty buckets.
+  static constexpr Handle kEmpty = ~Handle(0);
+  /// Marker for erased buckets.
+  static constexpr Handle kTombstone = ~Handle(0) - 1;
+
+  /// Hash table bucket.
+  struct Bucket {
+    /// Handle of the key.
+    Handle Key;
+    /// Mapped object.
+    T *Value;
+  };
+
+  /// Iterator over the mapped objects.
+  template <typename U, typename It>
+  class iterator_impl : public llvm::iterator_facade_base
+      < iterator_impl<U, It>
+      , std::forward_iterator_tag
+      , U *
+      , ptrdiff_t
+      , U **
+      , U *
+      >
+  {
+  public:
+    iterator_impl(It it, It end) : it_(it), end_(end) { Skip(); }
+
+    bool operator==(const iterator_impl &that) const
+    {
+      return it_ == that.it_;
+    }
+
+    U *operator*() const { return it_->Value; }
+
+    iterator_impl &operator++()
+    {
+      ++it_;
+      Skip();
+      return *this;
+    }
+
+  private:
+    /// Skips over empty buckets and tombstones.
+    void Skip()
+    {
+      while (it_ != end_ && (it_->Key == kEmpty || it_->Key == kTombstone)) {
+        ++it_;
+      }
+    }
+
+  private:
+    /// Current bucket.
+    It it_;
+    /// End of the buckets.
+    It end_;
+  };
+
+public:
+  /// Iterators over the mapped objects.
+  using iterator = iterator_impl
+      < T
+      , typename std::vector<Bucket>::iterator
+      >;
+  using const_iterator = iterator_impl
+      < const T
+      , typename std::vector<Bucket>::const_iterator
+      >;
+
+public:
+  /// Creates an empty map.
+  SymbolMap() : buckets_(16, Bucket{ kEmpty, nullptr }), size_(0), used_(0) {}
+
+  /// Finds the object mapped to a handle.
+  T *Find(Handle key) const
+  {
+    const Bucket &bucket = buckets_[Probe(key)];
+    return bucket.Key == key ? bucket.Value : nullptr;
+  }
+
+  /**
+   * Maps a handle to an object.
+   *
+   * @return The previously mapped object and false if the key exists.
+   */
+  std::pair<T *, bool> Insert(Handle key, T *value)
+  {
+    size_t i = Probe(key);
+    if (buckets_[i].Key == key) {
+      return { buckets_[i].Value, false };
+    }
+    // Reuse the first tombstone along the probe sequence, if any.
+    const size_t mask = buckets_.size() - 1;
+    for (size_t j = Hash(key) & mask; j != i; j = (j + 1) & mask) {
+      if (buckets_[j].Key == kTombstone) {
+        i = j;
+        --used_;
+        break;
+      }
+    }
+    buckets_[i] = Bucket{ key, value };
+    ++size_;
+    ++used_;
+    if (used_ * 4 > buckets_.size() * 3) {
+      // Grow if mostly full of objects, otherwise only drop tombstones.
+      const size_t n = buckets_.size();
+      Rehash(size_ * 2 > n ? n * 2 : n);
+    }
+    return { value, true };
+  }
+
+  /// Erases a key, returning true if it was present.
+  bool Erase(Handle key)
+  {
+    Bucket &bucket = buckets_[Probe(key)];
+    if (bucket.Key != key) {
+      return false;
+    }
+    bucket = Bucket{ kTombstone, nullptr };
+    --size_;
+    return true;
+  }
+
+  /// Returns the number of mapped objects.
+  size_t Size() const { return size_; }
+  /// Checks if the map is empty.
+  bool Empty() const { return size_ == 0; }
+
+  // Iterators over the objects, in no particular order.
+  iterator begin() { return iterator(buckets_.begin(), buckets_.end()); }
+  iterator end() { return iterator(buckets_.end(), buckets_.end()); }
+  const_iterator begin() const
+  {
+    return const_iterator(buckets_.begin(), buckets_.end());
+  }
+  const_iterator end() const
+  {
+    return const_iterator(buckets_.end(), buckets_.end());
+  }
+
+private:
+  /// Hashes a handle.
+  static size_t Hash(Handle key)
+  {
+    return (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 32;
+  }
+
+  /// Finds the bucket of a key or the empty bucket ending its probe sequence.
+  size_t Probe(Handle key) const
+  {
+    const size_t mask = buckets_.size() - 1;
+    for (size_t i = Hash(key) & mask; ; i = (i + 1) & mask) {
+      const Handle k = buckets_[i].Key;
+      if (k == key || k == kEmpty) {
+        return i;
+      }
+    }
+  }
+
+  /// Rebuilds the table with a given number of buckets.
+  void Rehash(size_t n)
+  {
+    std::vector<Bucket> buckets(n, Bucket{ kEmpty, nullptr });
+    std::swap(buckets, buckets_);
+    used_ = size_;
+    for (const Bucket &bucket : buckets) {
+      if (bucket.Key != kEmpty && bucket.Key != kTombstone) {
+        buckets_[Probe(bucket.Key)] = bucket;
+      }
+    }
+  }
+
+private:
+  /// Hash table buckets, the number being a power of two.
+  std::vector<Bucket> buckets_;
+  /// Number of mapped objects.
+  size_t size_;
+  /// Number of buckets holding objects or tombstones.
+  size_t used_;
+};
@@ -0,0 +1,77 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/adt/symbol_map.h"
+
+
+
+namespace {
+
+TEST(SymbolMapTest, InsertFind) {
+  int a, b;
+  SymbolMap<int> map;
+  EXPECT_TRUE(map.Insert(1, &a).second);
+  EXPECT_TRUE(map.Insert(2, &b).second);
+  auto it = map.Insert(1, &b);
+  EXPECT_FALSE(it.second);
+  EXPECT_EQ(&a, it.first);
+  EXPECT_EQ(&a, map.Find(1));
+  EXPECT_EQ(&b, map.Find(2));
+  EXPECT_EQ(nullptr, map.Find(3));
+  EXPECT_EQ(2u, map.Size());
+}
+
+TEST(SymbolMapTest, Erase) {
+  int a;
+  SymbolMap<int> map;
+  map.Insert(7, &a);
+  EXPECT_TRUE(map.Erase(7));
+  EXPECT_FALSE(map.Erase(7));
+  EXPECT_EQ(nullptr, map.Find(7));
+  EXPECT_TRUE(map.Empty());
+  EXPECT_TRUE(map.Insert(7, &a).second);
+  EXPECT_EQ(&a, map.Find(7));
+}
+
+TEST(SymbolMapTest, Churn) {
+  std::vector<int> values(10000);
+  SymbolMap<int> map;
+  for (unsigned round = 0; round < 4; ++round) {
+    for (unsigned i = 0; i < values.size(); ++i) {
+      EXPECT_TRUE(map.Insert(i, &values[i]).second);
+    }
+    for (unsigned i = 0; i < values.size(); i += 2) {
+      EXPECT_TRUE(map.Erase(i));
+    }
+    for (unsigned i = 0; i < values.size(); ++i) {
+      EXPECT_EQ(i % 2 ? &values[i] : nullptr, map.Find(i));
+    }
+    for (unsigned i = 1; i < values.size(); i += 2) {
+      EXPECT_TRUE(map.Erase(i));
+    }
+    EXPECT_TRUE(map.Empty());
+  }
+}
+
+TEST(SymbolMapTest, Iterate) {
+  std::vector<int> values(100);
+  SymbolMap<int> map;
+  for (unsigned i = 0; i < values.size(); ++i) {
+    map.Insert(i * 3, &values[i]);
+  }
+  map.Erase(0);
+  std::set<int *> seen;
+  for (int *value : map) {
+    EXPECT_TRUE(seen.insert(value).second);
+  }
+  EXPECT_EQ(99u, seen.size());
+  EXPECT_FALSE(seen.count(&values[0]));
+}
+
+}
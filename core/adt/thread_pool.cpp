@@ -0,0 +1,137 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <algorithm>
+#include <cassert>
+
+#include "core/adt/thread_pool.h"
+
+
+
+// -----------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned numThreads)
+  : job_(nullptr)
+  , epoch_(0)
+  , pending_(0)
+  , stop_(false)
+{
+  numThreads = std::max(1u, numThreads);
+  for (unsigned i = 0; i < numThreads; ++i) {
+    queues_.emplace_back(std::make_unique<Queue>());
+  }
+  for (unsigned i = 1; i < numThreads; ++i) {
+    threads_.emplace_back([this, i] { Work(i); });
+  }
+}
+
+// -----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void ThreadPool::ParallelFor(size_t n, const std::function<void(size_t)> &f)
+{
+  if (n == 0) {
+    return;
+  }
+
+  // Without helper threads, run everything inline.
+  if (threads_.empty() || n == 1) {
+    for (size_t i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+
+  // Seed the queues with contiguous ranges of indices.
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    assert(pending_ == 0 && "batch already in progress");
+    job_ = &f;
+    pending_ = n;
+    const size_t numQueues = queues_.size();
+    for (size_t q = 0; q < numQueues; ++q) {
+      std::lock_guard<std::mutex> queueGuard(queues_[q]->Lock);
+      for (size_t i = q * n / numQueues; i < (q + 1) * n / numQueues; ++i) {
+        queues_[q]->Items.push_back(i);
+      }
+    }
+    ++epoch_;
+  }
+  wake_.notify_all();
+
+  // Participate in the batch, then wait for stragglers.
+  Drain(0);
+  {
+    std::unique_lock<std::mutex> guard(lock_);
+    done_.wait(guard, [this] { return pending_ == 0; });
+    job_ = nullptr;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void ThreadPool::Work(unsigned id)
+{
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> guard(lock_);
+      wake_.wait(guard, [this, seen] { return stop_ || epoch_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = epoch_;
+    }
+    Drain(id);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void ThreadPool::Drain(unsigned id)
+{
+  while (auto item = Take(id)) {
+    (*job_)(*item);
+    if (--pending_ == 0) {
+      std::lock_guard<std::mutex> guard(lock_);
+      done_.notify_all();
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::optional<size_t> ThreadPool::Take(unsigned id)
+{
+  // Pop from the back of the thread's own queue.
+  {
+    Queue &own = *queues_[id];
+    std::lock_guard<std::mutex> guard(own.Lock);
+    if (!own.Items.empty()) {
+      size_t item = own.Items.back();
+      own.Items.pop_back();
+      return item;
+    }
+  }
+
+  // Steal from the front of the other queues.
+  const unsigned n = queues_.size();
+  for (unsigned i = 1; i < n; ++i) {
+    Queue &victim = *queues_[(id + i) % n];
+    std::lock_guard<std::mutex> guard(victim.Lock);
+    if (!victim.Items.empty()) {
+      size_t item = victim.Items.front();
+      victim.Items.pop_front();
+      return item;
+    }
+  }
+  return std::nullopt;
+}
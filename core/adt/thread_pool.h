@@ -0,0 +1,76 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+
+/**
+ * Work-stealing thread pool.
+ *
+ * The pool runs batches of independent jobs, identified by their index.
+ * Each worker owns a queue which is seeded with a contiguous range of
+ * indices: workers pop from the back of their own queue and steal from
+ * the front of other queues once they run out of work. The calling thread
+ * participates in the execution of the batch as the first worker.
+ */
+class ThreadPool final {
+public:
+  /// Creates a pool with a given number of threads, including the caller.
+  ThreadPool(unsigned numThreads);
+  /// Joins all the worker threads.
+  ~ThreadPool();
+
+  /// Returns the number of threads executing jobs.
+  unsigned size() const { return queues_.size(); }
+
+  /// Runs a function for all indices in [0, n), blocking until all finish.
+  void ParallelFor(size_t n, const std::function<void(size_t)> &f);
+
+private:
+  /// Per-thread queue of job indices.
+  struct Queue {
+    /// Lock protecting the queue.
+    std::mutex Lock;
+    /// Indices of pending jobs.
+    std::deque<size_t> Items;
+  };
+
+  /// Entry point of worker threads.
+  void Work(unsigned id);
+  /// Runs jobs until no more can be found.
+  void Drain(unsigned id);
+  /// Takes a job from the thread's own queue or steals one.
+  std::optional<size_t> Take(unsigned id);
+
+private:
+  /// Queues for each thread.
+  std::vector<std::unique_ptr<Queue>> queues_;
+  /// Worker threads.
+  std::vector<std::thread> threads_;
+  /// Lock protecting the batch state.
+  std::mutex lock_;
+  /// Signals the availability of a new batch.
+  std::condition_variable wake_;
+  /// Signals the completion of the current batch.
+  std::condition_variable done_;
+  /// Job executed by the current batch.
+  const std::function<void(size_t)> *job_;
+  /// Identifier of the current batch.
+  uint64_t epoch_;
+  /// Number of jobs which did not finish yet.
+  std::atomic<size_t> pending_;
+  /// Flag to indicate that workers should exit.
+  bool stop_;
+};
@@ -0,0 +1,63 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "core/adt/thread_pool.h"
+
+
+
+namespace {
+
+TEST(ThreadPoolTest, RunsAllJobs) {
+  ThreadPool pool(4);
+  std::vector<unsigned> hits(1000, 0);
+  pool.ParallelFor(hits.size(), [&](size_t i) { hits[i]++; });
+  for (unsigned hit : hits) {
+    EXPECT_EQ(1u, hit);
+  }
+}
+
+TEST(ThreadPoolTest, RepeatedBatches) {
+  ThreadPool pool(8);
+  std::atomic<size_t> sum(0);
+  for (size_t n = 0; n < 100; ++n) {
+    pool.ParallelFor(n, [&](size_t i) { sum += i; });
+  }
+  size_t expected = 0;
+  for (size_t n = 0; n < 100; ++n) {
+    expected += n * (n - 1) / 2;
+  }
+  EXPECT_EQ(expected, sum.load());
+}
+
+TEST(ThreadPoolTest, Unbalanced) {
+  ThreadPool pool(4);
+  std::vector<uint64_t> results(64, 0);
+  pool.ParallelFor(results.size(), [&](size_t i) {
+    uint64_t v = 0;
+    for (size_t j = 0; j < (i < 4 ? 1000000 : 10); ++j) {
+      v += j ^ i;
+    }
+    results[i] = v;
+  });
+  for (size_t i = 0; i < results.size(); ++i) {
+    uint64_t v = 0;
+    for (size_t j = 0; j < (i < 4 ? 1000000 : 10); ++j) {
+      v += j ^ i;
+    }
+    EXPECT_EQ(v, results[i]);
+  }
+}
+
+TEST(ThreadPoolTest, SingleThread) {
+  ThreadPool pool(1);
+  std::vector<size_t> order;
+  pool.ParallelFor(10, [&](size_t i) { order.push_back(i); });
+  for (size_t i = 0; i < order.size(); ++i) {
+    EXPECT_EQ(i, order[i]);
+  }
+}
+
+}
@@ -11,3 +11,13 @@ Analysis::Analysis(PassManager *passManager)
   : Pass(passManager)
 {
 }
+
+// -----------------------------------------------------------------------------
+FuncAnalysis::~FuncAnalysis()
+{
+}
+
+// -----------------------------------------------------------------------------
+ProgAnalysis::~ProgAnalysis()
+{
+}
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <llvm/ADT/SmallPtrSet.h>
+
 #include "core/pass.h"
 
 
@@ -21,3 +23,71 @@ public:
   /// Base class of analyses.
   Analysis(PassManager *passManager);
 };
+
+
+/**
+ * Base class for analysis results computed for individual functions.
+ *
+ * Function analyses are built on demand by the pass manager and are cached
+ * until a transformation which does not preserve them changes the function.
+ */
+class FuncAnalysis {
+public:
+  /// Cleans up the analysis result.
+  virtual ~FuncAnalysis();
+
+  /// Checks whether the result is consistent with the function.
+  virtual bool Verify() { return true; }
+};
+
+
+/**
+ * Base class for analysis results computed for an entire program.
+ *
+ * Program analyses are built on demand by the pass manager and are cached
+ * until a transformation which does not preserve them changes the program.
+ * Transformations which preserve them must keep them up to date.
+ */
+class ProgAnalysis {
+public:
+  /// Cleans up the analysis result.
+  virtual ~ProgAnalysis();
+
+  /// Checks whether the result is consistent with the program.
+  virtual bool Verify() { return true; }
+};
+
+
+/**
+ * Set of analyses which remain valid after a transformation.
+ */
+class PreservedAnalyses final {
+public:
+  /// Creates a set which preserves no analyses.
+  PreservedAnalyses() : all_(false) {}
+
+  /// Returns a set which preserves all analyses.
+  static PreservedAnalyses All()
+  {
+    PreservedAnalyses pa;
+    pa.all_ = true;
+    return pa;
+  }
+
+  /// Marks an analysis as preserved.
+  template<typename T>
+  PreservedAnalyses &Preserve()
+  {
+    ids_.insert(&AnalysisID<T>::ID);
+    return *this;
+  }
+
+  /// Checks whether an analysis is preserved.
+  bool IsPreserved(const char *id) const { return all_ || ids_.count(id); }
+
+private:
+  /// Flag to indicate that all analyses are preserved.
+  bool all_;
+  /// Identifiers of the preserved analyses.
+  llvm::SmallPtrSet<const char *, 4> ids_;
+};
@@ -2,6 +2,9 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallPtrSet.h>
+
 #include "core/analysis/call_graph.h"
 #include "core/prog.h"
 #include "core/block.h"
@@ -156,7 +159,360 @@ CallGraph::~CallGraph()
 const CallGraph::Node *CallGraph::operator[](Func *f) const
 {
   assert(f && "invalid function");
-  auto it = nodes_.find(f);
-  assert(it != nodes_.end() && "missing node");
-  return it->second.get();
+  auto &node = nodes_[f];
+  if (!node) {
+    node = std::make_unique<Node>(this, f);
+  }
+  return node.get();
+}
+
+
+
+// -----------------------------------------------------------------------------
+char AnalysisID<CallGraphAnalysis>::ID;
+
+// -----------------------------------------------------------------------------
+static llvm::SmallVector<Func *, 4> FindCallees(Func &func)
+{
+  llvm::SmallVector<Func *, 4> callees;
+  llvm::SmallPtrSet<Func *, 4> visited;
+  for (Block &block : func) {
+    for (Inst &inst : block) {
+      if (auto *callee = GetCallee(&inst)) {
+        if (visited.insert(callee).second) {
+          callees.push_back(callee);
+        }
+      }
+    }
+  }
+  return callees;
+}
+
+// -----------------------------------------------------------------------------
+CallGraphAnalysis::CallGraphAnalysis(Prog &prog)
+  : prog_(prog)
+  , graph_(prog)
+  , built_(false)
+{
+}
+
+// -----------------------------------------------------------------------------
+CallGraphAnalysis::~CallGraphAnalysis()
+{
+}
+
+// -----------------------------------------------------------------------------
+llvm::ArrayRef<CallGraphAnalysis::SCC> CallGraphAnalysis::GetSCCs()
+{
+  if (!built_) {
+    Build();
+    built_ = true;
+  }
+  return sccs_;
+}
+
+// -----------------------------------------------------------------------------
+llvm::ArrayRef<Func *> CallGraphAnalysis::GetCallees(Func &func)
+{
+  if (!built_) {
+    Build();
+    built_ = true;
+  }
+  return nodes_.find(&func)->second.Callees;
+}
+
+// -----------------------------------------------------------------------------
+bool CallGraphAnalysis::IsRecursive(Func &func)
+{
+  auto sccs = GetSCCs();
+  auto &node = nodes_.find(&func)->second;
+  if (sccs[node.SCC].size() > 1) {
+    return true;
+  }
+  return llvm::is_contained(node.Callees, &func);
+}
+
+// -----------------------------------------------------------------------------
+void CallGraphAnalysis::Add(Func &func)
+{
+  if (!built_) {
+    return;
+  }
+
+  // Place the function right above its highest callee, in a new SCC.
+  unsigned index = 0;
+  for (Func *callee : FindCallees(func)) {
+    if (auto it = nodes_.find(callee); it != nodes_.end()) {
+      index = std::max(index, it->second.SCC + 1);
+    }
+  }
+  sccs_.insert(sccs_.begin() + index, SCC{ &func });
+  nodes_.try_emplace(&func);
+  Renumber(index);
+
+  // Record the calls, which do not change the order.
+  Update(func);
+}
+
+// -----------------------------------------------------------------------------
+void CallGraphAnalysis::Update(Func &func)
+{
+  if (!built_) {
+    return;
+  }
+
+  auto callees = FindCallees(func);
+  auto &node = nodes_.find(&func)->second;
+
+  // Removed calls can only split the SCC of the function, while new calls
+  // to functions placed above it might merge or re-order the SCCs between
+  // the function and the callee.
+  const unsigned lo = node.SCC;
+  unsigned hi = node.SCC;
+  bool dirty = false;
+  for (Func *callee : node.Callees) {
+    if (llvm::is_contained(callees, callee)) {
+      continue;
+    }
+    auto &calleeNode = nodes_.find(callee)->second;
+    calleeNode.Callers.erase(llvm::find(calleeNode.Callers, &func));
+    dirty = dirty || calleeNode.SCC == lo;
+  }
+  for (Func *callee : callees) {
+    if (llvm::is_contained(node.Callees, callee)) {
+      continue;
+    }
+    auto it = nodes_.find(callee);
+    assert(it != nodes_.end() && "callee not added to the call graph");
+    auto &calleeNode = it->second;
+    calleeNode.Callers.push_back(&func);
+    if (calleeNode.SCC > lo) {
+      hi = std::max(hi, calleeNode.SCC);
+      dirty = true;
+    }
+  }
+  node.Callees = std::move(callees);
+
+  if (dirty) {
+    Condense(lo, hi);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void CallGraphAnalysis::Remove(Func &func)
+{
+  graph_.Remove(&func);
+  if (!built_) {
+    return;
+  }
+
+  auto it = nodes_.find(&func);
+  Node node = std::move(it->second);
+  nodes_.erase(it);
+
+  // Drop the edges, including the ones of callers not yet updated.
+  for (Func *callee : node.Callees) {
+    if (callee != &func) {
+      auto &callers = nodes_.find(callee)->second.Callers;
+      callers.erase(llvm::find(callers, &func));
+    }
+  }
+  for (Func *caller : node.Callers) {
+    if (caller != &func) {
+      auto &callees = nodes_.find(caller)->second.Callees;
+      callees.erase(llvm::find(callees, &func));
+    }
+  }
+
+  // Remove the function from its SCC, which might fall apart.
+  SCC &scc = sccs_[node.SCC];
+  scc.erase(llvm::find(scc, &func));
+  if (scc.empty()) {
+    sccs_.erase(sccs_.begin() + node.SCC);
+    Renumber(node.SCC);
+  } else {
+    Condense(node.SCC, node.SCC);
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool CallGraphAnalysis::Verify()
+{
+  if (!built_) {
+    return true;
+  }
+
+  // Check the snapshots of the calls.
+  if (nodes_.size() != prog_.size()) {
+    return false;
+  }
+  for (Func &func : prog_) {
+    auto it = nodes_.find(&func);
+    if (it == nodes_.end()) {
+      return false;
+    }
+    auto callees = FindCallees(func);
+    auto cached = it->second.Callees;
+    llvm::sort(callees);
+    llvm::sort(cached);
+    if (callees != cached) {
+      return false;
+    }
+    for (Func *callee : callees) {
+      auto &calleeNode = nodes_.find(callee)->second;
+      if (!llvm::is_contained(calleeNode.Callers, &func)) {
+        return false;
+      }
+      if (calleeNode.SCC > it->second.SCC) {
+        return false;
+      }
+    }
+  }
+
+  // Check the SCCs against freshly computed ones.
+  std::vector<Func *> funcs;
+  for (Func &func : prog_) {
+    funcs.push_back(&func);
+  }
+  for (const SCC &scc : FindSCCs(funcs)) {
+    const unsigned index = nodes_.find(scc[0])->second.SCC;
+    if (sccs_[index].size() != scc.size()) {
+      return false;
+    }
+    for (Func *func : scc) {
+      if (nodes_.find(func)->second.SCC != index) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void CallGraphAnalysis::Build()
+{
+  std::vector<Func *> funcs;
+  for (Func &func : prog_) {
+    funcs.push_back(&func);
+    nodes_[&func].Callees = FindCallees(func);
+  }
+  for (Func *func : funcs) {
+    for (Func *callee : nodes_[func].Callees) {
+      nodes_[callee].Callers.push_back(func);
+    }
+  }
+  sccs_ = FindSCCs(funcs);
+  Renumber(0);
+}
+
+// -----------------------------------------------------------------------------
+std::vector<CallGraphAnalysis::SCC>
+CallGraphAnalysis::FindSCCs(llvm::ArrayRef<Func *> funcs)
+{
+  // Tarjan's algorithm, with an explicit stack. Functions outside the set
+  // are not tracked, thus calls to them are ignored.
+  struct State {
+    /// DFS number, 0 if not yet visited.
+    unsigned Index = 0;
+    /// Lowest DFS number reachable.
+    unsigned Low = 0;
+    /// Flag indicating whether the function is on the stack.
+    bool OnStack = false;
+  };
+  llvm::DenseMap<Func *, State> states;
+  for (Func *func : funcs) {
+    states.try_emplace(func);
+  }
+
+  std::vector<SCC> sccs;
+  std::vector<Func *> stack;
+  std::vector<std::pair<Func *, unsigned>> dfs;
+  unsigned next = 0;
+  auto visit = [&](Func *func) {
+    auto &state = states.find(func)->second;
+    state.Index = state.Low = ++next;
+    state.OnStack = true;
+    stack.push_back(func);
+    dfs.emplace_back(func, 0);
+  };
+
+  for (Func *root : funcs) {
+    if (states.find(root)->second.Index) {
+      continue;
+    }
+    visit(root);
+    while (!dfs.empty()) {
+      Func *func = dfs.back().first;
+      auto &state = states.find(func)->second;
+      auto &callees = nodes_.find(func)->second.Callees;
+      if (dfs.back().second < callees.size()) {
+        Func *callee = callees[dfs.back().second++];
+        auto it = states.find(callee);
+        if (it == states.end()) {
+          continue;
+        }
+        if (!it->second.Index) {
+          visit(callee);
+        } else if (it->second.OnStack) {
+          state.Low = std::min(state.Low, it->second.Index);
+        }
+        continue;
+      }
+
+      dfs.pop_back();
+      if (!dfs.empty()) {
+        auto &parent = states.find(dfs.back().first)->second;
+        parent.Low = std::min(parent.Low, state.Low);
+      }
+      if (state.Low == state.Index) {
+        auto &scc = sccs.emplace_back();
+        Func *member;
+        do {
+          member = stack.back();
+          stack.pop_back();
+          states.find(member)->second.OnStack = false;
+          scc.push_back(member);
+        } while (member != func);
+      }
+    }
+  }
+  return sccs;
+}
+
+// -----------------------------------------------------------------------------
+void CallGraphAnalysis::Condense(unsigned lo, unsigned hi)
+{
+  // SCCs outside the range remain valid: the functions in the range are
+  // re-ordered among themselves, above all callees and below all callers.
+  std::vector<Func *> funcs;
+  for (unsigned i = lo; i <= hi; ++i) {
+    funcs.insert(funcs.end(), sccs_[i].begin(), sccs_[i].end());
+  }
+  auto sccs = FindSCCs(funcs);
+  const bool resized = sccs.size() != hi - lo + 1;
+  sccs_.erase(sccs_.begin() + lo, sccs_.begin() + hi + 1);
+  sccs_.insert(
+      sccs_.begin() + lo,
+      std::make_move_iterator(sccs.begin()),
+      std::make_move_iterator(sccs.end())
+  );
+  if (resized) {
+    Renumber(lo);
+  } else {
+    for (unsigned i = lo; i <= hi; ++i) {
+      for (Func *func : sccs_[i]) {
+        nodes_.find(func)->second.SCC = i;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void CallGraphAnalysis::Renumber(unsigned from)
+{
+  for (unsigned i = from, n = sccs_.size(); i < n; ++i) {
+    for (Func *func : sccs_[i]) {
+      nodes_.find(func)->second.SCC = i;
+    }
+  }
 }
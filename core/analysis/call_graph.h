@@ -4,10 +4,16 @@
 
 #pragma once
 
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/PointerUnion.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/DOTGraphTraits.h>
 
+#include "core/analysis.h"
 #include "core/func.h"
 #include "core/inst.h"
 #include "core/prog.h"
@@ -110,9 +116,12 @@ public:
 
   /// Returns the virtual the entry node.
   const Node *Entry() const { return &entry_; }
-  /// Returns the node for a function.
+  /// Returns the node for a function, creating it for new functions.
   const Node *operator[](Func *f) const;
 
+  /// Removes the node of a function which is about to be erased.
+  void Remove(Func *f) { nodes_.erase(f); }
+
   /// Iterator over nodes.
   const_node_iterator begin() const { return const_node_iterator(nodes_.begin()); }
   const_node_iterator end() const { return const_node_iterator(nodes_.end()); }
@@ -125,6 +134,85 @@ private:
   mutable NodeMap nodes_;
 };
 
+/**
+ * Call graph of a program, along with its condensation into SCCs.
+ *
+ * The analysis is cached by the pass manager. The condensation is built on
+ * first use from snapshots of the direct calls of functions. Passes which
+ * preserve the analysis must report the functions they add or erase and the
+ * functions whose calls they change: SCCs are then merged, split and
+ * re-ordered locally, instead of being rebuilt for the whole program.
+ */
+class CallGraphAnalysis final : public ProgAnalysis {
+public:
+  /// Strongly-connected component: a set of mutually recursive functions.
+  using SCC = std::vector<Func *>;
+
+public:
+  /// Creates the analysis, deferring the construction of SCCs.
+  CallGraphAnalysis(Prog &prog);
+
+  /// Cleanup.
+  ~CallGraphAnalysis();
+
+  /// Returns the lazily-built call graph.
+  CallGraph &GetCallGraph() { return graph_; }
+
+  /// Returns the SCCs, with callees preceding their callers.
+  llvm::ArrayRef<SCC> GetSCCs();
+  /// Returns the functions called directly, in the order of the call sites.
+  llvm::ArrayRef<Func *> GetCallees(Func &func);
+  /// Checks whether a function can call itself, directly or indirectly.
+  bool IsRecursive(Func &func);
+
+  /// Records a new function, after its body was built.
+  void Add(Func &func);
+  /// Records changes to the calls made by a function.
+  void Update(Func &func);
+  /// Removes a function which is about to be erased.
+  void Remove(Func &func);
+
+  /// Checks the condensation against one built from scratch.
+  bool Verify() override;
+
+private:
+  /// Snapshot of the calls of a function.
+  struct Node {
+    /// Functions called directly, in the order of the call sites.
+    llvm::SmallVector<Func *, 4> Callees;
+    /// Functions calling this one.
+    llvm::SmallVector<Func *, 4> Callers;
+    /// Index of the SCC containing the function.
+    unsigned SCC = 0;
+  };
+
+  /// Builds the condensation from scratch.
+  void Build();
+  /// Finds the SCCs of a set of functions, ignoring calls leaving it.
+  std::vector<SCC> FindSCCs(llvm::ArrayRef<Func *> funcs);
+  /// Recomputes the SCCs in a range of indices.
+  void Condense(unsigned lo, unsigned hi);
+  /// Renumbers the functions of the SCCs starting at an index.
+  void Renumber(unsigned from);
+
+private:
+  /// Program the analysis describes.
+  Prog &prog_;
+  /// Lazily-built call graph.
+  CallGraph graph_;
+  /// Flag indicating whether the condensation was built.
+  bool built_;
+  /// Snapshots of functions.
+  llvm::DenseMap<Func *, Node> nodes_;
+  /// SCCs, ordered bottom-up.
+  std::vector<SCC> sccs_;
+};
+
+/// Identifier of the call graph analysis.
+template<> struct AnalysisID<CallGraphAnalysis> { static char ID; };
+
+
+
 /// Graph traits for call graph nodes.
 namespace llvm {
 
@@ -11,3 +11,95 @@ template void Calculate<BlockDomTree>(BlockDomTree &DT);
 }
 }
 
+
+
+// -----------------------------------------------------------------------------
+char AnalysisID<DominatorAnalysis>::ID;
+
+// -----------------------------------------------------------------------------
+DominatorTree &DominatorAnalysis::GetDominatorTree()
+{
+  if (!dt_) {
+    dt_ = std::make_unique<DominatorTree>(func_);
+  }
+  return *dt_;
+}
+
+// -----------------------------------------------------------------------------
+PostDominatorTree &DominatorAnalysis::GetPostDominatorTree()
+{
+  if (!pdt_) {
+    pdt_ = std::make_unique<PostDominatorTree>(func_);
+  }
+  return *pdt_;
+}
+
+// -----------------------------------------------------------------------------
+DominanceFrontier &DominatorAnalysis::GetDominanceFrontier()
+{
+  if (!df_) {
+    df_ = std::make_unique<DominanceFrontier>();
+    df_->analyze(GetDominatorTree());
+  }
+  return *df_;
+}
+
+// -----------------------------------------------------------------------------
+PostDominanceFrontier &DominatorAnalysis::GetPostDominanceFrontier()
+{
+  if (!pdf_) {
+    pdf_ = std::make_unique<PostDominanceFrontier>();
+    pdf_->analyze(GetPostDominatorTree());
+  }
+  return *pdf_;
+}
+
+// -----------------------------------------------------------------------------
+void DominatorAnalysis::ApplyUpdates(llvm::ArrayRef<Update> updates)
+{
+  // Trees are updated in place, frontiers are rebuilt on demand.
+  if (dt_) {
+    dt_->applyUpdates(updates);
+  }
+  if (pdt_) {
+    pdt_->applyUpdates(updates);
+  }
+  df_ = nullptr;
+  pdf_ = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+void DominatorAnalysis::SplitEdge(Block *from, Block *split, Block *to)
+{
+  ApplyUpdates({
+      { llvm::cfg::UpdateKind::Insert, from, split },
+      { llvm::cfg::UpdateKind::Insert, split, to },
+      { llvm::cfg::UpdateKind::Delete, from, to },
+  });
+}
+
+// -----------------------------------------------------------------------------
+bool DominatorAnalysis::Verify()
+{
+  if (dt_ && !dt_->verify()) {
+    return false;
+  }
+  if (pdt_ && !pdt_->verify()) {
+    return false;
+  }
+  if (df_) {
+    DominanceFrontier df;
+    df.analyze(*dt_);
+    if (df_->compare(df)) {
+      return false;
+    }
+  }
+  if (pdf_) {
+    PostDominanceFrontier pdf;
+    pdf.analyze(*pdt_);
+    if (pdf_->compare(pdf)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -4,12 +4,16 @@
 
 #pragma once
 
+#include <memory>
+
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/iterator.h>
 #include <llvm/Analysis/DominanceFrontier.h>
 #include <llvm/Analysis/DominanceFrontierImpl.h>
 #include <llvm/Support/GenericDomTree.h>
 #include <llvm/Support/GenericDomTreeConstruction.h>
 
+#include "core/analysis.h"
 #include "core/cfg.h"
 #include "core/block.h"
 #include "core/func.h"
@@ -103,6 +107,56 @@ public:
 
 
 
+/**
+ * Dominance information of a function, cached by the pass manager.
+ *
+ * Trees and frontiers are built on demand and remain valid until the CFG of
+ * the function changes: passes which only rewrite instructions preserve the
+ * analysis, while passes which edit edges can update the trees in place.
+ */
+class DominatorAnalysis final : public FuncAnalysis {
+public:
+  /// Insertion or deletion of an edge.
+  using Update = llvm::cfg::Update<Block *>;
+
+  /// Creates the analysis, deferring the construction of trees.
+  DominatorAnalysis(Func &func) : func_(func) {}
+
+  /// Returns the dominator tree.
+  DominatorTree &GetDominatorTree();
+  /// Returns the post-dominator tree.
+  PostDominatorTree &GetPostDominatorTree();
+  /// Returns the dominance frontier.
+  DominanceFrontier &GetDominanceFrontier();
+  /// Returns the post-dominance frontier.
+  PostDominanceFrontier &GetPostDominanceFrontier();
+
+  /// Updates the trees once the edges were changed in the CFG.
+  void ApplyUpdates(llvm::ArrayRef<Update> updates);
+  /// Updates the trees once a block was placed along an edge.
+  void SplitEdge(Block *from, Block *split, Block *to);
+
+  /// Checks the trees and frontiers against ones built from scratch.
+  bool Verify() override;
+
+private:
+  /// Function the analysis describes.
+  Func &func_;
+  /// Dominator tree, if built.
+  std::unique_ptr<DominatorTree> dt_;
+  /// Post-dominator tree, if built.
+  std::unique_ptr<PostDominatorTree> pdt_;
+  /// Dominance frontier, if built.
+  std::unique_ptr<DominanceFrontier> df_;
+  /// Post-dominance frontier, if built.
+  std::unique_ptr<PostDominanceFrontier> pdf_;
+};
+
+/// Identifier of the dominator analysis.
+template<> struct AnalysisID<DominatorAnalysis> { static char ID; };
+
+
+
 namespace llvm {
 namespace DomTreeBuilder {
 
@@ -4,7 +4,11 @@
 
 #pragma once
 
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/PostOrderIterator.h>
+#include <algorithm>
+#include <functional>
 #include <queue>
 #include "core/cfg.h"
 
@@ -16,6 +20,12 @@ enum class Direction {
   BACKWARD,
 };
 
+/// Operator combining the flows of neighbouring blocks.
+enum class Meet {
+  UNION,
+  INTERSECT,
+};
+
 /**
  * Kildall's algorithm for transfer functions with kill-gen sets.
  */
@@ -285,3 +295,251 @@ void KillGenSolver<FlowSet, GenSet, KillSet, Dir>::Solve()
     }
   }
 }
+
+
+
+/**
+ * Kildall's algorithm specialised to kill-gen sets over dense bit vectors.
+ *
+ * Elements are numbered by the analysis. The transfer functions of the
+ * instructions of a block are summarised into a single kill-gen pair before
+ * solving, thus instructions are only visited again in the final traversal.
+ * Blocks are prioritised by their reverse post-order index for forward
+ * analyses and by their post-order index for backward ones, while set
+ * operations proceed a word at a time. Blocks unreachable from the entry
+ * are neither solved nor traversed. The outputs of blocks start from their
+ * gen sets, thus the solution is the least fixpoint: under intersection,
+ * facts flowing around loops are conservatively dropped.
+ */
+template <Direction Dir, Meet M>
+class BitVectorSolver {
+public:
+  /// Kill and gen sets, updated by instructions in analysis order.
+  class KillGen {
+  public:
+    /// Removes an element from the flow.
+    void Kill(unsigned bit)
+    {
+      if (kill_) {
+        kill_->set(bit);
+      }
+      gen_.reset(bit);
+    }
+
+    /// Removes all elements from the flow.
+    void KillAll()
+    {
+      if (kill_) {
+        kill_->set();
+      }
+      gen_.reset();
+    }
+
+    /// Adds an element to the flow.
+    void Gen(unsigned bit)
+    {
+      gen_.set(bit);
+    }
+
+  private:
+    friend class BitVectorSolver;
+
+    KillGen(llvm::BitVector &gen, llvm::BitVector *kill)
+      : gen_(gen)
+      , kill_(kill)
+    {
+    }
+
+  private:
+    /// Set of generated elements.
+    llvm::BitVector &gen_;
+    /// Set of killed elements, absent when applied to a flow.
+    llvm::BitVector *kill_;
+  };
+
+public:
+  /// Initialises the solver for a given number of elements.
+  BitVectorSolver(Func &func, unsigned numBits);
+
+  /// Cleanup.
+  virtual ~BitVectorSolver() = default;
+
+  /// Solves the constraints, then traverses all instructions.
+  void Solve();
+
+protected:
+  /**
+   * Applies the transfer function of an instruction.
+   *
+   * Kills must precede gens, as they are applied in order.
+   */
+  virtual void Build(Inst &inst, KillGen &kg) = 0;
+
+  /**
+   * Visits an instruction with the flow reaching it.
+   *
+   * The flow does not include the effects of the instruction itself.
+   * Instructions must not be erased during the traversal.
+   */
+  virtual void Traverse(Inst &inst, const llvm::BitVector &flow) = 0;
+
+private:
+  /// Applies a function to the instructions of a block, in analysis order.
+  template <typename F>
+  void ForEach(Block &block, F &&f);
+
+private:
+  /// Per-block information.
+  struct BlockInfo {
+    /// Block for which the info is generated.
+    Block *B;
+    /// Blocks whose output flows into this block.
+    llvm::SmallVector<unsigned, 4> Inputs;
+    /// Blocks receiving the output of this block.
+    llvm::SmallVector<unsigned, 4> Users;
+    /// Gen of block.
+    llvm::BitVector Gen;
+    /// Kill of block.
+    llvm::BitVector Kill;
+    /// Flow into the block.
+    llvm::BitVector Flow;
+    /// Flow out of the block.
+    llvm::BitVector Out;
+
+    BlockInfo(Block *B) : B(B) {}
+  };
+
+protected:
+  /// Reference to the function.
+  Func &func_;
+  /// Number of elements.
+  unsigned numBits_;
+
+private:
+  /// Block information, in priority order.
+  std::vector<BlockInfo> blocks_;
+};
+
+template <Direction Dir, Meet M>
+BitVectorSolver<Dir, M>::BitVectorSolver(Func &func, unsigned numBits)
+  : func_(func)
+  , numBits_(numBits)
+{
+  // Number blocks in the order they are to be visited.
+  auto *entry = llvm::GraphTraits<Func *>::getEntryNode(&func);
+  for (Block *block : llvm::post_order(entry)) {
+    blocks_.emplace_back(block);
+  }
+  if constexpr (Dir == Direction::FORWARD) {
+    std::reverse(blocks_.begin(), blocks_.end());
+  }
+  llvm::DenseMap<const Block *, unsigned> index;
+  for (unsigned i = 0, n = blocks_.size(); i < n; ++i) {
+    index.try_emplace(blocks_[i].B, i);
+  }
+
+  // Connect blocks to the neighbours they exchange flows with.
+  for (BlockInfo &info : blocks_) {
+    auto connect = [&](const Block *block, auto &edges) {
+      if (auto it = index.find(block); it != index.end()) {
+        edges.push_back(it->second);
+      }
+    };
+    for (const Block *pred : info.B->predecessors()) {
+      connect(pred, Dir == Direction::FORWARD ? info.Inputs : info.Users);
+    }
+    for (const Block *succ : info.B->successors()) {
+      connect(succ, Dir == Direction::FORWARD ? info.Users : info.Inputs);
+    }
+  }
+}
+
+template <Direction Dir, Meet M>
+void BitVectorSolver<Dir, M>::Solve()
+{
+  // Summarise the kill and gen sets of blocks.
+  for (BlockInfo &info : blocks_) {
+    info.Gen.resize(numBits_);
+    info.Kill.resize(numBits_);
+    info.Flow.resize(numBits_);
+
+    KillGen kg(info.Gen, &info.Kill);
+    ForEach(*info.B, [this, &kg](Inst &inst) { Build(inst, kg); });
+    info.Out = info.Gen;
+  }
+
+  // Visit all blocks once, in order, then until a fixpoint is reached.
+  std::priority_queue<unsigned, std::vector<unsigned>, std::greater<>> queue;
+  llvm::BitVector inQueue(blocks_.size(), true);
+  for (unsigned i = 0, n = blocks_.size(); i < n; ++i) {
+    queue.push(i);
+  }
+
+  llvm::BitVector flow(numBits_), out(numBits_);
+  while (!queue.empty()) {
+    unsigned index = queue.top();
+    queue.pop();
+    inQueue.reset(index);
+    BlockInfo &info = blocks_[index];
+
+    // Combine the outputs of the inputs.
+    if (info.Inputs.empty()) {
+      flow.reset();
+    } else {
+      flow = blocks_[info.Inputs[0]].Out;
+      for (unsigned i = 1, n = info.Inputs.size(); i < n; ++i) {
+        switch (M) {
+          case Meet::UNION: flow |= blocks_[info.Inputs[i]].Out; break;
+          case Meet::INTERSECT: flow &= blocks_[info.Inputs[i]].Out; break;
+        }
+      }
+    }
+    std::swap(info.Flow, flow);
+
+    // out = gen U (flow - kill)
+    out = info.Flow;
+    out.reset(info.Kill);
+    out |= info.Gen;
+    if (out == info.Out) {
+      continue;
+    }
+    std::swap(info.Out, out);
+
+    // Revisit the blocks depending on this one.
+    for (unsigned user : info.Users) {
+      if (!inQueue.test(user)) {
+        inQueue.set(user);
+        queue.push(user);
+      }
+    }
+  }
+
+  // Traverse nodes, applying the transfer functions of instructions.
+  for (BlockInfo &info : blocks_) {
+    KillGen kg(info.Flow, nullptr);
+    ForEach(*info.B, [this, &info, &kg](Inst &inst) {
+      Traverse(inst, info.Flow);
+      Build(inst, kg);
+    });
+  }
+}
+
+template <Direction Dir, Meet M>
+template <typename F>
+void BitVectorSolver<Dir, M>::ForEach(Block &block, F &&f)
+{
+  switch (Dir) {
+    case Direction::FORWARD: {
+      for (auto it = block.begin(); it != block.end(); ++it) {
+        f(*it);
+      }
+      break;
+    }
+    case Direction::BACKWARD: {
+      for (auto it = block.rbegin(); it != block.rend(); ++it) {
+        f(*it);
+      }
+      break;
+    }
+  }
+}
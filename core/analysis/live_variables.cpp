@@ -14,6 +14,28 @@
 LiveVariables::LiveVariables(const Func *func)
   : loops_(func)
 {
+  // Number values in program order, which is the order in which live sets
+  // are returned. The order must only depend on the function, as it
+  // determines the layout of GC frames.
+  for (const Block &block : *func) {
+    blockIndex_.try_emplace(&block, blockIndex_.size());
+    for (const Inst &inst : block) {
+      if (unsigned n = inst.GetNumRets()) {
+        valueIndex_.try_emplace(&inst, values_.size());
+        for (unsigned i = 0; i < n; ++i) {
+          values_.emplace_back(&inst, i);
+        }
+      }
+    }
+  }
+
+  // Allocate empty live sets for all blocks.
+  blocks_.resize(blockIndex_.size());
+  for (BlockInfo &info : blocks_) {
+    info.LiveIn.resize(values_.size());
+    info.LiveOut.resize(values_.size());
+  }
+
   TraverseDAG(&func->getEntryBlock());
   for (auto *loop : loops_) {
     TraverseLoop(loop);
@@ -32,39 +54,37 @@ std::vector<ConstRef<Inst>> LiveVariables::LiveOut(const Inst *inst)
   const Block *block = inst->getParent();
   if (block != liveBlock_) {
     liveBlock_ = block;
-    liveCache_.clear();
-
-    auto &info = live_[block];
-
-    InstSet live = info.second;
-    for (auto it = block->rbegin(); it != block->rend(); ++it) {
-      liveCache_[&*it] = live;
+    liveIndex_.clear();
+    liveCache_.resize(block->size());
+
+    llvm::BitVector live = GetInfo(block).LiveOut;
+    unsigned index = 0;
+    for (auto it = block->rbegin(); it != block->rend(); ++it, ++index) {
+      liveIndex_.try_emplace(&*it, index);
+      liveCache_[index] = live;
       KillDef(live, &*it);
     }
   }
 
-  auto &cached = liveCache_[inst];
+  const llvm::BitVector &cached = liveCache_[liveIndex_.find(inst)->second];
   std::vector<ConstRef<Inst>> ordered;
-  std::copy(cached.begin(), cached.end(), std::back_inserter(ordered));
-  std::sort(
-      ordered.begin(),
-      ordered.end(),
-      [](ConstRef<Inst> a, ConstRef<Inst> b)
-      {
-        return a->GetOrder() < b->GetOrder();
-      }
-  );
+  ordered.reserve(cached.count());
+  for (unsigned index : cached.set_bits()) {
+    ordered.push_back(values_[index]);
+  }
   return ordered;
 }
 
 // -----------------------------------------------------------------------------
 void LiveVariables::TraverseDAG(const Block *block)
 {
+  GetInfo(block).Visited = true;
+
   // Process children.
   for (auto *succ : block->successors()) {
     if (!loops_.IsLoopEdge(block, succ)) {
       auto *node = loops_.HighestAncestor(block, succ);
-      if (!live_.count(node)) {
+      if (!GetInfo(node).Visited) {
         TraverseDAG(node);
       }
     }
@@ -76,29 +96,27 @@ void LiveVariables::TraverseDAG(const Block *block)
 void LiveVariables::TraverseNode(const Block *block)
 {
   // liveOut = PhiUses(block)
-  InstSet liveOut;
+  llvm::BitVector liveOut(values_.size());
   for (auto *succ : block->successors()) {
     for (auto &phi : succ->phis()) {
-      liveOut.insert(phi.GetValue(block));
+      liveOut.set(GetIndex(phi.GetValue(block)));
     }
   }
 
   // Merge liveIn infos of children.
+  llvm::BitVector live;
   for (auto *succ : block->successors()) {
     if (!loops_.IsLoopEdge(block, succ)) {
       auto *node = loops_.HighestAncestor(block, succ);
       // liveOut = liveOut U (LiveIn(S) \ PhiDefs(S))
-      InstSet live = live_[node].first;
-      for (auto &phi : node->phis()) {
-        live.erase(&phi);
-      }
-
-      liveOut.insert(live.begin(), live.end());
+      live = GetInfo(node).LiveIn;
+      KillPhis(live, node);
+      liveOut |= live;
     }
   }
 
   // LiveOut(B) = liveOut
-  InstSet liveIn(liveOut);
+  llvm::BitVector liveIn(liveOut);
   for (auto it = block->rbegin(); it != block->rend(); ++it) {
     if (it->Is(Inst::Kind::PHI)) {
       break;
@@ -108,11 +126,13 @@ void LiveVariables::TraverseNode(const Block *block)
 
   // LiveIn(B) = Live U PhiDefs(B)
   for (auto &phi : block->phis()) {
-    liveIn.insert(&phi);
+    liveIn.set(GetIndex(phi.GetSubValue(0)));
   }
 
   // Record liveness for this block.
-  live_.emplace(block, std::make_pair(liveIn, liveOut));
+  BlockInfo &info = GetInfo(block);
+  info.LiveIn = std::move(liveIn);
+  info.LiveOut = std::move(liveOut);
 }
 
 // -----------------------------------------------------------------------------
@@ -121,32 +141,25 @@ void LiveVariables::TraverseLoop(LoopNesting::Loop *loop)
   auto *header = loop->GetHeader();
 
   // liveLoop = LiveIn(header) \ PhiDefs(header)
-  InstSet liveLoop = live_[header].first;
-  for (auto &phi : header->phis()) {
-    liveLoop.erase(&phi);
-  }
+  llvm::BitVector liveLoop = GetInfo(header).LiveIn;
+  KillPhis(liveLoop, header);
 
   for (auto *innerBlock : loop->blocks()) {
-    auto &[liveIn, liveOut] = live_[innerBlock];
-    for (auto &inst : liveLoop) {
-      liveIn.insert(inst);
-      liveOut.insert(inst);
-    }
+    BlockInfo &info = GetInfo(innerBlock);
+    info.LiveIn |= liveLoop;
+    info.LiveOut |= liveLoop;
   }
 
   for (auto *innerLoop : loop->loops()) {
-    auto *innerHeader = innerLoop->GetHeader();
-    auto &[liveIn, liveOut] = live_[innerHeader];
-    for (auto &inst : liveLoop) {
-      liveIn.insert(inst);
-      liveOut.insert(inst);
-    }
+    BlockInfo &info = GetInfo(innerLoop->GetHeader());
+    info.LiveIn |= liveLoop;
+    info.LiveOut |= liveLoop;
     TraverseLoop(innerLoop);
   }
 }
 
 // -----------------------------------------------------------------------------
-void LiveVariables::KillDef(InstSet &live, const Inst *inst)
+void LiveVariables::KillDef(llvm::BitVector &live, const Inst *inst)
 {
   if (inst->Is(Inst::Kind::ARG)) {
     // Argument instructions do not kill - they must be live on entry.
@@ -154,12 +167,20 @@ void LiveVariables::KillDef(InstSet &live, const Inst *inst)
   }
 
   for (unsigned i = 0, n = inst->GetNumRets(); i < n; ++i) {
-    live.erase(ConstRef<Inst>(inst, i));
+    live.reset(GetIndex(ConstRef<Inst>(inst, i)));
   }
 
   for (ConstRef<Value> value : inst->operand_values()) {
     if (ConstRef<Inst> inst = ::cast_or_null<Inst>(value)) {
-      live.insert(inst);
+      live.set(GetIndex(inst));
     }
   }
 }
+
+// -----------------------------------------------------------------------------
+void LiveVariables::KillPhis(llvm::BitVector &live, const Block *block)
+{
+  for (auto &phi : block->phis()) {
+    live.reset(GetIndex(phi.GetSubValue(0)));
+  }
+}
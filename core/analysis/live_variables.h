@@ -4,10 +4,11 @@
 
 #pragma once
 
-#include <set>
-#include <unordered_set>
 #include <vector>
 
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+
 #include "core/inst.h"
 #include "core/analysis/loop_nesting.h"
 
@@ -19,6 +20,11 @@ class Inst;
 
 /**
  * Helper class to compute live variable info for a function.
+ *
+ * Values are numbered densely in program order and live sets
+ * are stored as bit vectors over these numbers, allowing sets to be merged
+ * word by word. Live-outs of the instructions of the last queried block are
+ * cached, as queries tend to visit the instructions of a block together.
  */
 class LiveVariables final {
 public:
@@ -38,7 +44,15 @@ public:
   std::vector<ConstRef<Inst>> LiveOut(const Inst *inst);
 
 private:
-  using InstSet = std::unordered_set<ConstRef<Inst>>;
+  /// Liveness information of a block.
+  struct BlockInfo {
+    /// Flag indicating whether the block was visited.
+    bool Visited = false;
+    /// Values live on entry.
+    llvm::BitVector LiveIn;
+    /// Values live on exit.
+    llvm::BitVector LiveOut;
+  };
 
   /// DFS over the DAG - CFG minus loop edges.
   void TraverseDAG(const Block *block);
@@ -47,21 +61,36 @@ private:
   /// DFS over the loop nesting forest.
   void TraverseLoop(LoopNesting::Loop *loop);
   /// Applies the transfer function of an instruction.
-  void KillDef(InstSet &live, const Inst *inst);
+  void KillDef(llvm::BitVector &live, const Inst *inst);
+  /// Removes the PHIs of a block from a live set.
+  void KillPhis(llvm::BitVector &live, const Block *block);
+
+  /// Returns the liveness information of a block.
+  BlockInfo &GetInfo(const Block *block)
+  {
+    return blocks_[blockIndex_.find(block)->second];
+  }
+  /// Returns the number assigned to a value.
+  unsigned GetIndex(ConstRef<Inst> ref) const
+  {
+    return valueIndex_.find(ref.Get())->second + ref.Index();
+  }
 
 private:
   /// Loop nesting forest.
   LoopNesting loops_;
-  /// Map of visited nodes.
-  std::unordered_map
-    < const Block *
-    , std::pair<InstSet, InstSet>
-    > live_;
+  /// Values of the function, in the order of their numbers.
+  std::vector<ConstRef<Inst>> values_;
+  /// Number of the first value defined by each instruction.
+  llvm::DenseMap<const Inst *, unsigned> valueIndex_;
+  /// Index of each block.
+  llvm::DenseMap<const Block *, unsigned> blockIndex_;
+  /// Liveness information of blocks.
+  std::vector<BlockInfo> blocks_;
+  /// Position of each instruction of the cached block in the cache.
+  llvm::DenseMap<const Inst *, unsigned> liveIndex_;
   /// Cached live outs.
-  std::unordered_map
-    < const Inst *
-    , InstSet
-    > liveCache_;
+  std::vector<llvm::BitVector> liveCache_;
   /// Block for which LVA info was cached.
   const Block *liveBlock_ = nullptr;
 };
@@ -0,0 +1,186 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/block.h"
+#include "core/func.h"
+#include "core/inst.h"
+#include "core/parser.h"
+#include "core/prog.h"
+#include "core/analysis/live_variables.h"
+
+
+
+namespace {
+
+/// Returns the first function of a program.
+Func &GetFunc(Prog &prog)
+{
+  return *prog.begin();
+}
+
+/// Returns the positions of instructions in program order.
+std::unordered_map<const Inst *, unsigned> Number(Func &func)
+{
+  std::unordered_map<const Inst *, unsigned> index;
+  for (Block &block : func) {
+    for (Inst &inst : block) {
+      index.emplace(&inst, index.size());
+    }
+  }
+  return index;
+}
+
+/// Returns the live-outs of every instruction, as instruction positions.
+std::vector<std::vector<unsigned>> LiveOut(Func &func)
+{
+  auto index = Number(func);
+  LiveVariables live(&func);
+  std::vector<std::vector<unsigned>> result;
+  for (Block &block : func) {
+    for (Inst &inst : block) {
+      auto &out = result.emplace_back();
+      for (ConstRef<Inst> ref : live.LiveOut(&inst)) {
+        out.push_back(index[ref.Get()]);
+      }
+    }
+  }
+  return result;
+}
+
+using Live = std::vector<std::vector<unsigned>>;
+
+TEST(LiveVariablesTest, StraightLine) {
+  auto prog = Parser(R"(
+    .section .text
+  f:
+    .call caml
+    .args v64, v64
+    arg.v64         $0, 0
+    arg.v64         $1, 1
+    mov.i64         $2, g
+    call.i64.caml   $3, $2 @caml_frame()
+    add.v64         $4, $0, $1
+    ret             $4
+  )", "test").Parse();
+
+  // Arguments are live from entry, the unused call result is dead.
+  EXPECT_EQ(Live({
+      { 0, 1 },
+      { 0, 1 },
+      { 0, 1, 2 },
+      { 0, 1 },
+      { 4 },
+      { },
+  }), LiveOut(GetFunc(*prog)));
+}
+
+TEST(LiveVariablesTest, Branch) {
+  auto prog = Parser(R"(
+    .section .text
+  f:
+    .args i64
+    arg.i64         $0, 0
+    mov.i64         $1, 1
+    jcc             $0, .Ltrue, .Lfalse
+  .Ltrue:
+    add.i64         $2, $0, $1
+    ret             $2
+  .Lfalse:
+    ret             $1
+  )", "test").Parse();
+
+  EXPECT_EQ(Live({
+      { 0 },
+      { 0, 1 },
+      { 0, 1 },
+      { 3 },
+      { },
+      { },
+  }), LiveOut(GetFunc(*prog)));
+}
+
+TEST(LiveVariablesTest, Loop) {
+  auto prog = Parser(R"(
+    .section .text
+  f:
+    .args i64
+  .Lentry:
+    arg.i64         $0, 0
+    mov.i64         $1, 0
+    mov.i64         $2, 1
+    jmp             .Lloop
+  .Lloop:
+    phi.i64         $3, .Lentry, $1, .Lloop, $4
+    add.i64         $4, $3, $2
+    cmp.i8.lt       $5, $4, $0
+    jcc             $5, .Lloop, .Lexit
+  .Lexit:
+    ret             $4
+  )", "test").Parse();
+
+  Func &func = GetFunc(*prog);
+  Block &entry = *func.begin();
+  Block &loop = *std::next(func.begin());
+  Block &exit = *std::next(func.begin(), 2);
+  Inst *arg = &*entry.begin();
+  Inst *init = &*std::next(entry.begin());
+  Inst *step = &*std::next(entry.begin(), 2);
+  Inst *phi = &*loop.begin();
+  Inst *add = &*std::next(loop.begin());
+  Inst *cmp = &*std::next(loop.begin(), 2);
+
+  // Values defined before the loop and used in it are live throughout.
+  LiveVariables live(&func);
+  using Values = std::vector<const Inst *>;
+  auto out = [&](Inst *inst) {
+    Values values;
+    for (ConstRef<Inst> ref : live.LiveOut(inst)) {
+      values.push_back(ref.Get());
+    }
+    return values;
+  };
+  EXPECT_EQ(Values({ arg, init, step }), out(entry.GetTerminator()));
+  EXPECT_EQ(Values({ arg, step, phi }), out(phi));
+  EXPECT_EQ(Values({ arg, step, add, cmp }), out(cmp));
+  EXPECT_EQ(Values({ arg, step, add }), out(loop.GetTerminator()));
+  EXPECT_EQ(Values({ }), out(exit.GetTerminator()));
+}
+
+TEST(LiveVariablesTest, ProgramOrder) {
+  auto prog = Parser(R"(
+    .section .text
+  f:
+    .call caml
+    mov.v64         $0, 1
+    mov.v64         $1, 2
+    mov.i64         $2, g
+    call.i64.caml   $3, $2 @caml_frame()
+    add.v64         $4, $0, $1
+    ret             $4
+  )", "test").Parse();
+
+  // Move the second definition first: values must be listed in the order
+  // in which they appear in the function, not in the order of creation.
+  Func &func = GetFunc(*prog);
+  Block &entry = func.getEntryBlock();
+  Inst &first = *entry.begin();
+  Inst &second = *std::next(entry.begin());
+  second.removeFromParent();
+  entry.AddInst(&second, &first);
+
+  LiveVariables live(&func);
+  Inst &call = *std::next(entry.begin(), 3);
+  auto out = live.LiveOut(&call);
+  ASSERT_EQ(2u, out.size());
+  EXPECT_EQ(&second, out[0].Get());
+  EXPECT_EQ(&first, out[1].Get());
+}
+
+}
@@ -2,18 +2,34 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <cassert>
 #include <queue>
+#include <set>
 
-#include <llvm/ADT/SCCIterator.h>
-
+#include "core/adt/thread_pool.h"
 #include "core/insts.h"
 #include "core/block.h"
+#include "core/extern.h"
 #include "core/func.h"
+#include "core/prog.h"
 #include "core/analysis/call_graph.h"
 #include "core/analysis/reference_graph.h"
 
 
 
+// -----------------------------------------------------------------------------
+static void MergeOffsets(
+    ObjectOffsetMap &offsets,
+    const BitSet<Object> &ranges,
+    const ObjectOffsetMap &that)
+{
+  for (auto &[id, thatOffsets] : that) {
+    if (!ranges.Contains(id)) {
+      offsets[id].Union(thatOffsets);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 void ReferenceGraph::Node::Merge(const Node &that)
 {
@@ -22,166 +38,211 @@ void ReferenceGraph::Node::Merge(const Node &that)
   HasBarrier |= that.HasBarrier;
 
   // Merge escapes.
-  for (auto *g : that.Escapes) {
-    Escapes.insert(g);
-  }
-  // Merge reads.
-  for (auto *g : that.ReadRanges) {
-    ReadRanges.insert(g);
+  EscapedFuncs.Union(that.EscapedFuncs);
+  EscapedObjects.Union(that.EscapedObjects);
+  EscapedExterns.Union(that.EscapedExterns);
+  // Merge reads, dropping offsets into objects read entirely.
+  ReadRanges.Union(that.ReadRanges);
+  for (ID<Object> id : that.ReadRanges) {
+    ReadOffsets.erase(id);
   }
-  for (auto it = ReadOffsets.begin(); it != ReadOffsets.end(); ) {
-    if (ReadRanges.count(it->first)) {
-      ReadOffsets.erase(it++);
-    } else {
-      ++it;
-    }
-  }
-  for (auto &[o, offsets] : that.ReadOffsets) {
-    if (ReadRanges.count(o)) {
-      continue;
-    }
-    for (auto off : offsets) {
-      ReadOffsets[o].insert(off);
-    }
-  }
-  // Merge writes.
-  for (auto *g : that.WrittenRanges) {
-    WrittenRanges.insert(g);
-  }
-  for (auto it = WrittenOffsets.begin(); it != WrittenOffsets.end(); ) {
-    if (WrittenRanges.count(it->first)) {
-      WrittenOffsets.erase(it++);
-    } else {
-      ++it;
-    }
-  }
-  for (auto &[o, offsets] : that.WrittenOffsets) {
-    if (WrittenRanges.count(o)) {
-      continue;
-    }
-    for (auto off : offsets) {
-      WrittenOffsets[o].insert(off);
-    }
+  MergeOffsets(ReadOffsets, ReadRanges, that.ReadOffsets);
+  // Merge writes, dropping offsets into objects written entirely.
+  WrittenRanges.Union(that.WrittenRanges);
+  for (ID<Object> id : that.WrittenRanges) {
+    WrittenOffsets.erase(id);
   }
+  MergeOffsets(WrittenOffsets, WrittenRanges, that.WrittenOffsets);
   // Merge remaining items.
-  for (auto *g : that.Called) {
-    Called.insert(g);
-  }
-  for (auto *b : that.Blocks) {
-    Blocks.insert(b);
-  }
+  Called.Union(that.Called);
+  Blocks.Union(that.Blocks);
 }
 
 // -----------------------------------------------------------------------------
-void ReferenceGraph::Node::AddRead(Object *object)
+void ReferenceGraph::Node::AddRead(ID<Object> object)
 {
-  ReadRanges.insert(object);
-  for (auto it = ReadOffsets.begin(); it != ReadOffsets.end(); ) {
-    if (it->first == object) {
-      ReadOffsets.erase(it++);
-    } else {
-      ++it;
-    }
-  }
+  ReadRanges.Insert(object);
+  ReadOffsets.erase(object);
 }
 
 // -----------------------------------------------------------------------------
-void ReferenceGraph::Node::AddWrite(Object *object)
+void ReferenceGraph::Node::AddRead(
+    ID<Object> object,
+    const OffsetSet &offsets)
 {
-  WrittenRanges.insert(object);
-  for (auto it = WrittenOffsets.begin(); it != WrittenOffsets.end(); ) {
-    if (it->first == object) {
-      WrittenOffsets.erase(it++);
-    } else {
-      ++it;
-    }
+  if (!ReadRanges.Contains(object)) {
+    ReadOffsets[object].Union(offsets);
   }
 }
 
 // -----------------------------------------------------------------------------
-void ReferenceGraph::Node::dump(llvm::raw_ostream &os) const
+void ReferenceGraph::Node::AddWrite(ID<Object> object)
 {
-  os << "\tindirect: " << HasIndirectCalls << "\n";
-  os << "\traise: " << HasRaise << "\n";
-  os << "\tbarrier: " << HasBarrier << "\n";
-  os << "\tread:\n";
-  for (Object *obj : ReadRanges) {
-    os << "\t\t";
-    for (Atom &atom : *obj) {
-      os << atom.getName() << " ";
-    }
-    os << "\n";
+  WrittenRanges.Insert(object);
+  WrittenOffsets.erase(object);
+}
+
+// -----------------------------------------------------------------------------
+void ReferenceGraph::Node::AddWrite(
+    ID<Object> object,
+    const OffsetSet &offsets)
+{
+  if (!WrittenRanges.Contains(object)) {
+    WrittenOffsets[object].Union(offsets);
   }
-  for (auto &[obj, offsets] : ReadOffsets) {
+}
+
+// -----------------------------------------------------------------------------
+void ReferenceGraph::dump(Func &func, llvm::raw_ostream &os)
+{
+  const Node &node = (*this)[func];
+
+  auto dumpObject = [&, this] (ID<Object> id) {
     os << "\t\t";
-    for (Atom &atom : *obj) {
+    for (Atom &atom : Map(id)) {
       os << atom.getName() << " ";
     }
+  };
+  auto dumpOffsets = [&] (const OffsetSet &offsets) {
     os << " + ";
     for (auto [start, end] : offsets) {
       os << start << "," << end << ":";
     }
     os << "\n";
+  };
+
+  os << "\tindirect: " << node.HasIndirectCalls << "\n";
+  os << "\traise: " << node.HasRaise << "\n";
+  os << "\tbarrier: " << node.HasBarrier << "\n";
+  os << "\tread:\n";
+  for (ID<Object> id : node.ReadRanges) {
+    dumpObject(id);
+    os << "\n";
+  }
+  for (auto &[id, offsets] : node.ReadOffsets) {
+    dumpObject(id);
+    dumpOffsets(offsets);
   }
   os << "\twritten:\n";
-  for (Object *obj : WrittenRanges) {
-    os << "\t\t";
-    for (Atom &atom : *obj) {
-      os << atom.getName() << " ";
-    }
+  for (ID<Object> id : node.WrittenRanges) {
+    dumpObject(id);
     os << "\n";
   }
-  for (auto &[obj, offsets] : WrittenOffsets) {
-    os << "\t\t";
-    for (Atom &atom : *obj) {
-      os << atom.getName() << " ";
+  for (auto &[id, offsets] : node.WrittenOffsets) {
+    dumpObject(id);
+    dumpOffsets(offsets);
+  }
+  if (!node.EscapedFuncs.Empty() ||
+      !node.EscapedObjects.Empty() ||
+      !node.EscapedExterns.Empty())
+  {
+    os << "\tescapes:\n";
+    for (ID<Func> id : node.EscapedFuncs) {
+      os << "\t" << Map(id).getName() << "\n";
     }
-    os << " + ";
-    for (auto [start, end] : offsets) {
-      os << start << "," << end << ":";
+    for (ID<Object> id : node.EscapedObjects) {
+      dumpObject(id);
+      os << "\n";
     }
-    os << "\n";
-  }
-  if (!Escapes.empty()) {
-    os << "\tcalled:\n";
-    for (auto *g : Escapes) {
-      os << "\t" << g->getName() << "\n";
+    for (ID<Extern> id : node.EscapedExterns) {
+      os << "\t" << externs_.Map(id)->getName() << "\n";
     }
   }
-  if (!Called.empty()) {
+  if (!node.Called.Empty()) {
     os << "\tcalled:\n";
-    for (auto *f : Called) {
-      os << "\t" << f->getName() << "\n";
+    for (ID<Func> id : node.Called) {
+      os << "\t" << Map(id).getName() << "\n";
     }
   }
-  if (!Blocks.empty()) {
+  if (!node.Blocks.Empty()) {
     os << "\tblocks:\n";
-    for (auto *b : Blocks) {
-      os << "\t" << b->getName() << "\n";
+    for (ID<Block> id : node.Blocks) {
+      os << "\t" << blocks_.Map(id)->getName() << "\n";
     }
   }
 }
 
 // -----------------------------------------------------------------------------
-ReferenceGraph::ReferenceGraph(Prog &prog, CallGraph &graph)
-  : graph_(graph)
+ReferenceGraph::ReferenceGraph(
+    Prog &prog,
+    CallGraphAnalysis &graph,
+    ThreadPool *pool)
+  : prog_(prog)
+  , graph_(graph)
+  , pool_(pool)
   , built_(false)
 {
 }
 
+// -----------------------------------------------------------------------------
+ReferenceGraph::~ReferenceGraph()
+{
+}
+
 // -----------------------------------------------------------------------------
 void ReferenceGraph::Build()
 {
-  for (auto it = llvm::scc_begin(&graph_); !it.isAtEnd(); ++it) {
+  // Number all symbols upfront, as they are looked up concurrently.
+  for (Func &func : prog_) {
+    funcs_.Add(&func);
+    for (Block &block : func) {
+      blocks_.Add(&block);
+    }
+  }
+  for (Data &data : prog_.data()) {
+    for (Object &object : data) {
+      objects_.Add(&object);
+    }
+  }
+  for (Extern &ext : prog_.externs()) {
+    externs_.Add(&ext);
+  }
+
+  // Create the nodes of all SCCs and find the length of the longest call
+  // chain below each of them. SCCs at the same depth do not call each other,
+  // thus they can be summarised independently once lower levels are done.
+  auto sccs = graph_.GetSCCs();
+  std::unordered_map<Func *, unsigned> funcToSCC;
+  std::vector<unsigned> depths(sccs.size(), 0);
+  std::vector<std::vector<unsigned>> levels;
+  for (unsigned i = 0, n = sccs.size(); i < n; ++i) {
     auto &node = *nodes_.emplace_back(std::make_unique<Node>());
-    for (auto *sccNode : *it) {
-      if (auto *func = sccNode->GetCaller()) {
-        ExtractReferences(*func, node);
+    for (Func *func : sccs[i]) {
+      funcToSCC.emplace(func, i);
+      funcToNode_.emplace(func, &node);
+    }
+
+    unsigned depth = 0;
+    for (Func *func : sccs[i]) {
+      for (Func *callee : graph_.GetCallees(*func)) {
+        // SCCs are in reverse topological order: callees come first.
+        auto it = funcToSCC.find(callee);
+        assert(it != funcToSCC.end() && "callee SCC not visited");
+        if (unsigned j = it->second; j != i) {
+          depth = std::max(depth, depths[j] + 1);
+        }
       }
     }
-    for (auto *sccNode : *it) {
-      if (auto *func = sccNode->GetCaller()) {
-        funcToNode_.emplace(func, &node);
+    depths[i] = depth;
+    if (depth >= levels.size()) {
+      levels.resize(depth + 1);
+    }
+    levels[depth].push_back(i);
+  }
+
+  // Summarise SCCs level by level.
+  for (const auto &level : levels) {
+    auto summarise = [&, this] (size_t i) {
+      auto &node = *nodes_[level[i]];
+      for (Func *func : sccs[level[i]]) {
+        ExtractReferences(*func, node);
+      }
+    };
+    if (pool_ && level.size() > 1) {
+      pool_->ParallelFor(level.size(), summarise);
+    } else {
+      for (size_t i = 0, n = level.size(); i < n; ++i) {
+        summarise(i);
       }
     }
   }
@@ -228,7 +289,9 @@ void ReferenceGraph::ExtractReferences(Func &func, Node &node)
       if (auto *call = ::cast_or_null<CallSite>(&inst)) {
         if (auto *func = call->GetDirectCallee()) {
           if (!Skip(*func)) {
-            if (auto it = funcToNode_.find(func); it != funcToNode_.end()) {
+            // Callees in the same SCC share the node.
+            auto it = funcToNode_.find(func);
+            if (it != funcToNode_.end() && it->second != &node) {
               node.Merge(*it->second);
             }
           }
@@ -242,19 +305,21 @@ void ReferenceGraph::ExtractReferences(Func &func, Node &node)
         {
           switch (g.GetKind()) {
             case Global::Kind::FUNC: {
+              auto id = GetID(static_cast<Func &>(g));
               if (HasIndirectUses(movInst)) {
-                node.Escapes.insert(&g);
+                node.EscapedFuncs.Insert(id);
               } else {
-                node.Called.insert(&static_cast<Func &>(g));
+                node.Called.Insert(id);
               }
               return;
             }
             case Global::Kind::BLOCK: {
-              node.Blocks.insert(&static_cast<Block &>(g));
+              node.Blocks.Insert(blocks_.GetID(&static_cast<Block &>(g)));
               return;
             }
             case Global::Kind::EXTERN: {
-              node.Escapes.insert(&g);
+              auto &ext = static_cast<Extern &>(g);
+              node.EscapedExterns.Insert(externs_.GetID(&ext));
               return;
             }
             case Global::Kind::ATOM: {
@@ -357,16 +422,15 @@ void ReferenceGraph::Classify(Object *o, const MovInst &inst, Node &node)
     }
   }
 
+  auto id = GetID(*o);
   if (escapes) {
-    for (Atom &atom : *o) {
-      node.Escapes.insert(&atom);
-    }
+    node.EscapedObjects.Insert(id);
   } else {
     if (loadCount) {
-      node.AddRead(o);
+      node.AddRead(id);
     }
     if (storeCount) {
-      node.AddWrite(o);
+      node.AddWrite(id);
     }
   }
 }
@@ -412,8 +476,8 @@ void ReferenceGraph::Classify(
     }
   };
 
-  std::set<std::pair<int64_t, int64_t>> loadedOffsets;
-  std::set<std::pair<int64_t, int64_t>> storedOffsets;
+  OffsetSet loadedOffsets;
+  OffsetSet storedOffsets;
   bool loadInaccurate = false;
   bool storeInaccurate = false;
   bool escapes = false;
@@ -435,9 +499,8 @@ void ReferenceGraph::Classify(
       case Inst::Kind::LOAD: {
         auto &load = static_cast<const LoadInst &>(*i);
         if (start) {
-          loadedOffsets.emplace(*start, *start + GetSize(load.GetType()));
+          loadedOffsets.Insert(*start, *start + GetSize(load.GetType()));
         } else {
-          loadedOffsets.clear();
           loadInaccurate = true;
         }
         continue;
@@ -449,9 +512,8 @@ void ReferenceGraph::Classify(
           escapes = true;
         } else {
           if (start) {
-            storedOffsets.emplace(*start, *start + GetSize(value.GetType()));
+            storedOffsets.Insert(*start, *start + GetSize(value.GetType()));
           } else {
-            storedOffsets.clear();
             storeInaccurate = true;
           }
         }
@@ -514,28 +576,19 @@ void ReferenceGraph::Classify(
     }
   }
 
+  auto id = GetID(*o);
   if (escapes) {
-    for (Atom &atom : *o) {
-      node.Escapes.insert(&atom);
-    }
+    node.EscapedObjects.Insert(id);
   } else {
-    if (loadInaccurate || !loadedOffsets.empty()) {
-      if (loadInaccurate) {
-        node.AddRead(o);
-      } else {
-        if (!node.ReadRanges.count(o)) {
-          node.ReadOffsets.emplace(o, std::move(loadedOffsets));
-        }
-      }
-    }
-    if (storeInaccurate || !storedOffsets.empty()) {
-      if (storeInaccurate) {
-        node.AddWrite(o);
-      } else {
-        if (!node.WrittenRanges.count(o)) {
-          node.WrittenOffsets.emplace(o, std::move(storedOffsets));
-        }
-      }
+    if (loadInaccurate) {
+      node.AddRead(id);
+    } else if (!loadedOffsets.Empty()) {
+      node.AddRead(id, loadedOffsets);
+    }
+    if (storeInaccurate) {
+      node.AddWrite(id);
+    } else if (!storedOffsets.Empty()) {
+      node.AddWrite(id, storedOffsets);
     }
   }
 }
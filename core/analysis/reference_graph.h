@@ -4,30 +4,39 @@
 
 #pragma once
 
+#include <cassert>
 #include <memory>
-#include <set>
-#include <unordered_set>
 #include <unordered_map>
 #include <vector>
+
 #include <llvm/Support/raw_ostream.h>
 
+#include "core/adt/bitset.h"
+#include "core/adt/offset_set.h"
+
 class Block;
-class CallGraph;
+class CallGraphAnalysis;
+class Extern;
 class Func;
-class Global;
 class Prog;
 class MovInst;
 class Object;
+class ThreadPool;
 
 
 
 /**
- * Set of start-end offsets for stores and loads.
+ * Mapping from objects to the offsets accessed in them.
  */
-using OffsetSet = std::set<std::pair<int64_t, int64_t>>;
+using ObjectOffsetMap = std::unordered_map<ID<Object>, OffsetSet>;
 
 /**
  * Class caching the set of symbols transitively referenced by a function.
+ *
+ * Symbols are numbered densely when the graph is built and summaries are
+ * kept as bit sets of their IDs. Summaries are computed bottom-up over the
+ * SCCs of the call graph: SCCs which do not depend on each other are
+ * summarised in parallel if a thread pool is available.
  */
 class ReferenceGraph {
 public:
@@ -39,43 +48,94 @@ public:
     bool HasRaise = false;
     /// Check whether there are barriers.
     bool HasBarrier = false;
-    /// Set of referenced symbols.
-    std::unordered_set<Object *> ReadRanges;
+    /// Set of objects read at unknown offsets.
+    BitSet<Object> ReadRanges;
     /// Set of referenced offsets in objects.
-    std::unordered_map<Object *, OffsetSet> ReadOffsets;
-    /// Set of written symbols.
-    std::unordered_set<Object *> WrittenRanges;
-    /// Set of written offsets in symbols.
-    std::unordered_map<Object *, OffsetSet> WrittenOffsets;
-    /// Set of symbols which escape.
-    std::unordered_set<Global *> Escapes;
+    ObjectOffsetMap ReadOffsets;
+    /// Set of objects written at unknown offsets.
+    BitSet<Object> WrittenRanges;
+    /// Set of written offsets in objects.
+    ObjectOffsetMap WrittenOffsets;
+    /// Set of functions whose address escapes.
+    BitSet<Func> EscapedFuncs;
+    /// Set of objects whose address escapes.
+    BitSet<Object> EscapedObjects;
+    /// Set of external symbols which escape.
+    BitSet<Extern> EscapedExterns;
     /// Set of called functions.
-    std::unordered_set<Func *> Called;
+    BitSet<Func> Called;
     /// Set of addressed blocks.
-    std::unordered_set<Block *> Blocks;
+    BitSet<Block> Blocks;
 
     /// Merge another node into this one.
     void Merge(const Node &that);
     /// Add an inaccurate read.
-    void AddRead(Object *object);
+    void AddRead(ID<Object> object);
+    /// Add reads at known offsets.
+    void AddRead(ID<Object> object, const OffsetSet &offsets);
     /// Add an inaccurate write.
-    void AddWrite(Object *object);
-
-    /// Dump a representation of the node.
-    void dump(llvm::raw_ostream &os) const;
+    void AddWrite(ID<Object> object);
+    /// Add writes at known offsets.
+    void AddWrite(ID<Object> object, const OffsetSet &offsets);
   };
 
   /// Build reference information.
-  ReferenceGraph(Prog &prog, CallGraph &graph);
+  ReferenceGraph(
+      Prog &prog,
+      CallGraphAnalysis &graph,
+      ThreadPool *pool = nullptr
+  );
+
+  /// Cleanup.
+  virtual ~ReferenceGraph();
 
   /// Return the set of globals referenced by a function.
   const Node &operator[](Func &func);
 
+  /// Returns the ID of a function.
+  ID<Func> GetID(Func &func) const { return funcs_.GetID(&func); }
+  /// Returns the ID of an object.
+  ID<Object> GetID(Object &object) const { return objects_.GetID(&object); }
+  /// Returns the function with a given ID.
+  Func &Map(ID<Func> id) const { return *funcs_.Map(id); }
+  /// Returns the object with a given ID.
+  Object &Map(ID<Object> id) const { return *objects_.Map(id); }
+
+  /// Dump the summary of a function.
+  void dump(Func &func, llvm::raw_ostream &os = llvm::errs());
+
 protected:
   /// Callback which decides whether to follow or skip a function.
   virtual bool Skip(Func &func) { return false; }
 
 private:
+  /// Dense numbering of symbols of a kind.
+  template<typename T>
+  class SymbolIndex {
+  public:
+    /// Assigns the next ID to a symbol.
+    void Add(T *item)
+    {
+      ids_.emplace(item, items_.size());
+      items_.push_back(item);
+    }
+    /// Returns the ID of a symbol.
+    ID<T> GetID(T *item) const
+    {
+      auto it = ids_.find(item);
+      assert(it != ids_.end() && "symbol not indexed");
+      return it->second;
+    }
+    /// Returns the symbol with a given ID.
+    T *Map(ID<T> id) const { return items_[id]; }
+
+  private:
+    /// Symbols, indexed by ID.
+    std::vector<T *> items_;
+    /// Mapping from symbols to IDs.
+    std::unordered_map<T *, ID<T>> ids_;
+  };
+
   /// Extract the properties of a single function.
   void ExtractReferences(Func &func, Node &node);
   /// Build the graph.
@@ -86,8 +146,20 @@ private:
   void Classify(Object *o, const MovInst &inst, Node &node, int64_t offset);
 
 private:
+  /// Program to analyse.
+  Prog &prog_;
   /// Call graph of the program.
-  CallGraph &graph_;
+  CallGraphAnalysis &graph_;
+  /// Thread pool to summarise SCCs with, if available.
+  ThreadPool *pool_;
+  /// IDs of functions.
+  SymbolIndex<Func> funcs_;
+  /// IDs of objects.
+  SymbolIndex<Object> objects_;
+  /// IDs of external symbols.
+  SymbolIndex<Extern> externs_;
+  /// IDs of blocks.
+  SymbolIndex<Block> blocks_;
   /// Mapping from functions to nodes.
   std::unordered_map<Func *, Node *> funcToNode_;
   /// List of all nodes.
@@ -95,14 +167,3 @@ private:
   /// Flag to indicate whether graph was built.
   bool built_;
 };
-
-/**
- * Helper to print a node.
- */
-inline llvm::raw_ostream &operator<<(
-    llvm::raw_ostream &os,
-    const ReferenceGraph::Node &node)
-{
-  node.dump(os);
-  return os;
-}
@@ -2,8 +2,13 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <cassert>
+#include <mutex>
+#include <unordered_set>
+
 #include <llvm/Support/ErrorHandling.h>
 
+#include "core/adt/hash.h"
 #include "core/annot.h"
 
 
@@ -35,26 +40,16 @@ AnnotSet::AnnotSet()
 
 // -----------------------------------------------------------------------------
 AnnotSet::AnnotSet(AnnotSet &&that)
-  : annots_(std::move(that.annots_))
+  : frame_(std::move(that.frame_))
+  , probability_(std::move(that.probability_))
 {
 }
 
 // -----------------------------------------------------------------------------
 AnnotSet::AnnotSet(const AnnotSet &that)
+  : frame_(that.frame_)
+  , probability_(that.probability_)
 {
-  for (const Annot &annot : that) {
-    switch (annot.GetKind()) {
-      case Annot::Kind::CAML_FRAME: {
-        Set<CamlFrame>(static_cast<const CamlFrame &>(annot));
-        continue;
-      }
-      case Annot::Kind::PROBABILITY: {
-        Set<Probability>(static_cast<const Probability &>(annot));
-        continue;
-      }
-    }
-    llvm_unreachable("invalid annotation kind");
-  }
 }
 
 // -----------------------------------------------------------------------------
@@ -79,38 +74,84 @@ bool AnnotSet::Add(const Annot &newAnnot)
 // -----------------------------------------------------------------------------
 bool AnnotSet::operator==(const AnnotSet &that) const
 {
-  for (const Annot &thisAnnot : annots_) {
-    bool found = false;
-    for (const Annot &thatAnnot : that.annots_) {
-      if (thisAnnot == thatAnnot) {
-        found = true;
-        continue;
-      }
-    }
-    if (!found) {
-      return false;
-    }
+  return frame_ == that.frame_ && probability_ == that.probability_;
+}
+
+// -----------------------------------------------------------------------------
+AnnotSet &AnnotSet::operator=(AnnotSet &&that)
+{
+  if (that.frame_) {
+    frame_ = std::move(that.frame_);
   }
-  for (const Annot &thatAnnot : that.annots_) {
-    bool found = false;
-    for (const Annot &thisAnnot : annots_) {
-      if (thisAnnot == thatAnnot) {
-        found = true;
-        continue;
-      }
+  if (that.probability_) {
+    probability_ = std::move(that.probability_);
+  }
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+const Annot *AnnotSet::Next(const Annot *annot) const
+{
+  if (!annot) {
+    if (frame_) {
+      return &*frame_;
     }
-    if (!found) {
-      return false;
+  }
+  if (!annot || annot->Is(Annot::Kind::CAML_FRAME)) {
+    if (probability_) {
+      return &*probability_;
     }
   }
-  return true;
+  return nullptr;
 }
 
 // -----------------------------------------------------------------------------
-AnnotSet &AnnotSet::operator=(AnnotSet &&that)
+namespace {
+/// Hash for debug information bundles.
+struct DebugInfosHash {
+  size_t operator()(const CamlFrame::DebugInfos &infos) const
+  {
+    size_t hash = 0;
+    for (const auto &debug : infos) {
+      ::hash_combine(hash, std::hash<int64_t>{}(debug.Location));
+      ::hash_combine(hash, std::hash<std::string>{}(debug.File));
+      ::hash_combine(hash, std::hash<std::string>{}(debug.Definition));
+    }
+    return hash;
+  }
+};
+
+/// Table of interned frame contents.
+template <typename Data>
+struct FrameTable {
+  /// Hash for frame contents.
+  struct DataHash {
+    size_t operator()(const Data &data) const
+    {
+      size_t hash = 0;
+      for (size_t alloc : data.Allocs) {
+        ::hash_combine(hash, std::hash<size_t>{}(alloc));
+      }
+      for (const auto *debug : data.Debug) {
+        ::hash_combine(hash, std::hash<const void *>{}(debug));
+      }
+      return hash;
+    }
+  };
+
+  /// Lock protecting the tables.
+  std::mutex Lock;
+  /// Unique debug information bundles.
+  std::unordered_set<CamlFrame::DebugInfos, DebugInfosHash> Debug;
+  /// Unique frame contents.
+  std::unordered_set<Data, DataHash> Frames;
+};
+} // end namespace
+
+// -----------------------------------------------------------------------------
+CamlFrame::CamlFrame()
+  : CamlFrame({}, {})
 {
-  annots_.splice(annots_.end(), that.annots_);
-  return *this;
 }
 
 // -----------------------------------------------------------------------------
@@ -118,15 +159,25 @@ CamlFrame::CamlFrame(
     std::vector<size_t> &&allocs,
     std::vector<DebugInfos> &&debug_infos)
   : Annot(Kind::CAML_FRAME)
-  , allocs_(std::move(allocs))
-  , debug_infos_(std::move(debug_infos))
+  , data_(Intern(std::move(allocs), std::move(debug_infos)))
 {
 }
 
 // -----------------------------------------------------------------------------
-bool CamlFrame::operator==(const CamlFrame &that) const
+const CamlFrame::Data *CamlFrame::Intern(
+    std::vector<size_t> &&allocs,
+    std::vector<DebugInfos> &&debug_infos)
 {
-  return allocs_ == that.allocs_ && debug_infos_ == that.debug_infos_;
+  // The table is leaked: interned data is referenced until the very end.
+  static auto *table = new FrameTable<Data>();
+  std::lock_guard<std::mutex> guard(table->Lock);
+
+  Data data;
+  data.Allocs = std::move(allocs);
+  for (auto &debug : debug_infos) {
+    data.Debug.push_back(&*table->Debug.insert(std::move(debug)).first);
+  }
+  return &*table->Frames.insert(std::move(data)).first;
 }
 
 // -----------------------------------------------------------------------------
@@ -4,17 +4,21 @@
 
 #pragma once
 
-#include <llvm/ADT/ilist_node.h>
-#include <llvm/ADT/ilist.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/iterator.h>
 #include <llvm/ADT/iterator_range.h>
 
 
 /**
  * Base class for annotations.
  */
-class Annot : public llvm::ilist_node<Annot> {
+class Annot {
 public:
-  enum class Kind {
+  enum class Kind : uint8_t {
     CAML_FRAME  = 0,
     PROBABILITY = 1,
   };
@@ -36,126 +40,12 @@ private:
   Kind kind_;
 };
 
-
-/**
- * Class representing a set of annotations.
- */
-class AnnotSet {
-private:
-  /// Underlying annotation list.
-  using AnnotListType = llvm::ilist<Annot>;
-
-public:
-  /// Iterator over the annotations.
-  using iterator = AnnotListType::iterator;
-  using const_iterator = AnnotListType::const_iterator;
-
-public:
-  /// Creats a new, empty annotation set.
-  AnnotSet();
-  /// Moves an annotation set.
-  AnnotSet(AnnotSet &&that);
-  /// Copies an annotation set.
-  AnnotSet(const AnnotSet &that);
-
-  /// Destroys the annotation set.
-  ~AnnotSet();
-
-  /**
-   * Checks if an annotation is set.
-   */
-  template<typename T>
-  bool Has() const
-  {
-    for (auto &annot : annots_) {
-      if (annot.Is(T::kAnnotKind)) {
-        return true;
-      }
-    }
-    return false;
-  }
-
-  /**
-   * Creates an annotation.
-   *
-   * @return false if an annotation of the same kind exists.
-   */
-  template<typename T, typename... Args>
-  bool Set(Args&&... args)
-  {
-    for (auto &annot : annots_) {
-      if (annot.Is(T::kAnnotKind)) {
-        return false;
-      }
-    }
-
-    annots_.push_back(new T(std::move(args)...));
-    return true;
-  }
-
-  /**
-   * Clears an annotation.
-   */
-  template<typename T>
-  bool Clear()
-  {
-    for (auto it = annots_.begin(); it != annots_.end(); ) {
-      auto jt = it++;
-      if (jt->Is(T::kAnnotKind)) {
-        annots_.erase(jt);
-        return true;
-      }
-    }
-    return false;
-  }
-
-  /**
-   * Returns a pointer to an annotation.
-   */
-  template<typename T>
-  const T *Get() const
-  {
-    for (auto it = annots_.begin(); it != annots_.end(); ++it) {
-      if (it->Is(T::kAnnotKind)) {
-        return static_cast<const T *>(&*it);
-      }
-    }
-    return nullptr;
-  }
-
-  /**
-   * Adds an annotation to this set.
-   */
-  bool Add(const Annot &annot);
-
-  /// Compares two annotations sets for equality.
-  bool operator == (const AnnotSet &that) const;
-  /// Compares two annotations sets for inequality.
-  bool operator != (const AnnotSet &that) const { return !(*this == that); }
-
-  /// Assigns annotation from a different set.
-  AnnotSet &operator=(AnnotSet &&that);
-
-  /// Returns the number of set annotations.
-  size_t size() const { return annots_.size(); }
-  /// Checks if there are any annotations set.
-  bool empty() const { return annots_.empty(); }
-  /// Iterator to the first annotation.
-  iterator begin() { return annots_.begin(); }
-  /// Iterator past the last annotation.
-  iterator end() { return annots_.end(); }
-  /// Constant iterator to the first annotation.
-  const_iterator begin() const { return annots_.begin(); }
-  /// Constant iterator past the last annotation.
-  const_iterator end() const { return annots_.end(); }
-
-private:
-  /// Mask indicating which annotations are set.
-  AnnotListType annots_;
-};
-
 /**
  * OCaml: annotates an instruction which has an entry in the frame table.
+ *
+ * The allocation sizes and debug information are immutable and interned in
+ * a process-wide table, thus copies of the annotation share them and
+ * identical frames are stored only once.
  */
 class CamlFrame final : public Annot {
 public:
@@ -192,11 +82,13 @@ public:
   /// Iterator over allocations.
   using const_alloc_iterator = std::vector<size_t>::const_iterator;
   /// Iterator over debug infos.
-  using const_debug_infos_iterator = std::vector<DebugInfos>::const_iterator;
+  using const_debug_infos_iterator = llvm::pointee_iterator
+      < std::vector<const DebugInfos *>::const_iterator
+      >;
 
 public:
   /// Constructs an annotation without debug info.
-  CamlFrame() : Annot(Kind::CAML_FRAME) {}
+  CamlFrame();
   /// Constructs an annotation with debug info.
   CamlFrame(
       std::vector<size_t> &&allocs,
@@ -204,29 +96,50 @@ public:
   );
 
   /// Returns the number of allocations.
-  size_t alloc_size() const { return allocs_.size(); }
+  size_t alloc_size() const { return data_->Allocs.size(); }
   /// Iterator over allocations.
   llvm::iterator_range<const_alloc_iterator> allocs() const
   {
-    return { allocs_.begin(), allocs_.end() };
+    return { data_->Allocs.begin(), data_->Allocs.end() };
   }
 
   /// Returns the number of debug infos.
-  size_t debug_info_size() const { return debug_infos_.size(); }
+  size_t debug_info_size() const { return data_->Debug.size(); }
   /// Iterator over debug information bundles.
   llvm::iterator_range<const_debug_infos_iterator> debug_infos() const
   {
-    return { debug_infos_.begin(), debug_infos_.end() };
+    return {
+        const_debug_infos_iterator(data_->Debug.begin()),
+        const_debug_infos_iterator(data_->Debug.end())
+    };
   }
 
   /// Checks if two annotations are equal.
-  bool operator==(const CamlFrame &annot) const;
+  bool operator==(const CamlFrame &that) const { return data_ == that.data_; }
+
+private:
+  /// Interned contents of a frame.
+  struct Data {
+    /// Sizes of the underlying allocations.
+    std::vector<size_t> Allocs;
+    /// Interned debug information bundles.
+    std::vector<const DebugInfos *> Debug;
+
+    bool operator==(const Data &that) const
+    {
+      return Allocs == that.Allocs && Debug == that.Debug;
+    }
+  };
+
+  /// Interns the contents of a frame.
+  static const Data *Intern(
+      std::vector<size_t> &&allocs,
+      std::vector<DebugInfos> &&debug_infos
+  );
 
 private:
-  /// Sizes of the underlying allocations.
-  std::vector<size_t> allocs_;
-  /// Debug information objects.
-  std::vector<DebugInfos> debug_infos_;
+  /// Shared, interned contents.
+  const Data *data_;
 };
 
 /**
@@ -254,3 +167,163 @@ private:
   /// Denominator.
   uint32_t d_;
 };
+
+
+/**
+ * Class representing a set of annotations.
+ *
+ * Each kind of annotation has an inline slot, thus sets are copied
+ * without allocating. Annotations are visited in the order of their kinds.
+ */
+class AnnotSet {
+public:
+  /// Iterator over the annotations.
+  class const_iterator : public llvm::iterator_facade_base
+      < const_iterator
+      , std::forward_iterator_tag
+      , const Annot
+      >
+  {
+  public:
+    bool operator==(const const_iterator &that) const
+    {
+      return annot_ == that.annot_;
+    }
+
+    const Annot &operator*() const { return *annot_; }
+
+    const_iterator &operator++()
+    {
+      annot_ = set_->Next(annot_);
+      return *this;
+    }
+
+  private:
+    friend class AnnotSet;
+
+    const_iterator(const AnnotSet *set, const Annot *annot)
+      : set_(set)
+      , annot_(annot)
+    {
+    }
+
+  private:
+    /// Set being iterated.
+    const AnnotSet *set_;
+    /// Current annotation.
+    const Annot *annot_;
+  };
+
+  using iterator = const_iterator;
+
+public:
+  /// Creats a new, empty annotation set.
+  AnnotSet();
+  /// Moves an annotation set.
+  AnnotSet(AnnotSet &&that);
+  /// Copies an annotation set.
+  AnnotSet(const AnnotSet &that);
+
+  /// Destroys the annotation set.
+  ~AnnotSet();
+
+  /**
+   * Checks if an annotation is set.
+   */
+  template<typename T>
+  bool Has() const
+  {
+    return Slot<T>().has_value();
+  }
+
+  /**
+   * Creates an annotation.
+   *
+   * @return false if an annotation of the same kind exists.
+   */
+  template<typename T, typename... Args>
+  bool Set(Args&&... args)
+  {
+    auto &slot = Slot<T>();
+    if (slot) {
+      return false;
+    }
+    slot.emplace(std::forward<Args>(args)...);
+    return true;
+  }
+
+  /**
+   * Clears an annotation.
+   */
+  template<typename T>
+  bool Clear()
+  {
+    auto &slot = Slot<T>();
+    if (!slot) {
+      return false;
+    }
+    slot.reset();
+    return true;
+  }
+
+  /**
+   * Returns a pointer to an annotation.
+   */
+  template<typename T>
+  const T *Get() const
+  {
+    auto &slot = Slot<T>();
+    return slot ? &*slot : nullptr;
+  }
+
+  /**
+   * Adds an annotation to this set.
+   */
+  bool Add(const Annot &annot);
+
+  /// Compares two annotations sets for equality.
+  bool operator == (const AnnotSet &that) const;
+  /// Compares two annotations sets for inequality.
+  bool operator != (const AnnotSet &that) const { return !(*this == that); }
+
+  /// Assigns annotation from a different set.
+  AnnotSet &operator=(AnnotSet &&that);
+
+  /// Returns the number of set annotations.
+  size_t size() const { return !!frame_ + !!probability_; }
+  /// Checks if there are any annotations set.
+  bool empty() const { return !frame_ && !probability_; }
+  /// Iterator to the first annotation.
+  const_iterator begin() const { return const_iterator(this, Next(nullptr)); }
+  /// Iterator past the last annotation.
+  const_iterator end() const { return const_iterator(this, nullptr); }
+
+private:
+  /// Returns the slot of an annotation kind.
+  template<typename T>
+  std::optional<T> &Slot()
+  {
+    if constexpr (std::is_same<T, CamlFrame>::value) {
+      return frame_;
+    } else {
+      static_assert(std::is_same<T, Probability>::value, "invalid kind");
+      return probability_;
+    }
+  }
+
+  /// Returns the slot of an annotation kind.
+  template<typename T>
+  const std::optional<T> &Slot() const
+  {
+    return const_cast<AnnotSet *>(this)->Slot<T>();
+  }
+
+  /// Returns the annotation following another one, in order of kinds.
+  const Annot *Next(const Annot *annot) const;
+
+private:
+  /// OCaml frame annotation.
+  std::optional<CamlFrame> frame_;
+  /// Branch probability annotation.
+  std::optional<Probability> probability_;
+};
@@ -0,0 +1,190 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <llvm/Support/EndianStream.h>
+#include <llvm/Support/LEB128.h>
+#include <llvm/Support/xxhash.h>
+
+#include "core/archive_index.h"
+#include "core/bitcode.h"
+#include "core/cast.h"
+#include "core/extern.h"
+#include "core/prog.h"
+#include "core/util.h"
+
+
+
+/// Magic number identifying the index.
+static constexpr uint32_t kIndexMagic = 0x32444E49;
+
+// -----------------------------------------------------------------------------
+void ArchiveIndex::Add(llvm::StringRef name, llvm::StringRef buffer)
+{
+  Member &member = members_.emplace_back();
+  member.Name = name.str();
+  member.Size = buffer.size();
+  member.Hash = llvm::xxHash64(buffer);
+  if (!IsLLIRObject(buffer)) {
+    return;
+  }
+
+  auto prog = BitcodeReader(buffer).ReadLazy();
+  for (Global *g : prog->globals()) {
+    if (auto *ext = ::cast_or_null<Extern>(g); ext && !ext->HasValue()) {
+      member.Undefined.emplace_back(g->GetName());
+    } else {
+      member.Defined.emplace_back(g->GetName());
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+const ArchiveIndex::Member *
+ArchiveIndex::Find(
+    unsigned index,
+    llvm::StringRef name,
+    llvm::StringRef buffer) const
+{
+  if (index >= members_.size()) {
+    return nullptr;
+  }
+  // Members replaced in place keep their name, compare contents as well.
+  const Member &member = members_[index];
+  if (member.Name != name || member.Size != buffer.size()) {
+    return nullptr;
+  }
+  if (member.Hash != llvm::xxHash64(buffer)) {
+    return nullptr;
+  }
+  return &member;
+}
+
+// -----------------------------------------------------------------------------
+void ArchiveIndex::Write(llvm::raw_ostream &os) const
+{
+  auto writeString = [&os](llvm::StringRef str) {
+    llvm::encodeULEB128(str.size(), os);
+    os << str;
+  };
+  auto writeStrings = [&](llvm::ArrayRef<std::string> strs) {
+    llvm::encodeULEB128(strs.size(), os);
+    for (const std::string &str : strs) {
+      writeString(str);
+    }
+  };
+
+  llvm::support::endian::write<uint32_t>(
+      os,
+      kIndexMagic,
+      llvm::support::little
+  );
+  llvm::encodeULEB128(members_.size(), os);
+  for (const Member &member : members_) {
+    writeString(member.Name);
+    llvm::encodeULEB128(member.Size, os);
+    llvm::encodeULEB128(member.Hash, os);
+    writeStrings(member.Defined);
+    writeStrings(member.Undefined);
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::optional<ArchiveIndex> ArchiveIndex::Read(llvm::StringRef buffer)
+{
+  if (buffer.size() < sizeof(uint32_t)) {
+    return std::nullopt;
+  }
+  if (ReadData<uint32_t>(buffer, 0) != kIndexMagic) {
+    return std::nullopt;
+  }
+
+  const uint8_t *ptr = buffer.bytes_begin() + sizeof(uint32_t);
+  const uint8_t *end = buffer.bytes_end();
+  auto readInt = [&](uint64_t &n) {
+    const char *error = nullptr;
+    unsigned size = 0;
+    n = llvm::decodeULEB128(ptr, &size, end, &error);
+    ptr += size;
+    return error == nullptr;
+  };
+  auto readString = [&](std::string &str) {
+    uint64_t size;
+    if (!readInt(size) || size > static_cast<uint64_t>(end - ptr)) {
+      return false;
+    }
+    str.assign(reinterpret_cast<const char *>(ptr), size);
+    ptr += size;
+    return true;
+  };
+  auto readStrings = [&](std::vector<std::string> &strs) {
+    uint64_t n;
+    if (!readInt(n) || n > static_cast<uint64_t>(end - ptr)) {
+      return false;
+    }
+    strs.resize(n);
+    for (std::string &str : strs) {
+      if (!readString(str)) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  ArchiveIndex index;
+  uint64_t n;
+  if (!readInt(n) || n > static_cast<uint64_t>(end - ptr)) {
+    return std::nullopt;
+  }
+  index.members_.resize(n);
+  for (Member &member : index.members_) {
+    if (!readString(member.Name) ||
+        !readInt(member.Size) ||
+        !readInt(member.Hash) ||
+        !readStrings(member.Defined) ||
+        !readStrings(member.Undefined))
+    {
+      return std::nullopt;
+    }
+  }
+  return index;
+}
+
+// -----------------------------------------------------------------------------
+llvm::Error WriteIndexedArchive(
+    llvm::StringRef path,
+    std::vector<llvm::NewArchiveMember> &&members,
+    std::unique_ptr<llvm::MemoryBuffer> &&oldArchive,
+    llvm::object::Archive::Kind kind)
+{
+  // Index all members, dropping the previous index.
+  ArchiveIndex index;
+  std::vector<llvm::NewArchiveMember> indexed(1);
+  for (auto &member : members) {
+    if (member.MemberName == ArchiveIndex::kName) {
+      continue;
+    }
+    index.Add(member.MemberName, member.Buf->getBuffer());
+    indexed.emplace_back(std::move(member));
+  }
+
+  // Place the index first, for the linker to find it quickly.
+  std::string buffer;
+  {
+    llvm::raw_string_ostream os(buffer);
+    index.Write(os);
+  }
+  indexed[0] = llvm::NewArchiveMember(
+      llvm::MemoryBufferRef(buffer, ArchiveIndex::kName)
+  );
+
+  return llvm::writeArchive(
+      path,
+      indexed,
+      false,
+      kind,
+      true,
+      false,
+      std::move(oldArchive)
+  );
+}
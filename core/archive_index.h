@@ -0,0 +1,83 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/raw_ostream.h>
+
+
+
+/**
+ * Index of the symbols of the LLIR objects in an archive.
+ *
+ * The index is stored as the first member of the archive. Entries follow
+ * the order of the remaining members and they are checked against the name,
+ * the size and a hash of the contents of members, thus an index gone stale
+ * after an update by another tool is detected and ignored. The linker relies on it to select the members to
+ * decode without reading their symbol tables.
+ */
+class ArchiveIndex final {
+public:
+  /// Name of the archive member holding the index.
+  static constexpr const char *kName = "__.LLIRSYMDEF";
+
+  /// Symbols of an archive member.
+  struct Member {
+    /// Name of the member.
+    std::string Name;
+    /// Size of the member.
+    uint64_t Size;
+    /// Hash of the contents of the member.
+    uint64_t Hash;
+    /// Symbols defined by the member.
+    std::vector<std::string> Defined;
+    /// Symbols referenced, but not defined by the member.
+    std::vector<std::string> Undefined;
+  };
+
+public:
+  /// Adds a member, recording symbols if it is an LLIR object.
+  void Add(llvm::StringRef name, llvm::StringRef buffer);
+
+  /// Finds the entry of a member, checking its name and contents.
+  const Member *Find(
+      unsigned index,
+      llvm::StringRef name,
+      llvm::StringRef buffer
+  ) const;
+
+  /// Writes the index to a stream.
+  void Write(llvm::raw_ostream &os) const;
+  /// Reads an index, returning nothing if it is malformed.
+  static std::optional<ArchiveIndex> Read(llvm::StringRef buffer);
+
+  /// Returns the entries of the members.
+  llvm::ArrayRef<Member> members() const { return members_; }
+
+private:
+  /// Entries for all members, in order.
+  std::vector<Member> members_;
+};
+
+/**
+ * Writes an archive, preceded by the index of its LLIR members.
+ *
+ * An index already present among the members is replaced.
+ */
+llvm::Error WriteIndexedArchive(
+    llvm::StringRef path,
+    std::vector<llvm::NewArchiveMember> &&members,
+    std::unique_ptr<llvm::MemoryBuffer> &&oldArchive,
+    llvm::object::Archive::Kind kind = llvm::object::Archive::K_GNU
+);
@@ -5,7 +5,10 @@
 #pragma once
 
 #include <tuple>
+#include <unordered_map>
 #include <vector>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/MemoryBuffer.h>
 
@@ -30,15 +33,55 @@ class Xtor;
 
 /**
  * Helper class to deserialise a program from a binary format.
+ *
+ * Symbols are decoded upfront, while the bodies of functions and atoms are
+ * located through a table of contents and can be decoded on demand. Strings
+ * are viewed directly in the buffer, which must outlive the reader.
+ *
+ * Both the current revision and the first one, which encodes integers with
+ * fixed widths and strings inline, are accepted. Files written before
+ * revisions were introduced are decoded eagerly, as they lack a table of
+ * contents.
+ *
+ * Function bodies are independent of each other: given multiple threads,
+ * they are decoded concurrently by readers sharing the tables of symbols.
  */
 class BitcodeReader final {
 public:
-  BitcodeReader(llvm::StringRef buf) : buf_(buf), offset_(0) {}
+  BitcodeReader(llvm::StringRef buf, unsigned threads = 1)
+    : buf_(buf)
+    , offset_(0)
+    , version_(0)
+    , threads_(threads)
+    , owner_(this)
+  {
+  }
 
   /// Read a program from the stream.
   std::unique_ptr<Prog> Read();
+  /// Read the symbols of a program, deferring the bodies.
+  std::unique_ptr<Prog> ReadLazy();
+
+  /// Decode the body of a function, if it was deferred.
+  void Materialize(Func &func);
+  /// Decode the body of an atom, if it was deferred.
+  void Materialize(Atom &atom);
+  /// Decode all deferred bodies.
+  void MaterializeAll();
+  /// Checks whether all bodies were decoded.
+  bool IsMaterialized() const { return pending_.empty(); }
 
 private:
+  /// Creates a reader for a body, sharing the tables of its owner.
+  BitcodeReader(const BitcodeReader &owner, uint64_t offset)
+    : buf_(owner.buf_)
+    , offset_(offset)
+    , version_(owner.version_)
+    , threads_(1)
+    , owner_(&owner)
+  {
+  }
+
   /// Read a function.
   void Read(Func &func);
   /// Read an atom.
@@ -48,10 +91,16 @@ private:
 
   /// Read a primitive from the file.
   template<typename T> T ReadData();
+  /// Read a fixed-width primitive from the file.
+  template<typename T> T ReadFixed();
+  /// Read a variable-length integer from the file.
+  template<typename T> T ReadVarInt();
   /// Read an optional value from the file.
   template<typename T> std::optional<T> ReadOptional();
-  /// Emit a string.
-  std::string ReadString();
+  /// Read a string, pointing into the buffer.
+  std::string_view ReadString();
+  /// Moves to the deferred body of a global, returning false if decoded.
+  bool Seek(const Global &g);
   /// Read an instruction.
   Inst *ReadInst(
       const std::vector<Ref<Inst>> &map,
@@ -83,22 +132,54 @@ private:
   llvm::StringRef buf_;
   /// Offset into the buffer.
   uint64_t offset_;
+  /// Revision of the format.
+  uint32_t version_;
+  /// Number of threads decoding functions.
+  unsigned threads_;
+  /// Reader owning the tables of strings and globals.
+  const BitcodeReader *owner_;
+  /// Table of strings.
+  std::vector<std::string_view> strings_;
   /// Mapping from offsets to globals.
   std::vector<Global *> globals_;
+  /// Functions and atoms, in the order of their bodies.
+  std::vector<Global *> bodies_;
+  /// Offsets of the bodies which were not yet decoded.
+  std::unordered_map<const Global *, uint64_t> pending_;
 };
 
 
 /**
  * Helper class to serialise the program into a binary format.
+ *
+ * Integers are encoded as LEB128 and instructions refer to their operands
+ * through the distance to them. Strings are deduplicated into a table which
+ * precedes the program, thus the program is buffered until written out.
+ * Given multiple threads, functions are encoded into separate buffers.
  */
 class BitcodeWriter final {
 public:
-  BitcodeWriter(llvm::raw_pwrite_stream &os) : os_(os) {}
+  BitcodeWriter(llvm::raw_pwrite_stream &os, unsigned threads = 1)
+    : os_(os)
+    , body_(buffer_)
+    , threads_(threads)
+    , owner_(this)
+  {
+  }
 
   /// Write a program to the stream.
   void Write(const Prog &prog);
 
 private:
+  /// Creates a writer for a function, sharing the tables of its owner.
+  BitcodeWriter(const BitcodeWriter &owner)
+    : os_(owner.os_)
+    , body_(buffer_)
+    , threads_(1)
+    , owner_(&owner)
+  {
+  }
+
   /// Write a function to the stream.
   void Write(const Func &prog);
   /// Write an atom to the stream.
@@ -142,6 +223,8 @@ private:
 
   /// Emit a string ref.
   void Emit(llvm::StringRef str);
+  /// Adds a string to the table, returning its ID.
+  unsigned Intern(llvm::StringRef str);
   /// Emit a C++ string.
   void Emit(const std::string &str) { return Emit(llvm::StringRef(str)); }
   /// Write a primitive to the file.
@@ -150,6 +233,22 @@ private:
 private:
   /// Mapping from symbols to IDs.
   std::unordered_map<const Global *, unsigned> symbols_;
+  /// Mapping from strings to IDs.
+  llvm::StringMap<unsigned> stringIDs_;
+  /// Strings, in the order of their IDs.
+  std::vector<llvm::StringRef> strings_;
+  /// Number of the next value defined in a function.
+  unsigned next_ = 0;
   /// Stream to write to.
   llvm::raw_pwrite_stream &os_;
+  /// Buffer holding the encoded program.
+  llvm::SmallVector<char, 0> buffer_;
+  /// Stream writing to the buffer.
+  llvm::raw_svector_ostream body_;
+  /// Number of threads encoding functions.
+  unsigned threads_;
+  /// Writer owning the tables of strings and symbols.
+  const BitcodeWriter *owner_;
+  /// Set once the strings of functions are registered: no more are added.
+  bool sealed_ = false;
 };
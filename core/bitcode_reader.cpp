@@ -2,8 +2,14 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <limits>
+
 #include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/Support/LEB128.h>
+#include <llvm/Support/TimeProfiler.h>
 
+#include "core/adt/slab.h"
+#include "core/adt/thread_pool.h"
 #include "core/bitcode.h"
 #include "core/block.h"
 #include "core/cast.h"
@@ -13,12 +19,24 @@
 #include "core/func.h"
 #include "core/insts.h"
 #include "core/prog.h"
+#include "core/use.h"
 #include "core/xtor.h"
 
 namespace endian = llvm::support::endian;
 
 // -----------------------------------------------------------------------------
 template<typename T> T BitcodeReader::ReadData()
+{
+  if constexpr (std::is_integral<T>::value && sizeof(T) > 1) {
+    if (version_ >= 2) {
+      return ReadVarInt<T>();
+    }
+  }
+  return ReadFixed<T>();
+}
+
+// -----------------------------------------------------------------------------
+template<typename T> T BitcodeReader::ReadFixed()
 {
   if (offset_ + sizeof(T) > buf_.size()) {
     llvm::report_fatal_error("invalid bitcode file");
@@ -29,6 +47,31 @@ template<typename T> T BitcodeReader::ReadData()
   return endian::read<T, llvm::support::little, 1>(data);
 }
 
+// -----------------------------------------------------------------------------
+template<typename T> T BitcodeReader::ReadVarInt()
+{
+  auto *ptr = reinterpret_cast<const uint8_t *>(buf_.data() + offset_);
+  auto *end = reinterpret_cast<const uint8_t *>(buf_.data() + buf_.size());
+  const char *error = nullptr;
+  unsigned n = 0;
+  if constexpr (std::is_signed<T>::value) {
+    int64_t v = llvm::decodeSLEB128(ptr, &n, end, &error);
+    if (error || v < std::numeric_limits<T>::min() ||
+        v > std::numeric_limits<T>::max()) {
+      llvm::report_fatal_error("invalid bitcode file: invalid integer");
+    }
+    offset_ += n;
+    return v;
+  } else {
+    uint64_t v = llvm::decodeULEB128(ptr, &n, end, &error);
+    if (error || v > std::numeric_limits<T>::max()) {
+      llvm::report_fatal_error("invalid bitcode file: invalid integer");
+    }
+    offset_ += n;
+    return v;
+  }
+}
+
 // -----------------------------------------------------------------------------
 template<typename T> std::optional<T> BitcodeReader::ReadOptional()
 {
@@ -37,14 +80,21 @@ template<typename T> std::optional<T> BitcodeReader::ReadOptional()
 }
 
 // -----------------------------------------------------------------------------
-std::string BitcodeReader::ReadString()
+std::string_view BitcodeReader::ReadString()
 {
+  if (version_ >= 2) {
+    uint32_t index = ReadData<uint32_t>();
+    if (index >= owner_->strings_.size()) {
+      llvm::report_fatal_error("invalid bitcode file: invalid string");
+    }
+    return owner_->strings_[index];
+  }
+
   uint32_t size = ReadData<uint32_t>();
-  const char *ptr = buf_.data();
   if (offset_ + size > buf_.size()) {
     llvm::report_fatal_error("invalid bitcode file: string too long");
   }
-  std::string s(ptr + offset_, ptr + offset_ + size);
+  std::string_view s(buf_.data() + offset_, size);
   offset_ += size;
   return s;
 }
@@ -52,10 +102,42 @@ std::string BitcodeReader::ReadString()
 // -----------------------------------------------------------------------------
 std::unique_ptr<Prog> BitcodeReader::Read()
 {
-  // Check the magic.
-  if (ReadData<uint32_t>() != kLLIRMagic) {
+  llvm::TimeTraceScope scope("ReadBitcode");
+  auto prog = ReadLazy();
+  MaterializeAll();
+  return prog;
+}
+
+// -----------------------------------------------------------------------------
+std::unique_ptr<Prog> BitcodeReader::ReadLazy()
+{
+  // Check the magic and the revision. Files which predate revisions
+  // continue with the name of the program instead of the marker.
+  if (ReadFixed<uint32_t>() != kLLIRMagic) {
     llvm::report_fatal_error("invalid bitcode magic");
   }
+  const uint64_t header = offset_;
+  if (ReadFixed<uint32_t>() == kLLIRRevisionMarker) {
+    version_ = ReadFixed<uint32_t>();
+    if (version_ < 1 || version_ > kLLIRVersion) {
+      llvm::report_fatal_error("unsupported bitcode version");
+    }
+  } else {
+    offset_ = header;
+    version_ = 0;
+  }
+
+  // Read the table of strings.
+  if (version_ >= 2) {
+    for (unsigned i = 0, n = ReadData<uint32_t>(); i < n; ++i) {
+      uint32_t size = ReadData<uint32_t>();
+      if (offset_ + size > buf_.size()) {
+        llvm::report_fatal_error("invalid bitcode file: string too long");
+      }
+      strings_.emplace_back(buf_.data() + offset_, size);
+      offset_ += size;
+    }
+  }
 
   // Read all symbols and their names.
   auto prog = std::make_unique<Prog>(ReadString());
@@ -85,6 +167,7 @@ std::unique_ptr<Prog> BitcodeReader::Read()
     for (unsigned i = 0, n = ReadData<uint32_t>(); i < n; ++i) {
       Func *func = new Func(ReadString());
       globals_.push_back(func);
+      SlabArena::Scope scope(func->GetArena());
       for (unsigned j = 0, m = ReadData<uint32_t>(); j < m; ++j) {
         auto name = ReadString();
         auto vis = static_cast<Visibility>(ReadData<uint8_t>());
@@ -96,18 +179,19 @@ std::unique_ptr<Prog> BitcodeReader::Read()
     }
   }
 
-  // Read all data items.
-  for (Data &data : prog->data()) {
-    for (Object &object : data) {
-      for (Atom &atom : object) {
-        Read(atom);
+  // Unrevised files store the bodies in order, before externs and xtors,
+  // without a table of contents: they are decoded eagerly.
+  if (version_ == 0) {
+    for (Data &data : prog->data()) {
+      for (Object &object : data) {
+        for (Atom &atom : object) {
+          Read(atom);
+        }
       }
     }
-  }
-
-  // Read all functions.
-  for (Func &func : *prog) {
-    Read(func);
+    for (Func &func : *prog) {
+      Read(func);
+    }
   }
 
   // Read externs.
@@ -119,13 +203,111 @@ std::unique_ptr<Prog> BitcodeReader::Read()
   for (unsigned i = 0, n = ReadData<uint32_t>(); i < n; ++i) {
     prog->AddXtor(ReadXtor());
   }
+  if (version_ == 0) {
+    return std::move(prog);
+  }
+
+  // Locate the bodies of atoms and functions through the table of contents,
+  // whose offset is stored in the trailing word of the program.
+  for (Data &data : prog->data()) {
+    for (Object &object : data) {
+      for (Atom &atom : object) {
+        bodies_.push_back(&atom);
+      }
+    }
+  }
+  for (Func &func : *prog) {
+    bodies_.push_back(&func);
+  }
+  if (buf_.size() < sizeof(uint64_t)) {
+    llvm::report_fatal_error("invalid bitcode file: missing contents");
+  }
+  offset_ = buf_.size() - sizeof(uint64_t);
+  uint64_t toc = ReadFixed<uint64_t>();
+  if (toc + bodies_.size() * sizeof(uint64_t) + sizeof(uint64_t) != offset_) {
+    llvm::report_fatal_error("invalid bitcode file: corrupt contents");
+  }
+  offset_ = toc;
+  for (Global *g : bodies_) {
+    uint64_t body = ReadFixed<uint64_t>();
+    if (body >= toc) {
+      llvm::report_fatal_error("invalid bitcode file: invalid body offset");
+    }
+    pending_.emplace(g, body);
+  }
 
   return std::move(prog);
 }
 
+// -----------------------------------------------------------------------------
+bool BitcodeReader::Seek(const Global &g)
+{
+  auto it = pending_.find(&g);
+  if (it == pending_.end()) {
+    return false;
+  }
+  offset_ = it->second;
+  pending_.erase(it);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void BitcodeReader::Materialize(Func &func)
+{
+  if (Seek(func)) {
+    Read(func);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void BitcodeReader::Materialize(Atom &atom)
+{
+  if (Seek(atom)) {
+    Read(atom);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void BitcodeReader::MaterializeAll()
+{
+  // Decode atoms, collecting the functions which were not yet decoded.
+  std::vector<std::pair<Func *, uint64_t>> funcs;
+  for (Global *g : bodies_) {
+    if (auto *func = ::cast_or_null<Func>(g)) {
+      auto it = pending_.find(func);
+      if (it != pending_.end()) {
+        funcs.emplace_back(func, it->second);
+        pending_.erase(it);
+      }
+    } else {
+      Materialize(*::cast<Atom>(g));
+    }
+  }
+
+  if (threads_ <= 1 || funcs.size() <= 1) {
+    for (auto &[func, offset] : funcs) {
+      offset_ = offset;
+      Read(*func);
+    }
+    return;
+  }
+
+  // Decode functions concurrently: they only share the use lists of globals,
+  // which are locked while the pool is running.
+  ThreadPool pool(threads_);
+  Use::SetConcurrent(true);
+  pool.ParallelFor(funcs.size(), [&, this](size_t i) {
+    auto &[func, offset] = funcs[i];
+    BitcodeReader(*this, offset).Read(*func);
+  });
+  Use::SetConcurrent(false);
+}
+
 // -----------------------------------------------------------------------------
 void BitcodeReader::Read(Func &func)
 {
+  SlabArena::Scope scope(func.GetArena());
+
   if (auto align = ReadData<uint32_t>()) {
     func.SetAlignment(llvm::Align(align));
   }
@@ -285,10 +467,10 @@ Expr *BitcodeReader::ReadExpr()
     case Expr::Kind::SYMBOL_OFFSET: {
       Global *global;
       if (auto index = ReadData<uint32_t>()) {
-        if (index - 1 >= globals_.size()) {
+        if (index - 1 >= owner_->globals_.size()) {
           llvm::report_fatal_error("invalid global index");
         }
-        global = globals_[index - 1];
+        global = owner_->globals_[index - 1];
       } else {
         global = nullptr;
       }
@@ -304,21 +486,14 @@ Ref<Value> BitcodeReader::ReadValue(const std::vector<Ref<Inst>> &map)
 {
   switch (static_cast<Value::Kind>(ReadData<uint8_t>())) {
     case Value::Kind::INST: {
-      if (uint32_t index = ReadData<uint32_t>()) {
-        if (index > map.size()) {
-          llvm::report_fatal_error("invalid instruction index");
-        }
-        return map[index - 1];
-      } else {
-        return nullptr;
-      }
+      return ReadInst(map);
     }
     case Value::Kind::GLOBAL: {
       uint32_t index = ReadData<uint32_t>();
-      if (index >= globals_.size()) {
+      if (index >= owner_->globals_.size()) {
         llvm::report_fatal_error("invalid global index");
       }
-      return globals_[index];
+      return owner_->globals_[index];
     }
     case Value::Kind::EXPR: {
       return ReadExpr();
@@ -334,10 +509,10 @@ Ref<Value> BitcodeReader::ReadValue(const std::vector<Ref<Inst>> &map)
 Block * BitcodeReader::ReadBlock(const std::vector<Ref<Inst>> &map)
 {
   uint32_t index = ReadData<uint32_t>();
-  if (index >= globals_.size()) {
+  if (index >= owner_->globals_.size()) {
     llvm::report_fatal_error("invalid global index");
   }
-  return ::cast<Block>(globals_[index]);
+  return ::cast<Block>(owner_->globals_[index]);
 }
 
 // -----------------------------------------------------------------------------
@@ -363,6 +538,10 @@ Ref<Inst> BitcodeReader::ReadInst(const std::vector<Ref<Inst>> &map)
     if (index > map.size()) {
       llvm::report_fatal_error("invalid instruction index");
     }
+    // Newer revisions encode the distance back to the definition.
+    if (version_ >= 2) {
+      return map[map.size() - index];
+    }
     return map[index - 1];
   } else {
     return nullptr;
@@ -409,10 +588,10 @@ Xtor *BitcodeReader::ReadXtor()
   Xtor::Kind kind = static_cast<Xtor::Kind>(ReadData<uint8_t>());
   int priority = ReadData<int32_t>();
   uint32_t index = ReadData<uint32_t>();
-  if (index >= globals_.size()) {
+  if (index >= owner_->globals_.size()) {
     llvm::report_fatal_error("invalid global index");
   }
-  return new Xtor(priority, globals_[index], kind);
+  return new Xtor(priority, owner_->globals_[index], kind);
 }
 
 // -----------------------------------------------------------------------------
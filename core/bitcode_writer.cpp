@@ -3,8 +3,12 @@
 // (C) 2018 Nandor Licker. All rights reserved.
 
 #include <llvm/Support/Endian.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/EndianStream.h>
+#include <llvm/Support/LEB128.h>
 #include <llvm/ADT/PostOrderIterator.h>
 
+#include "core/adt/thread_pool.h"
 #include "core/bitcode.h"
 #include "core/block.h"
 #include "core/cast.h"
@@ -23,25 +27,48 @@ namespace endian = llvm::support::endian;
 // -----------------------------------------------------------------------------
 void BitcodeWriter::Emit(llvm::StringRef str)
 {
-  Emit<uint32_t>(str.size());
-  os_.write(str.data(), str.size());
+  auto it = owner_->stringIDs_.find(str);
+  if (it != owner_->stringIDs_.end()) {
+    Emit<uint32_t>(it->second);
+    return;
+  }
+  // Function bodies only use strings registered upfront: a string missed by
+  // the registration would otherwise yield output depending on the threads.
+  if (owner_->sealed_) {
+    llvm::report_fatal_error("bitcode string not registered: " + str);
+  }
+  assert(owner_ == this && "worker adding a string");
+  Emit<uint32_t>(Intern(str));
+}
+
+// -----------------------------------------------------------------------------
+unsigned BitcodeWriter::Intern(llvm::StringRef str)
+{
+  auto it = stringIDs_.try_emplace(str, strings_.size());
+  if (it.second) {
+    strings_.push_back(it.first->getKey());
+  }
+  return it.first->second;
 }
 
 // -----------------------------------------------------------------------------
 template<typename T>
 void BitcodeWriter::Emit(T t)
 {
-  char buffer[sizeof(T)];
-  llvm::support::endian::write(buffer, t, llvm::support::little);
-  os_.write(buffer, sizeof(buffer));
+  if constexpr (std::is_integral<T>::value && sizeof(T) > 1) {
+    if constexpr (std::is_signed<T>::value) {
+      llvm::encodeSLEB128(t, body_);
+    } else {
+      llvm::encodeULEB128(t, body_);
+    }
+  } else {
+    endian::write(body_, t, llvm::support::little);
+  }
 }
 
 // -----------------------------------------------------------------------------
 void BitcodeWriter::Write(const Prog &prog)
 {
-  // Write the header.
-  Emit<uint32_t>(kLLIRMagic);
-
   // Emit the program name.
   Emit(prog.getName());
 
@@ -85,30 +112,90 @@ void BitcodeWriter::Write(const Prog &prog)
     }
   }
 
-  // Emit all data items.
+  // Emit all extern aliases.
+  for (const Extern &ext : prog.externs()) {
+    Write(ext);
+  }
+
+  // Emit all ctors and dtors.
+  Emit<uint32_t>(prog.xtor_size());
+  for (const Xtor &xtor : prog.xtor()) {
+    Write(xtor);
+  }
+
+  // Emit all data items and functions, recording their offsets.
+  std::vector<uint64_t> bodies;
   for (const Data &data : prog.data()) {
     for (const Object &object : data) {
       for (const Atom &atom : object) {
+        bodies.push_back(body_.tell());
         Write(atom);
       }
     }
   }
+  {
+    // Register the strings of functions upfront, in a fixed order: bodies
+    // can then be encoded concurrently, with identical output.
+    std::vector<const Func *> funcs;
+    for (const Func &func : prog) {
+      Intern(func.getCPU());
+      Intern(func.getTuneCPU());
+      Intern(func.getFeatures());
+      for (const Block &block : func) {
+        for (const Inst &inst : block) {
+          if (auto *frame = inst.GetAnnot<CamlFrame>()) {
+            for (const auto &debug_info : frame->debug_infos()) {
+              for (const auto &debug : debug_info) {
+                Intern(debug.File);
+                Intern(debug.Definition);
+              }
+            }
+          }
+        }
+      }
+      funcs.push_back(&func);
+    }
+    sealed_ = true;
 
-  // Emit all functions.
-  for (const Func &func : prog) {
-    Write(func);
+    if (threads_ <= 1 || funcs.size() <= 1) {
+      for (const Func *func : funcs) {
+        bodies.push_back(body_.tell());
+        Write(*func);
+      }
+    } else {
+      std::vector<llvm::SmallVector<char, 0>> encoded(funcs.size());
+      ThreadPool pool(threads_);
+      pool.ParallelFor(funcs.size(), [&, this](size_t i) {
+        BitcodeWriter writer(*this);
+        writer.Write(*funcs[i]);
+        encoded[i] = std::move(writer.buffer_);
+      });
+      for (const auto &buffer : encoded) {
+        bodies.push_back(body_.tell());
+        body_.write(buffer.data(), buffer.size());
+      }
+    }
   }
 
-  // Emit all extern aliases.
-  for (const Extern &ext : prog.externs()) {
-    Write(ext);
+  // Write the header, followed by the table of strings.
+  const uint64_t start = os_.tell();
+  endian::write<uint32_t>(os_, kLLIRMagic, llvm::support::little);
+  endian::write<uint32_t>(os_, kLLIRRevisionMarker, llvm::support::little);
+  endian::write<uint32_t>(os_, kLLIRVersion, llvm::support::little);
+  llvm::encodeULEB128(strings_.size(), os_);
+  for (llvm::StringRef str : strings_) {
+    llvm::encodeULEB128(str.size(), os_);
+    os_.write(str.data(), str.size());
   }
 
-  // Emit all ctors and dtors.
-  Emit<uint32_t>(prog.xtor_size());
-  for (const Xtor &xtor : prog.xtor()) {
-    Write(xtor);
+  // Write the program, followed by the table of contents and its offset.
+  const uint64_t base = os_.tell() - start;
+  os_.write(buffer_.data(), buffer_.size());
+  const uint64_t toc = os_.tell() - start;
+  for (uint64_t offset : bodies) {
+    endian::write<uint64_t>(os_, base + offset, llvm::support::little);
   }
+  endian::write<uint64_t>(os_, toc, llvm::support::little);
 }
 
 // -----------------------------------------------------------------------------
@@ -150,7 +237,7 @@ void BitcodeWriter::Write(const Func &func)
     }
   }
 
-  // Emit BBs and instructions.
+  // Emit BBs and instructions, numbering them to encode references.
   {
     std::unordered_map<ConstRef<Inst>, unsigned> map;
     llvm::ReversePostOrderTraversal<const Func *> rpot(&func);
@@ -162,10 +249,12 @@ void BitcodeWriter::Write(const Func &func)
       }
     }
 
+    next_ = 1;
     for (const Block *block : rpot) {
       Emit<uint32_t>(block->size());
       for (const Inst &inst : *block) {
         Write(inst, map);
+        next_ += inst.GetNumRets();
       }
     }
   }
@@ -283,8 +372,8 @@ void BitcodeWriter::Write(const Expr &expr)
     case Expr::Kind::SYMBOL_OFFSET: {
       auto &offsetExpr = static_cast<const SymbolOffsetExpr &>(expr);
       if (auto *symbol = offsetExpr.GetSymbol()) {
-        auto it = symbols_.find(symbol);
-        assert(it != symbols_.end() && "missing symbol");
+        auto it = owner_->symbols_.find(symbol);
+        assert(it != owner_->symbols_.end() && "missing symbol");
         Emit<uint32_t>(it->second + 1);
       } else {
         Emit<uint32_t>(0);
@@ -333,8 +422,8 @@ void BitcodeWriter::Write(const Xtor &xtor)
 {
   Emit<uint8_t>(static_cast<uint8_t>(xtor.getKind()));
   Emit<int32_t>(xtor.getPriority());
-  auto it = symbols_.find(xtor.getFunc());
-  assert(it != symbols_.end() && "missing symbol");
+  auto it = owner_->symbols_.find(xtor.getFunc());
+  assert(it != owner_->symbols_.end() && "missing symbol");
   Emit<uint32_t>(it->second);
 }
 
@@ -379,14 +468,12 @@ void BitcodeWriter::Write(
   Emit<uint8_t>(static_cast<uint8_t>(valueKind));
   switch (valueKind) {
     case Value::Kind::INST: {
-      auto it = map.find(cast<Inst>(value));
-      assert(it != map.end() && "missing instruction");
-      Emit<uint32_t>(it->second);
+      Write(cast<Inst>(value), map);
       return;
     }
     case Value::Kind::GLOBAL: {
-      auto it = symbols_.find(&*cast<Global>(value));
-      assert(it != symbols_.end() && "missing symbol");
+      auto it = owner_->symbols_.find(&*cast<Global>(value));
+      assert(it != owner_->symbols_.end() && "missing symbol");
       Emit<uint32_t>(it->second);
       return;
     }
@@ -408,9 +495,10 @@ void BitcodeWriter::Write(
     const std::unordered_map<ConstRef<Inst>, unsigned> &map)
 {
   if (value) {
+    // Definitions precede their uses: encode the distance to them.
     auto it = map.find(value);
-    assert(it != map.end() && it->second <= map.size() && "missing instruction");
-    Emit<uint32_t>(it->second);
+    assert(it != map.end() && it->second < next_ && "missing instruction");
+    Emit<uint32_t>(next_ - it->second);
   } else {
     Emit<uint32_t>(0);
   }
@@ -421,8 +509,8 @@ void BitcodeWriter::Write(
     const Block *value,
     const std::unordered_map<ConstRef<Inst>, unsigned> &map)
 {
-  auto it = symbols_.find(value);
-  assert(it != symbols_.end() && "missing symbol");
+  auto it = owner_->symbols_.find(value);
+  assert(it != owner_->symbols_.end() && "missing symbol");
   Emit<uint32_t>(it->second);
 }
 
@@ -14,6 +14,7 @@
 #include <llvm/IR/CFG.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "core/adt/slab.h"
 #include "core/inst.h"
 #include "core/global.h"
 #include "core/symbol_table.h"
@@ -182,6 +183,17 @@ public:
    */
   ~Block();
 
+  /// Allocates blocks from slabs.
+  static void *operator new(size_t size)
+  {
+    return SlabAllocator::Allocate(size);
+  }
+  /// Recycles the memory of a block.
+  static void operator delete(void *ptr, size_t size)
+  {
+    SlabAllocator::Deallocate(ptr, size);
+  }
+
   /// Removes the global from the parent container.
   void removeFromParent() override;
   /// Removes a block from the parent.
@@ -87,7 +87,7 @@ void llvm::ilist_traits<Data>::removeNodeFromList(Data *data)
   data->setParent(nullptr);
   for (Object &object : *data) {
     for (Atom &atom : object) {
-      parent->removeGlobalName(atom.GetName());
+      parent->removeGlobalName(atom.GetNameHandle());
     }
   }
 }
@@ -2,6 +2,7 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include "core/adt/slab.h"
 #include "core/func.h"
 #include "core/block.h"
 #include "core/cast.h"
@@ -12,12 +13,18 @@
 
 
 // -----------------------------------------------------------------------------
-static unsigned kUniqueID = 0;
+static std::atomic<unsigned> kUniqueID(0);
+
+// -----------------------------------------------------------------------------
+std::atomic<uint64_t> Func::epoch_(1);
 
 // -----------------------------------------------------------------------------
 Func::Func(const std::string_view name, Visibility visibility)
   : Global(Global::Kind::FUNC, name, visibility)
   , id_(kUniqueID++)
+  , modified_(epoch_.load(std::memory_order_relaxed))
+  , instBound_(0)
+  , instLive_(0)
   , parent_(nullptr)
   , callConv_(CallingConv::C)
   , varArg_(false)
@@ -29,6 +36,75 @@ Func::Func(const std::string_view name, Visibility visibility)
 // -----------------------------------------------------------------------------
 Func::~Func()
 {
+  // Blocks and instructions are torn down before their pages are freed.
+  blocks_.clear();
+  arena_.reset();
+}
+
+// -----------------------------------------------------------------------------
+uint64_t Func::NextEpoch()
+{
+  return epoch_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// -----------------------------------------------------------------------------
+static unsigned GetNumIndices(const Inst &inst)
+{
+  // Void instructions also get an index, to be used as keys.
+  return std::max(1u, inst.GetNumRets());
+}
+
+// -----------------------------------------------------------------------------
+SlabArena *Func::GetArena()
+{
+  if (!arena_) {
+    arena_ = std::make_unique<SlabArena>();
+  }
+  return arena_.get();
+}
+
+// -----------------------------------------------------------------------------
+void Func::CompactInsts()
+{
+  if (instBound_ <= 2 * instLive_) {
+    return;
+  }
+  instBound_ = 0;
+  instLive_ = 0;
+  for (Block &block : *this) {
+    AttachBlock(block);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Func::AttachInst(Inst &inst)
+{
+  const unsigned n = GetNumIndices(inst);
+  inst.denseIndex_ = instBound_;
+  instBound_ += n;
+  instLive_ += n;
+}
+
+// -----------------------------------------------------------------------------
+void Func::DetachInst(Inst &inst)
+{
+  instLive_ -= GetNumIndices(inst);
+}
+
+// -----------------------------------------------------------------------------
+void Func::AttachBlock(Block &block)
+{
+  for (Inst &inst : block) {
+    AttachInst(inst);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Func::DetachBlock(Block &block)
+{
+  for (Inst &inst : block) {
+    DetachInst(inst);
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -74,6 +150,7 @@ void Func::clear()
   objects_.clear();
   objectIndices_.clear();
   blocks_.clear();
+  Touch();
 }
 
 // -----------------------------------------------------------------------------
@@ -177,6 +254,7 @@ unsigned Func::AddStackObject(unsigned index, unsigned size, llvm::Align align)
     llvm::report_fatal_error("Duplicate stack object");
   }
   objects_.emplace_back(index, size, align);
+  Touch();
   return index;
 }
 
@@ -194,6 +272,7 @@ void Func::RemoveStackObject(unsigned index)
       it++;
     }
   }
+  Touch();
 }
 
 // -----------------------------------------------------------------------------
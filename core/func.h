@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string_view>
 
 #include <llvm/ADT/ArrayRef.h>
@@ -20,7 +22,9 @@
 
 class Block;
 class Func;
+class Inst;
 class Prog;
+class SlabArena;
 
 
 
@@ -76,7 +80,29 @@ public:
   ~Func() override;
 
   /// Returns the unique ID.
-  unsigned GetID() { return id_; }
+  unsigned GetID() const { return id_; }
+
+  /// Returns the epoch in which the function was last modified.
+  uint64_t GetModified() const
+  {
+    return modified_.load(std::memory_order_relaxed);
+  }
+  /// Records a modification of the function in the current epoch.
+  void Touch()
+  {
+    const auto epoch = epoch_.load(std::memory_order_relaxed);
+    modified_.store(epoch, std::memory_order_relaxed);
+  }
+  /// Starts a new modification epoch, returning its identifier.
+  static uint64_t NextEpoch();
+
+  /// Returns an upper bound on the dense indices of instructions.
+  unsigned GetInstBound() const { return instBound_; }
+  /// Renumbers instructions if deletions left too many holes in the indices.
+  void CompactInsts();
+
+  /// Returns the arena holding the instructions and blocks of the function.
+  SlabArena *GetArena();
 
   /// Removes an instruction from the parent.
   void removeFromParent() override;
@@ -95,42 +121,74 @@ public:
   void RemoveStackObject(unsigned index);
 
   /// Sets the calling convention.
-  void SetCallingConv(CallingConv conv) { callConv_ = conv; }
+  void SetCallingConv(CallingConv conv)
+  {
+    callConv_ = conv;
+    Touch();
+  }
   /// Returns the calling convention.
   CallingConv GetCallingConv() const { return callConv_; }
 
   /// Sets the vararg flag.
-  void SetVarArg(bool varArg = true) { varArg_ = varArg; }
+  void SetVarArg(bool varArg = true)
+  {
+    varArg_ = varArg;
+    Touch();
+  }
   /// Returns the vararg flags.
   bool IsVarArg() const { return varArg_; }
 
   /// Sets the alignment of the function.
-  void SetAlignment(llvm::Align align) { align_ = align; }
+  void SetAlignment(llvm::Align align)
+  {
+    align_ = align;
+    Touch();
+  }
   /// Returns the alignment of a function.
   std::optional<llvm::Align> GetAlignment() const override { return align_; }
 
   /// Checks if the function can be inlined.
   bool IsNoInline() const { return noinline_; }
   /// Prevents the function from being inlined.
-  void SetNoInline(bool noinline = true) { noinline_ = noinline; }
+  void SetNoInline(bool noinline = true)
+  {
+    noinline_ = noinline;
+    Touch();
+  }
 
   /// Returns the function-specific target features.
   std::string_view GetFeatures() const { return features_; }
   llvm::StringRef getFeatures() const { return features_; }
-  void SetFeatures(const std::string_view features) { features_ = features; }
+  void SetFeatures(const std::string_view features)
+  {
+    features_ = features;
+    Touch();
+  }
 
   /// Returns the CPU to compile for.
   std::string_view GetCPU() const { return cpu_; }
   llvm::StringRef getCPU() const { return cpu_; }
-  void SetCPU(const std::string_view cpu) { cpu_ = cpu; }
+  void SetCPU(const std::string_view cpu)
+  {
+    cpu_ = cpu;
+    Touch();
+  }
 
   /// Returns the CPU to tune for.
   std::string_view GetTuneCPU() const { return tuneCPU_; }
   llvm::StringRef getTuneCPU() const { return tuneCPU_; }
-  void SetTuneCPU(const std::string_view tuneCPU) { tuneCPU_ = tuneCPU; }
+  void SetTuneCPU(const std::string_view tuneCPU)
+  {
+    tuneCPU_ = tuneCPU;
+    Touch();
+  }
 
   /// Sets the number of fixed parameters.
-  void SetParameters(const std::vector<FlaggedType> &params) { params_ = params; }
+  void SetParameters(const std::vector<FlaggedType> &params)
+  {
+    params_ = params;
+    Touch();
+  }
   /// Returns the list of arguments.
   llvm::ArrayRef<FlaggedType> params() const { return params_; }
   /// Returns the number of parameters.
@@ -188,6 +246,9 @@ public:
     return const_cast<Func *>(this)->getEntryBlock();
   }
 
+  /// Returns the entry block, as required by LLVM's dominator trees.
+  Block &front() { return getEntryBlock(); }
+
   // Iterator over the blocks.
   iterator begin() { return blocks_.begin(); }
   iterator end() { return blocks_.end(); }
@@ -211,16 +272,36 @@ public:
   void dump(llvm::raw_ostream &os = llvm::errs()) const;
 
 private:
+  friend struct llvm::ilist_traits<Inst>;
   friend struct SymbolTableListTraits<Func>;
   friend struct SymbolTableListTraits<Block>;
   /// Updates the parent node.
   void setParent(Prog *parent) { parent_ = parent; }
 
+  /// Assigns dense indices to an instruction added to the function.
+  void AttachInst(Inst &inst);
+  /// Releases the indices of an instruction removed from the function.
+  void DetachInst(Inst &inst);
+  /// Assigns dense indices to the instructions of an added block.
+  void AttachBlock(Block &block);
+  /// Releases the indices of the instructions of a removed block.
+  void DetachBlock(Block &block);
+
   static BlockListType Func::*getSublistAccess(Block *) { return &Func::blocks_; }
 
 private:
+  /// Current modification epoch.
+  static std::atomic<uint64_t> epoch_;
   /// Unique ID for each function.
   unsigned id_;
+  /// Epoch of the last modification to the body or the uses of the function.
+  std::atomic<uint64_t> modified_;
+  /// Next free dense instruction index.
+  unsigned instBound_;
+  /// Number of indices held by instructions in the function.
+  unsigned instLive_;
+  /// Arena for instructions, operands and blocks, created on first use.
+  std::unique_ptr<SlabArena> arena_;
   /// Name of the underlying program.
   Prog *parent_;
   /// Chain of basic blocks.
@@ -2,6 +2,8 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include "core/block.h"
+#include "core/func.h"
 #include "core/global.h"
 #include "core/prog.h"
 
@@ -14,7 +16,7 @@ Global::Global(
     unsigned numOps)
   : User(Value::Kind::GLOBAL, numOps)
   , kind_(kind)
-  , name_(name)
+  , name_(GetNames().Intern(name))
   , visibility_(visibility)
 {
 }
@@ -24,6 +26,39 @@ Global::~Global()
 {
 }
 
+// -----------------------------------------------------------------------------
+StringInterner &Global::GetNames()
+{
+  // Names can be referenced until exit, thus the table is never freed.
+  static StringInterner *names = new StringInterner();
+  return *names;
+}
+
+// -----------------------------------------------------------------------------
+void Global::SetVisibility(Visibility visibility)
+{
+  visibility_ = visibility;
+
+  // Passes inspect the visibility of functions and blocks.
+  switch (kind_) {
+    case Kind::FUNC: {
+      static_cast<Func *>(this)->Touch();
+      return;
+    }
+    case Kind::BLOCK: {
+      if (Func *func = static_cast<Block *>(this)->getParent()) {
+        func->Touch();
+      }
+      return;
+    }
+    case Kind::EXTERN:
+    case Kind::ATOM: {
+      return;
+    }
+  }
+  llvm_unreachable("invalid global kind");
+}
+
 // -----------------------------------------------------------------------------
 bool Global::IsRoot() const
 {
@@ -10,6 +10,7 @@
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/Alignment.h>
 
+#include "core/adt/string_interner.h"
 #include "core/user.h"
 #include "core/visibility.h"
 
@@ -49,15 +50,24 @@ public:
   bool Is(Kind kind) const { return GetKind() == kind; }
 
   /// Returns the name of the global.
-  const std::string_view GetName() const { return name_; }
+  const std::string_view GetName() const { return GetNames().Get(name_); }
   /// Returns the name of the basic block for LLVM.
-  llvm::StringRef getName() const { return name_; }
+  llvm::StringRef getName() const
+  {
+    const std::string_view name = GetName();
+    return llvm::StringRef(name.data(), name.size());
+  }
+  /// Returns the interned handle of the name.
+  StringInterner::Handle GetNameHandle() const { return name_; }
+
+  /// Returns the table of symbol names, shared by all programs.
+  static StringInterner &GetNames();
 
   /// Externs have no known alignment.
   virtual std::optional<llvm::Align> GetAlignment() const = 0;
 
   /// Sets the visibilty of the global.
-  void SetVisibility(Visibility visibility) { visibility_ = visibility; }
+  void SetVisibility(Visibility visibility);
   /// Returns the visibilty of a global.
   Visibility GetVisibility() const { return visibility_; }
 
@@ -80,8 +90,8 @@ private:
   friend class Prog;
   /// Kind of the global.
   Kind kind_;
-  /// Name of the global.
-  std::string name_;
+  /// Interned name of the global.
+  StringInterner::Handle name_;
   /// Visibility of the global.
   Visibility visibility_;
 };
@@ -4,6 +4,7 @@
 
 #include "core/block.h"
 #include "core/cast.h"
+#include "core/func.h"
 #include "core/inst.h"
 #include "core/insts.h"
 #include "core/printer.h"
@@ -11,7 +12,12 @@
 
 
 // -----------------------------------------------------------------------------
-static int InstructionID = 0;
+static void Touch(Block *block)
+{
+  if (Func *func = block->getParent()) {
+    func->Touch();
+  }
+}
 
 
 
@@ -21,7 +27,7 @@ Inst::Inst(Kind kind, unsigned numOps, AnnotSet &&annot)
   , kind_(kind)
   , annot_(std::move(annot))
   , parent_(nullptr)
-  , order_(++InstructionID)
+  , denseIndex_(0)
 {
 }
 
@@ -31,7 +37,7 @@ Inst::Inst(Kind kind, unsigned numOps, const AnnotSet &annot)
   , kind_(kind)
   , annot_(annot)
   , parent_(nullptr)
-  , order_(++InstructionID)
+  , denseIndex_(0)
 {
 }
 
@@ -81,16 +87,33 @@ void Inst::dump(llvm::raw_ostream &os) const
   Printer(os).Print(*this);
 }
 
+// -----------------------------------------------------------------------------
+void Inst::Touch()
+{
+  if (parent_) {
+    ::Touch(parent_);
+  }
+}
+
 // -----------------------------------------------------------------------------
 void llvm::ilist_traits<Inst>::addNodeToList(Inst *inst)
 {
-  inst->setParent(getParent());
+  Block *parent = getParent();
+  inst->setParent(parent);
+  if (Func *func = parent->getParent()) {
+    func->AttachInst(*inst);
+  }
+  Touch(parent);
 }
 
 // -----------------------------------------------------------------------------
 void llvm::ilist_traits<Inst>::removeNodeFromList(Inst *inst)
 {
+  if (Func *func = getParent()->getParent()) {
+    func->DetachInst(*inst);
+  }
   inst->setParent(nullptr);
+  Touch(getParent());
 }
 
 // -----------------------------------------------------------------------------
@@ -100,9 +123,21 @@ void llvm::ilist_traits<Inst>::transferNodesFromList(
     instr_iterator last)
 {
   Block *parent = getParent();
+  Func *newFunc = parent->getParent();
+  Func *oldFunc = from.getParent()->getParent();
   for (auto it = first; it != last; ++it) {
     it->setParent(parent);
+    if (newFunc != oldFunc) {
+      if (oldFunc) {
+        oldFunc->DetachInst(*it);
+      }
+      if (newFunc) {
+        newFunc->AttachInst(*it);
+      }
+    }
   }
+  Touch(parent);
+  Touch(from.getParent());
 }
 
 // -----------------------------------------------------------------------------
@@ -10,6 +10,7 @@
 #include <llvm/ADT/ilist_node.h>
 #include <llvm/ADT/ilist.h>
 
+#include "core/adt/slab.h"
 #include "core/annot.h"
 #include "core/constant.h"
 #include "core/cond.h"
@@ -68,8 +69,24 @@ public:
   /// Destroys an instruction.
   virtual ~Inst();
 
-  /// Returns a unique, stable identifier for the instruction.
-  unsigned GetOrder() const { return order_; }
+  /// Allocates instructions from slabs.
+  static void *operator new(size_t size)
+  {
+    return SlabAllocator::Allocate(size);
+  }
+  /// Recycles the memory of an instruction.
+  static void operator delete(void *ptr, size_t size)
+  {
+    SlabAllocator::Deallocate(ptr, size);
+  }
+
+  /**
+   * Returns the dense index of the first sub-value in the parent function.
+   *
+   * Sub-values occupy consecutive indices. Indices are never reused while
+   * the function is edited, but they are compacted between passes.
+   */
+  unsigned GetDenseIndex() const { return denseIndex_; }
 
   /// Removes an instruction from the parent.
   void removeFromParent();
@@ -105,7 +122,14 @@ public:
 
   /// Removes an annotation.
   template<typename T>
-  bool ClearAnnot() { return annot_.Clear<T>(); }
+  bool ClearAnnot()
+  {
+    if (!annot_.Clear<T>()) {
+      return false;
+    }
+    Touch();
+    return true;
+  }
 
   /// Returns an annotation.
   template<typename T>
@@ -115,11 +139,22 @@ public:
   template<typename T, typename... Args>
   bool SetAnnot(Args&&... args)
   {
-    return annot_.Set<T, Args...>(std::forward<Args>(args)...);
+    if (!annot_.Set<T, Args...>(std::forward<Args>(args)...)) {
+      return false;
+    }
+    Touch();
+    return true;
   }
 
   /// Adds an annotation.
-  bool AddAnnot(const Annot &annot) { return annot_.Add(annot); }
+  bool AddAnnot(const Annot &annot)
+  {
+    if (!annot_.Add(annot)) {
+      return false;
+    }
+    Touch();
+    return true;
+  }
   /// Returns the instruction's annotation.
   const AnnotSet &GetAnnots() const { return annot_; }
   /// Returns the number of annotations.
@@ -164,9 +199,12 @@ protected:
   Inst(Kind kind, unsigned numOps, const AnnotSet &annot);
 
 private:
+  friend class Func;
   friend struct llvm::ilist_traits<Inst>;
   /// Updates the parent node.
   void setParent(Block *parent) { parent_ = parent; }
+  /// Records a modification of the parent function.
+  void Touch();
 
 private:
   /// Instruction kind.
@@ -177,8 +215,8 @@ private:
 protected:
   /// Parent node.
   Block *parent_;
-  /// Unique number for stable ordering.
-  unsigned order_;
+  /// Dense index within the parent function.
+  unsigned denseIndex_;
 };
 
 /// Print the value to a stream.
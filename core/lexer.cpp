@@ -2,6 +2,7 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <algorithm>
 #include <stack>
 #include <sstream>
 
@@ -92,12 +93,9 @@ static inline bool IsIdentCont(char chr)
 Lexer::Lexer(llvm::StringRef buf)
   : buf_(buf)
   , ptr_(buf.data())
-  , char_('\0')
+  , char_(buf.empty() ? '\0' : *ptr_)
   , tk_(Token::END)
-  , row_(1)
-  , col_(0)
 {
-  NextChar();
   NextToken();
 }
 
@@ -109,8 +107,8 @@ Lexer::~Lexer()
 // -----------------------------------------------------------------------------
 Lexer::Token Lexer::NextToken()
 {
-  // Clear the value buffer.
-  str_.clear();
+  // Clear the value.
+  tok_ = {};
   int_ = 0;
 
   // Skip whitespaces and newlines, coalesce multiple newlines into one.
@@ -151,11 +149,11 @@ Lexer::Token Lexer::NextToken()
         } while (IsDigit(NextChar()));
         return tk_ = Token::VREG;
       } else if (IsAlpha(char_)) {
-        do {
-          str_.push_back(char_);
-        } while (IsAlphaNum(NextChar()));
+        const char *start = ptr_;
+        while (IsAlphaNum(NextChar()));
+        tok_ = Since(start);
 
-        static std::vector<std::pair<const char *, Register>> regs =
+        static std::vector<std::pair<std::string_view, Register>> regs =
         {
           std::make_pair("sp",                  Register::SP            ),
           std::make_pair("fs",                  Register::FS            ),
@@ -184,13 +182,13 @@ Lexer::Token Lexer::NextToken()
         };
 
         for (const auto &reg : regs) {
-          if (reg.first == str_) {
+          if (reg.first == tok_) {
             reg_ = reg.second;
             return tk_ = Token::REG;
           }
         }
 
-        Error("unknown register: " + str_);
+        Error("unknown register: " + std::string(tok_));
       } else {
         Error("invalid register name");
       }
@@ -199,14 +197,30 @@ Lexer::Token Lexer::NextToken()
       if (!IsAlphaNum(NextChar())) {
         Error("empty annotation");
       }
-      do {
-        str_.push_back(char_);
-      } while (IsAlphaNum(NextChar()) || char_ == '.');
+      const char *start = ptr_;
+      while (IsAlphaNum(NextChar()) || char_ == '.');
+      tok_ = Since(start);
       return tk_ = Token::ANNOT;
     }
     case '\"': {
+      // Strings without escapes are referenced in the buffer.
       NextChar();
+      const char *start = ptr_;
+      while (char_ != '\"' && char_ != '\\' && char_ != '\0') {
+        NextChar();
+      }
+      if (char_ == '\"') {
+        tok_ = Since(start);
+        NextChar();
+        return tk_ = Token::STRING;
+      }
+
+      // Decode the string into the buffer otherwise.
+      str_.assign(start, ptr_);
       while (char_ != '\"') {
+        if (char_ == '\0') {
+          Error("unterminated string");
+        }
         if (char_ == '\\') {
           switch (NextChar()) {
             case 'b':  str_.push_back('\b'); NextChar(); break;
@@ -239,21 +253,20 @@ Lexer::Token Lexer::NextToken()
           NextChar();
         }
       }
+      tok_ = str_;
       NextChar();
       return tk_ = Token::STRING;
     }
     default: {
+      const char *start = ptr_;
       if (IsIdentStart(char_)) {
-        do {
-          str_.push_back(char_);
-        } while (IsIdentCont(NextChar()) || char_ == '.');
+        while (IsIdentCont(NextChar()) || char_ == '.');
+        tok_ = Since(start);
         return tk_ = Token::IDENT;
       } else if (IsDigit(char_)) {
         unsigned base = 10;
         if (char_ == '0') {
-          str_.push_back(char_);
-          str_.push_back(NextChar());
-          switch (char_) {
+          switch (NextChar()) {
             case 'x': base = 16; NextChar(); break;
             case 'b': base =  2; NextChar(); break;
             case 'o': base =  8; NextChar(); break;
@@ -261,25 +274,25 @@ Lexer::Token Lexer::NextToken()
               if (IsDigit(char_)) {
                 Error("invalid numeric constant");
               }
+              tok_ = Since(start);
               return tk_ = Token::NUMBER;
             }
           }
         }
         // Parse body of the number.
         do {
-          str_.push_back(char_);
           int_ = int_ * base + ToInt(char_);
         } while (IsDigit(NextChar(), base));
 
         // If the token continues with alphanumeric characters, parse as ident.
         if (IsIdentCont(char_)) {
-          do {
-            str_.push_back(char_);
-          } while (IsIdentCont(NextChar()) || char_ == '.');
+          while (IsIdentCont(NextChar()) || char_ == '.');
+          tok_ = Since(start);
           return tk_ = Token::IDENT;
         } else if (IsAlphaNum(char_)) {
           Error("invalid numeric constant");
         } else {
+          tok_ = Since(start);
           return tk_ = Token::NUMBER;
         }
       } else {
@@ -292,19 +305,29 @@ Lexer::Token Lexer::NextToken()
 // -----------------------------------------------------------------------------
 char Lexer::NextChar()
 {
-  if (ptr_ == buf_.data() + buf_.size()) {
-    char_ = '\0';
-    return char_;
+  const char *end = buf_.data() + buf_.size();
+  if (ptr_ != end) {
+    ++ptr_;
   }
+  char_ = ptr_ == end ? '\0' : *ptr_;
+  return char_;
+}
 
-  char_ = *ptr_++;
-  if (IsNewline(char_)) {
-    row_ += 1;
-    col_ = 1;
-  } else {
-    col_ += 1;
+// -----------------------------------------------------------------------------
+std::pair<unsigned, unsigned> Lexer::Location(size_t offset) const
+{
+  // Positions are only needed for errors, thus they are not tracked.
+  unsigned row = 1, col = 1;
+  const char *end = buf_.data() + std::min(offset, buf_.size());
+  for (const char *ptr = buf_.data(); ptr < end; ++ptr) {
+    if (IsNewline(*ptr)) {
+      row += 1;
+      col = 1;
+    } else {
+      col += 1;
+    }
   }
-  return char_;
+  return { row, col };
 }
 
 // -----------------------------------------------------------------------------
@@ -346,7 +369,7 @@ void Lexer::Check(Token type)
 // -----------------------------------------------------------------------------
 std::string_view Lexer::String() const
 {
-  return str_;
+  return tok_;
 }
 
 // -----------------------------------------------------------------------------
@@ -382,7 +405,7 @@ SExp Lexer::ParseSExp()
             continue;
           }
           case Token::STRING: {
-            stk.top()->AddString(str_);
+            stk.top()->AddString(std::string(tok_));
             continue;
           }
           case Token::LPAREN: {
@@ -404,9 +427,10 @@ SExp Lexer::ParseSExp()
 // -----------------------------------------------------------------------------
 [[noreturn]] void Lexer::Error(const std::string &msg)
 {
+  auto [row, col] = Location();
   std::ostringstream os;
   os << "["
-     << row_ << ":" << col_
+     << row << ":" << col
      << "]: " << msg;
   llvm::report_fatal_error(os.str());
 }
@@ -414,9 +438,19 @@ SExp Lexer::ParseSExp()
 // -----------------------------------------------------------------------------
 [[noreturn]] void Lexer::Error(Func *func, const std::string &msg)
 {
+  Error(Offset(), func, msg);
+}
+
+// -----------------------------------------------------------------------------
+[[noreturn]] void Lexer::Error(
+    size_t offset,
+    Func *func,
+    const std::string &msg)
+{
+  auto [row, col] = Location(offset);
   std::ostringstream os;
   os << "["
-      << row_ << ":" << col_ << ": " << func->GetName()
+     << row << ":" << col << ": " << func->GetName()
      << "]: " << msg;
   llvm::report_fatal_error(os.str());
 }
@@ -427,9 +461,10 @@ SExp Lexer::ParseSExp()
     Block *block,
     const std::string &msg)
 {
+  auto [row, col] = Location();
   std::ostringstream os;
   os << "["
-     << row_ << ":" << col_ << ": " << func->GetName() << ":"
+     << row << ":" << col << ": " << func->GetName() << ":"
      << block->GetName()
      << "]: " << msg;
   llvm::report_fatal_error(os.str());
@@ -20,6 +20,10 @@ class Block;
 
 /**
  * Breaks an assembly source file into tokens.
+ *
+ * Tokens are views into the source buffer, which must outlive the lexer.
+ * Only strings with escape sequences are decoded into a separate buffer,
+ * thus their contents are valid until the next token is fetched.
  */
 class Lexer final {
 public:
@@ -89,29 +93,40 @@ public:
   /// Parses an S-Expression.
   SExp ParseSExp();
 
+  /// Returns the offset of the current position, to report errors later.
+  size_t Offset() const { return ptr_ - buf_.data(); }
+
   /// Error reporting.
   [[noreturn]] void Error(const std::string &msg);
   [[noreturn]] void Error(Func *f, const std::string &msg);
   [[noreturn]] void Error(Func *f, Block *b, const std::string &msg);
+  [[noreturn]] void Error(size_t offset, Func *f, const std::string &msg);
 
 private:
   /// Fetches the next character.
   char NextChar();
+  /// Returns the text of the current token, starting at a position.
+  std::string_view Since(const char *start) const
+  {
+    return std::string_view(start, ptr_ - start);
+  }
+  /// Finds the row and column of an offset.
+  std::pair<unsigned, unsigned> Location(size_t offset) const;
+  /// Finds the row and column of the current position.
+  std::pair<unsigned, unsigned> Location() const { return Location(Offset()); }
 
 private:
   /// Source stream.
   llvm::StringRef buf_;
-  /// Pointer to the stream.
+  /// Pointer to the current character.
   const char *ptr_;
   /// Current character.
   char char_;
   /// Current token.
   Token tk_;
-  /// Current row number.
-  unsigned row_;
-  /// Current column number.
-  unsigned col_;
-  /// String value stored in the current token.
+  /// Text of the current token.
+  std::string_view tok_;
+  /// Buffer for strings with escape sequences.
   std::string str_;
   /// Current register.
   Register reg_;
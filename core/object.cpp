@@ -451,7 +451,7 @@ void llvm::ilist_traits<Object>::removeNodeFromList(Object *object)
 
   if (Prog *parent = data->getParent()) {
     for (Atom &atom : *object) {
-      parent->removeGlobalName(atom.GetName());
+      parent->removeGlobalName(atom.GetNameHandle());
     }
   }
 }
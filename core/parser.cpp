@@ -13,6 +13,8 @@
 
 #include <llvm/ADT/SmallPtrSet.h>
 
+#include "core/adt/slab.h"
+#include "core/adt/thread_pool.h"
 #include "core/block.h"
 #include "core/cast.h"
 #include "core/constant.h"
@@ -21,14 +23,16 @@
 #include "core/insts.h"
 #include "core/parser.h"
 #include "core/prog.h"
+#include "core/use.h"
 
 
 
 // -----------------------------------------------------------------------------
-Parser::Parser(llvm::StringRef buf, std::string_view ident)
+Parser::Parser(llvm::StringRef buf, std::string_view ident, unsigned threads)
   : l_(buf)
   , prog_(new Prog(ident))
   , nextLabel_(0)
+  , threads_(threads)
 {
   stk_.emplace(nullptr);
 }
@@ -48,7 +52,7 @@ std::unique_ptr<Prog> Parser::Parse()
         continue;
       }
       case Token::IDENT: {
-        std::string name(ParseName(l_.String()));
+        std::string_view name(ParseName(l_.String()));
         if (l_.NextToken() == Token::COLON) {
           auto &s = GetSection();
 
@@ -61,7 +65,7 @@ std::unique_ptr<Prog> Parser::Parse()
                 if (auto *ext = ::cast_or_null<Extern>(g)) {
                   CreateBlock(s.F, name);
                 } else {
-                  l_.Error(s.F, "redefinition of '" + name + "'");
+                  l_.Error(s.F, "redefinition of '" + std::string(name) + "'");
                 }
               } else {
                 CreateBlock(s.F, name);
@@ -99,6 +103,7 @@ std::unique_ptr<Prog> Parser::Parse()
     End();
     stk_.pop();
   }
+  PlacePhis();
 
   // Fix up function visibility attributes.
   {
@@ -853,7 +858,11 @@ void Parser::EndFunction()
     l_.Error(s.F, "Function not terminated");
   }
 
-  if (auto err = PhiPlacement(*s.F, s.VRegs)) {
+  // Functions are independent, thus their SSA form can be built in parallel
+  // once the whole file was parsed and all symbols were resolved.
+  if (threads_ > 1) {
+    pending_.push_back({ s.F, std::move(s.VRegs), l_.Offset() });
+  } else if (auto err = PhiPlacement(*s.F, s.VRegs)) {
     llvm::handleAllErrors(std::move(err), [&](const llvm::ErrorInfoBase &e) {
       l_.Error(s.F, e.message());
     });
@@ -863,6 +872,31 @@ void Parser::EndFunction()
   s.VRegs.clear();
 }
 
+// -----------------------------------------------------------------------------
+void Parser::PlacePhis()
+{
+  // Errors cannot be reported from the workers, so they are collected.
+  std::vector<std::string> errors(pending_.size());
+  {
+    ThreadPool pool(threads_);
+    Use::SetConcurrent(true);
+    pool.ParallelFor(pending_.size(), [&, this](size_t i) {
+      auto &pending = pending_[i];
+      if (auto err = PhiPlacement(*pending.F, std::move(pending.VRegs))) {
+        errors[i] = llvm::toString(std::move(err));
+      }
+    });
+    Use::SetConcurrent(false);
+  }
+
+  for (unsigned i = 0, n = pending_.size(); i < n; ++i) {
+    if (!errors[i].empty()) {
+      l_.Error(pending_[i].Offset, pending_[i].F, errors[i]);
+    }
+  }
+  pending_.clear();
+}
+
 // -----------------------------------------------------------------------------
 void Parser::Align(int64_t alignment)
 {
@@ -904,6 +938,8 @@ int64_t Parser::Number()
 // -----------------------------------------------------------------------------
 void Parser::CreateBlock(Func *func, const std::string_view name)
 {
+  SlabArena::Scope scope(func->GetArena());
+
   Block *block = new Block(name);
 
   if (!func->empty()) {
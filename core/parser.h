@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/StringRef.h>
 
 #include <fstream>
@@ -36,6 +37,10 @@ class Object;
 
 /**
  * Parses an assembly file.
+ *
+ * The file is read in a single pass, since instructions resolve symbols in
+ * the shared program. Given multiple threads, SSA construction is deferred
+ * until the whole file is read and then runs on all functions in parallel.
  */
 class Parser final {
 private:
@@ -61,13 +66,24 @@ private:
     Section(Data *data) : D(data) {}
   };
 
+  /// Function awaiting PHI placement.
+  struct PendingFunc {
+    /// Function to construct SSA form for.
+    Func *F;
+    /// Mapping of vregs to instructions.
+    VRegMap VRegs;
+    /// Offset of the end of the function, to report errors at.
+    size_t Offset;
+  };
+
 public:
   /**
    * Initialises the parser.
-   * @param buf   Buffer to read from.
-   * @param ident Name to identify the module.
+   * @param buf     Buffer to read from.
+   * @param ident   Name to identify the module.
+   * @param threads Number of threads constructing SSA form.
    */
-  Parser(llvm::StringRef buf, std::string_view ident);
+  Parser(llvm::StringRef buf, std::string_view ident, unsigned threads = 1);
 
   /**
    * Frees resources used by the parser.
@@ -137,6 +153,8 @@ private:
   void Align(int64_t alignment);
   /// Ends everything.
   void End();
+  /// Places PHI nodes in the functions deferred to the thread pool.
+  void PlacePhis();
 
   /// Places PHI nodes in a function.
   [[nodiscard]] static llvm::Error PhiPlacement(Func &func, VRegMap vregs);
@@ -214,12 +232,12 @@ private:
   /// Factory method for instructions.
   Inst *CreateInst(
       Func *func,
-      const std::string &op,
-      const std::vector<Operand> &ops,
-      const std::vector<std::pair<unsigned, TypeFlag>> &flags,
+      const std::string_view op,
+      llvm::ArrayRef<Operand> ops,
+      llvm::ArrayRef<std::pair<unsigned, TypeFlag>> flags,
       const std::optional<Cond> &ccs,
       const std::optional<size_t> &sizes,
-      const std::vector<Type> &ts,
+      llvm::ArrayRef<Type> ts,
       const std::optional<CallingConv> &conv,
       bool strict,
       AnnotSet &&annot
@@ -242,4 +260,8 @@ private:
   std::unordered_set<std::string> weak_;
   /// Stack of sections.
   std::stack<Section> stk_;
+  /// Number of threads constructing SSA form.
+  unsigned threads_;
+  /// Functions and their vregs, awaiting PHI placement.
+  std::vector<PendingFunc> pending_;
 };
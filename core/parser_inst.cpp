@@ -2,6 +2,7 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include "core/adt/slab.h"
 #include "core/cast.h"
 #include "core/parser.h"
 #include "core/prog.h"
@@ -18,11 +19,11 @@ void Parser::ParseInstruction(
 {
   // An instruction is composed of an opcode, followed by optional annotations.
   size_t dot = opcode.find('.');
-  std::string op(opcode.substr(0, dot));
+  std::string_view op(opcode.substr(0, dot));
 
   std::optional<size_t> size;
   std::optional<Cond> cc;
-  std::vector<Type> types;
+  llvm::SmallVector<Type, 4> types;
   std::optional<CallingConv> conv;
   bool strict = false;
 
@@ -120,8 +121,8 @@ void Parser::ParseInstruction(
   }
 
   // Parse all arguments.
-  std::vector<Operand> ops;
-  std::vector<std::pair<unsigned, TypeFlag>> flags;
+  llvm::SmallVector<Operand, 8> ops;
+  llvm::SmallVector<std::pair<unsigned, TypeFlag>, 4> flags;
   while (true) {
     switch (l_.GetToken()) {
       case Token::NEWLINE: {
@@ -166,8 +167,7 @@ void Parser::ParseInstruction(
       }
       // _some_name + offset
       case Token::IDENT: {
-        std::string name(ParseName(l_.String()));
-        Global *global = prog_->GetGlobalOrExtern(name);
+        Global *global = prog_->GetGlobalOrExtern(ParseName(l_.String()));
         switch (l_.NextToken()) {
           case Token::PLUS: {
             l_.Expect(Token::NUMBER);
@@ -202,7 +202,7 @@ void Parser::ParseInstruction(
   // Parse optional annotations.
   AnnotSet annot;
   while (l_.GetToken() == Token::ANNOT) {
-    std::string name(l_.String());
+    std::string_view name(l_.String());
     l_.NextToken();
     ParseAnnotation(name, annot);
   }
@@ -223,6 +223,7 @@ void Parser::ParseInstruction(
   }
 
   // Add the instruction to the block.
+  SlabArena::Scope scope(func->GetArena());
   Inst *i = CreateInst(
       func,
       op,
@@ -250,12 +251,12 @@ void Parser::ParseInstruction(
 // -----------------------------------------------------------------------------
 Inst *Parser::CreateInst(
     Func *func,
-    const std::string &opc,
-    const std::vector<Operand> &ops,
-    const std::vector<std::pair<unsigned, TypeFlag>> &fs,
+    const std::string_view opc,
+    llvm::ArrayRef<Operand> ops,
+    llvm::ArrayRef<std::pair<unsigned, TypeFlag>> fs,
     const std::optional<Cond> &ccs,
     const std::optional<size_t> &size,
-    const std::vector<Type> &ts,
+    llvm::ArrayRef<Type> ts,
     const std::optional<CallingConv> &conv,
     bool strict,
     AnnotSet &&annot)
@@ -641,7 +642,7 @@ Inst *Parser::CreateInst(
     }
   }
 
-  l_.Error("unknown opcode: " + opc);
+  l_.Error("unknown opcode: " + std::string(opc));
 }
 
 // -----------------------------------------------------------------------------
@@ -5,6 +5,7 @@
 #include <stack>
 #include <queue>
 
+#include "core/adt/slab.h"
 #include "core/cast.h"
 #include "core/parser.h"
 #include "core/block.h"
@@ -16,6 +17,8 @@
 // -----------------------------------------------------------------------------
 llvm::Error Parser::PhiPlacement(Func &func, VRegMap vregs)
 {
+  SlabArena::Scope scope(func.GetArena());
+
   // Construct the dominator tree & find dominance frontiers.
   DominatorTree DT(func);
   DominanceFrontier DF;
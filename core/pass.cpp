@@ -2,8 +2,12 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include "core/adt/slab.h"
+#include "core/analysis.h"
+#include "core/func.h"
 #include "core/pass.h"
 #include "core/pass_manager.h"
+#include "core/prog.h"
 
 
 
@@ -18,6 +22,12 @@ Pass::~Pass()
 {
 }
 
+// -----------------------------------------------------------------------------
+PreservedAnalyses Pass::GetPreserved() const
+{
+  return PreservedAnalyses();
+}
+
 // -----------------------------------------------------------------------------
 const PassConfig &Pass::GetConfig() const
 {
@@ -29,3 +39,30 @@ const Target *Pass::GetTarget() const
 {
   return passManager_->GetTarget();
 }
+
+// -----------------------------------------------------------------------------
+ThreadPool *Pass::GetThreadPool() const
+{
+  return passManager_->GetThreadPool();
+}
+
+
+
+// -----------------------------------------------------------------------------
+FuncPass::FuncPass(PassManager *passManager)
+  : Pass(passManager)
+{
+}
+
+// -----------------------------------------------------------------------------
+bool FuncPass::Run(Prog &prog)
+{
+  Prepare(prog);
+
+  bool changed = false;
+  for (Func &func : prog) {
+    SlabArena::Scope scope(func.GetArena());
+    changed = Run(func) || changed;
+  }
+  return changed;
+}
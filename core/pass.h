@@ -4,10 +4,13 @@
 
 #pragma once
 
+class Func;
 class Prog;
 class PassManager;
 class PassConfig;
+class PreservedAnalyses;
 class Target;
+class ThreadPool;
 
 
 
@@ -36,8 +39,17 @@ public:
    */
   virtual const char *GetPassName() const = 0;
 
+  /**
+   * Returns the analyses which remain valid if the pass changes the program.
+   */
+  virtual PreservedAnalyses GetPreserved() const;
+
   /// Returns an available analysis.
   template<typename T> T* getAnalysis();
+  /// Returns an analysis of a function, computing it if necessary.
+  template<typename T> T &getAnalysis(Func &func);
+  /// Returns an analysis of the program, computing it if necessary.
+  template<typename T> T &getAnalysis(Prog &prog);
 
 
 protected:
@@ -45,8 +57,47 @@ protected:
   const PassConfig &GetConfig() const;
   /// Returns a reference to the target.
   const Target *GetTarget() const;
+  /// Returns the thread pool, if passes can run jobs in parallel.
+  ThreadPool *GetThreadPool() const;
 
 protected:
   /// Pass manager scheduling this pass.
   PassManager *passManager_;
 };
+
+
+
+/**
+ * Base class for passes which transform functions independently.
+ *
+ * Function passes must only modify the function they are given and must
+ * not inspect the bodies or the use lists of other functions, allowing the
+ * pass manager to run them on multiple functions concurrently. Since their
+ * result only depends on the function, the pass manager does not re-run them
+ * on functions which were not modified since their previous run.
+ */
+class FuncPass : public Pass {
+public:
+  /**
+   * Function pass initialisation.
+   */
+  FuncPass(PassManager *passManager);
+
+  /**
+   * Runs the pass on all functions of a program, in order.
+   */
+  bool Run(Prog &prog) override;
+
+  /**
+   * Collects program-wide information, before functions are transformed.
+   *
+   * The hook runs serially, thus it can inspect the use lists of symbols
+   * on behalf of the function transformations which cannot.
+   */
+  virtual void Prepare(Prog &prog) {}
+
+  /**
+   * Runs the pass on a single function.
+   */
+  virtual bool Run(Func &func) = 0;
+};
@@ -2,16 +2,31 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <unordered_set>
 #include <iostream>
 
+#include <sys/resource.h>
+
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Support/Format.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "core/adt/slab.h"
+#include "core/adt/thread_pool.h"
+#include "core/bitcode.h"
+#include "core/block.h"
+#include "core/func.h"
 #include "core/pass.h"
 #include "core/pass_manager.h"
 #include "core/printer.h"
-#include "core/bitcode.h"
+#include "core/prog.h"
+#include "core/snapshot.h"
+#include "core/use.h"
 #include "core/verifier.h"
 
 
@@ -23,12 +38,17 @@ PassManager::PassManager(
     const std::string &saveBefore,
     bool verbose,
     bool time,
-    bool verify)
+    bool verify,
+    unsigned threads,
+    const std::string &timeReport,
+    unsigned saveRotate)
   : config_(config)
   , target_(target)
   , saveBefore_(saveBefore)
+  , dirty_(true)
   , verbose_(verbose)
   , time_(time)
+  , timeReport_(timeReport)
   , verify_(verify)
 {
   if (auto *s = getenv("LLIR_OPT_DISABLED")) {
@@ -38,33 +58,63 @@ PassManager::PassManager(
       disabled_.insert(pass.str());
     }
   }
+  if (threads > 1) {
+    pool_ = std::make_unique<ThreadPool>(threads);
+  }
+  if (!timeReport_.empty()) {
+    llvm::EnableStatistics(false);
+  }
+  if (!saveBefore_.empty() && saveRotate) {
+    snapshots_ = std::make_unique<SnapshotWriter>(saveBefore_, saveRotate);
+  }
+}
+
+// -----------------------------------------------------------------------------
+PassManager::~PassManager()
+{
 }
 
 // -----------------------------------------------------------------------------
 void PassManager::Run(Prog &prog)
 {
-  for (auto &group : groups_) {
+  for (unsigned i = 0, n = groups_.size(); i < n; ++i) {
+    auto &group = groups_[i];
+    unsigned iteration = 0;
     bool changed;
     do {
+      llvm::TimeTraceScope scope("Group", [&] {
+        return "group " + std::to_string(i) + ", iteration " +
+               std::to_string(iteration);
+      });
       changed = false;
       if (group.Passes.size() > 1 && time_ && verbose_) {
         llvm::outs() << "-----------\n";
       }
       for (auto &pass : group.Passes) {
-        if (!saveBefore_.empty()) {
+        if (snapshots_) {
+          if (dirty_) {
+            snapshots_->Save(prog, pass.Name, iteration);
+            dirty_ = false;
+          }
+        } else if (!saveBefore_.empty()) {
           std::error_code err;
           llvm::raw_fd_ostream os(saveBefore_, err);
           BitcodeWriter(os).Write(prog);
         }
 
-        if (Run(pass, prog)) {
+        if (Run(pass, prog, i, iteration)) {
           changed = true;
-          analyses_.clear();
+          dirty_ = true;
         }
       }
+      ++iteration;
     } while (group.Repeat && changed);
   }
 
+  if (!timeReport_.empty()) {
+    WriteTimeReport();
+  }
+
   if (time_) {
     size_t length = 0;
     for (auto &[key, times] : times_) {
@@ -95,12 +145,20 @@ void PassManager::Run(Prog &prog)
 }
 
 // -----------------------------------------------------------------------------
-bool PassManager::Run(PassInfo &pass, Prog &prog)
+bool PassManager::Run(
+    PassInfo &pass,
+    Prog &prog,
+    unsigned group,
+    unsigned iteration)
 {
   // Do not run disabled passes.
   if (disabled_.count(pass.Name)) {
     return false;
   }
+  // Do not re-compute analyses which are still valid.
+  if (pass.ID && analyses_.count(pass.ID)) {
+    return false;
+  }
 
   // Print information.
   const auto &name = pass.P->GetPassName();
@@ -108,12 +166,33 @@ bool PassManager::Run(PassInfo &pass, Prog &prog)
     llvm::outs() << name << ": ";
   }
 
+  // Snapshot the program size and the statistics for the report.
+  const bool report = !timeReport_.empty();
+  ProgSize before;
+  std::map<std::string, int64_t> stats;
+  if (report) {
+    before = GetSize(prog);
+    for (auto &[name, value] : llvm::GetStatistics()) {
+      stats[name.str()] -= value;
+    }
+  }
+
   // Run the pass, measuring elapsed time.
   double elapsed;
   bool changed;
+  uint64_t epoch;
   {
+    llvm::TimeTraceScope scope(pass.Name, name);
     const auto start = std::chrono::high_resolution_clock::now();
-    changed = pass.P->Run(prog);
+    // Changes made from now on, including the ones made by the
+    // pass itself, are recorded as part of the new epoch.
+    epoch = Func::NextEpoch();
+    if (pass.F) {
+      changed = Run(*pass.F, prog, pass.Epoch, epoch);
+      pass.Epoch = epoch;
+    } else {
+      changed = pass.P->Run(prog);
+    }
     const auto end = std::chrono::high_resolution_clock::now();
 
     elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -130,6 +209,22 @@ bool PassManager::Run(PassInfo &pass, Prog &prog)
     llvm::outs() << "\n";
   }
 
+  // Discard the results invalidated by the pass. Function passes have
+  // already discarded the analyses of the individual functions they changed.
+  if (changed) {
+    const auto preserved = pass.P->GetPreserved();
+    Invalidate(preserved);
+    if (!pass.F) {
+      Invalidate(prog, preserved);
+      // Function passes compact the functions they visited themselves.
+      for (Func &func : prog) {
+        if (func.GetModified() >= epoch) {
+          func.CompactInsts();
+        }
+      }
+    }
+  }
+
   // Record the analysis results.
   if (pass.ID) {
     analyses_.emplace(pass.ID, pass.P.get());
@@ -138,10 +233,267 @@ bool PassManager::Run(PassInfo &pass, Prog &prog)
   // Verify if requested.
   if (verify_) {
     Verifier(GetTarget()).Run(prog);
+    Verify(prog, pass.Name);
   }
 
   // Record running time.
   times_[pass.P->GetPassName()].push_back(elapsed);
 
+  // Record the detailed measurements.
+  if (report) {
+    PassRecord record;
+    record.Name = pass.Name;
+    record.Group = group;
+    record.Iteration = iteration;
+    record.Time = elapsed;
+    record.Changed = changed;
+    record.Before = before;
+    record.After = GetSize(prog);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    record.PeakRSS = static_cast<size_t>(usage.ru_maxrss) * 1024;
+
+    for (auto &[name, value] : llvm::GetStatistics()) {
+      stats[name.str()] += value;
+    }
+    for (auto &[name, delta] : stats) {
+      if (delta) {
+        record.Stats.emplace_back(name, delta);
+      }
+    }
+    records_.push_back(std::move(record));
+  }
+
   return changed;
 }
+
+// -----------------------------------------------------------------------------
+bool PassManager::Run(
+    FuncPass &pass,
+    Prog &prog,
+    uint64_t since,
+    uint64_t epoch)
+{
+  // Program-wide information is gathered before functions are processed.
+  pass.Prepare(prog);
+
+  // Functions which were not modified since the epoch of the previous run
+  // of the pass are at a fixpoint for it and can be skipped.
+  std::vector<Func *> funcs;
+  for (Func &func : prog) {
+    if (func.GetModified() < since) {
+      continue;
+    }
+    funcs.push_back(&func);
+  }
+
+  // Functions are transformed independently, recording changes per function
+  // in order to keep the result independent of scheduling. Use lists of
+  // symbols and constants can be shared between functions, thus they must
+  // be locked while the functions are processed concurrently. New objects
+  // are placed in the arena of the function being transformed.
+  std::vector<uint8_t> changed(funcs.size(), false);
+  if (pool_) {
+    Use::SetConcurrent(true);
+    pool_->ParallelFor(funcs.size(), [&] (size_t i) {
+      SlabArena::Scope scope(funcs[i]->GetArena());
+      changed[i] = pass.Run(*funcs[i]);
+    });
+    Use::SetConcurrent(false);
+  } else {
+    for (size_t i = 0, n = funcs.size(); i < n; ++i) {
+      SlabArena::Scope scope(funcs[i]->GetArena());
+      changed[i] = pass.Run(*funcs[i]);
+    }
+  }
+
+  // Discard the analyses of the functions which were changed.
+  const auto preserved = pass.GetPreserved();
+  bool anyChanged = false;
+  for (size_t i = 0, n = funcs.size(); i < n; ++i) {
+    if (changed[i]) {
+      Invalidate(*funcs[i], preserved);
+      anyChanged = true;
+    }
+  }
+
+  // Dense instruction indices are compacted between passes, when no
+  // pass-local maps hold them. Analysis results must not key on them.
+  // Only functions modified in the epoch of the pass can have new holes.
+  for (Func *func : funcs) {
+    if (func->GetModified() >= epoch) {
+      func->CompactInsts();
+    }
+  }
+  return anyChanged;
+}
+
+// -----------------------------------------------------------------------------
+FuncAnalysis *PassManager::FindAnalysis(const char *id, Func &func)
+{
+  std::lock_guard<std::mutex> guard(funcAnalysesLock_);
+  auto it = funcAnalyses_.find(func.GetID());
+  if (it == funcAnalyses_.end()) {
+    return nullptr;
+  }
+  auto jt = it->second.find(id);
+  if (jt == it->second.end()) {
+    return nullptr;
+  }
+  return jt->second.get();
+}
+
+// -----------------------------------------------------------------------------
+FuncAnalysis &PassManager::AddAnalysis(
+    const char *id,
+    Func &func,
+    std::unique_ptr<FuncAnalysis> &&result)
+{
+  std::lock_guard<std::mutex> guard(funcAnalysesLock_);
+  auto &slot = funcAnalyses_[func.GetID()][id];
+  slot = std::move(result);
+  return *slot;
+}
+
+// -----------------------------------------------------------------------------
+void PassManager::Invalidate(const PreservedAnalyses &preserved)
+{
+  for (auto it = analyses_.begin(); it != analyses_.end(); ) {
+    if (preserved.IsPreserved(it->first)) {
+      ++it;
+    } else {
+      it = analyses_.erase(it);
+    }
+  }
+  for (auto it = progAnalyses_.begin(); it != progAnalyses_.end(); ) {
+    if (preserved.IsPreserved(it->first)) {
+      ++it;
+    } else {
+      it = progAnalyses_.erase(it);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void PassManager::Invalidate(Prog &prog, const PreservedAnalyses &preserved)
+{
+  // Drop the results of functions which were deleted.
+  std::unordered_set<unsigned> live;
+  for (Func &func : prog) {
+    live.insert(func.GetID());
+  }
+  for (auto it = funcAnalyses_.begin(); it != funcAnalyses_.end(); ) {
+    if (live.count(it->first)) {
+      ++it;
+    } else {
+      it = funcAnalyses_.erase(it);
+    }
+  }
+  // Drop the results of all functions which were not preserved.
+  for (Func &func : prog) {
+    Invalidate(func, preserved);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void PassManager::Invalidate(Func &func, const PreservedAnalyses &preserved)
+{
+  auto it = funcAnalyses_.find(func.GetID());
+  if (it == funcAnalyses_.end()) {
+    return;
+  }
+  auto &results = it->second;
+  for (auto jt = results.begin(); jt != results.end(); ) {
+    if (preserved.IsPreserved(jt->first)) {
+      ++jt;
+    } else {
+      jt = results.erase(jt);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void PassManager::Verify(Prog &prog, const char *name)
+{
+  for (auto &[id, result] : progAnalyses_) {
+    if (!result->Verify()) {
+      llvm::report_fatal_error(llvm::Twine("stale analysis after ") + name);
+    }
+  }
+  for (Func &func : prog) {
+    auto it = funcAnalyses_.find(func.GetID());
+    if (it == funcAnalyses_.end()) {
+      continue;
+    }
+    for (auto &[id, result] : it->second) {
+      if (!result->Verify()) {
+        llvm::report_fatal_error(
+            "stale analysis of " + func.getName() + " after " + name
+        );
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+PassManager::ProgSize PassManager::GetSize(const Prog &prog)
+{
+  ProgSize size;
+  for (const Func &func : prog) {
+    size.Funcs++;
+    for (const Block &block : func) {
+      size.Blocks++;
+      size.Insts += block.size();
+    }
+  }
+  return size;
+}
+
+// -----------------------------------------------------------------------------
+void PassManager::WriteTimeReport()
+{
+  std::error_code err;
+  llvm::raw_fd_ostream os(timeReport_, err);
+  if (err) {
+    llvm::report_fatal_error(
+        llvm::Twine("cannot write time report: ") + err.message()
+    );
+  }
+
+  auto size = [] (llvm::json::OStream &json, const ProgSize &size) {
+    json.object([&] {
+      json.attribute("funcs", static_cast<int64_t>(size.Funcs));
+      json.attribute("blocks", static_cast<int64_t>(size.Blocks));
+      json.attribute("insts", static_cast<int64_t>(size.Insts));
+    });
+  };
+
+  llvm::json::OStream json(os, 2);
+  json.object([&] {
+    json.attributeArray("passes", [&] {
+      for (const PassRecord &record : records_) {
+        json.object([&] {
+          json.attribute("name", record.Name);
+          json.attribute("group", static_cast<int64_t>(record.Group));
+          json.attribute("iteration", static_cast<int64_t>(record.Iteration));
+          json.attribute("time", record.Time);
+          json.attribute("changed", record.Changed);
+          json.attributeBegin("before");
+          size(json, record.Before);
+          json.attributeEnd();
+          json.attributeBegin("after");
+          size(json, record.After);
+          json.attributeEnd();
+          json.attribute("peak-rss", static_cast<int64_t>(record.PeakRSS));
+          json.attributeObject("stats", [&] {
+            for (auto &[name, delta] : record.Stats) {
+              json.attribute(name, delta);
+            }
+          });
+        });
+      }
+    });
+  });
+  os << "\n";
+}
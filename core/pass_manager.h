@@ -6,18 +6,23 @@
 
 #include <llvm/ADT/ArrayRef.h>
 
+#include <cstdint>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <set>
 
 #include "core/pass.h"
 #include "core/analysis.h"
 
+class Func;
 class Pass;
+class SnapshotWriter;
 class Target;
+class ThreadPool;
 
 
 
@@ -79,17 +84,23 @@ public:
       const std::string &saveBefore,
       bool verbose,
       bool time,
-      bool verify
+      bool verify,
+      unsigned threads = 1,
+      const std::string &timeReport = "",
+      unsigned saveRotate = 0
   );
 
+  /// Cleans up the pass manager.
+  ~PassManager();
+
   /// Add an analysis into the pipeline.
   template<typename T, typename... Args>
   void Add(const Args &... args)
   {
     if constexpr (std::is_base_of<Analysis, T>::value) {
-      groups_.emplace_back(std::make_unique<T>(this), &AnalysisID<T>::ID, T::kPassID);
+      groups_.emplace_back(MakePass<T>(&AnalysisID<T>::ID));
     } else {
-      groups_.emplace_back(std::make_unique<T>(this, args...), nullptr, T::kPassID);
+      groups_.emplace_back(MakePass<T>(nullptr, args...));
     }
   }
 
@@ -98,7 +109,7 @@ public:
   void Group()
   {
     std::vector<PassInfo> ps;
-    ((ps.emplace_back(std::make_unique<Ts>(this), nullptr, Ts::kPassID)), ...);
+    ((ps.emplace_back(MakePass<Ts>(nullptr))), ...);
     groups_.emplace_back(std::move(ps));
   }
 
@@ -117,31 +128,97 @@ public:
     }
   }
 
+  /// Returns the analysis of a function, computing it if not cached.
+  template<typename T> T &getAnalysis(Func &func)
+  {
+    if (auto *result = FindAnalysis(&AnalysisID<T>::ID, func)) {
+      return static_cast<T &>(*result);
+    }
+    return static_cast<T &>(AddAnalysis(
+        &AnalysisID<T>::ID,
+        func,
+        std::make_unique<T>(func)
+    ));
+  }
+
+  /// Returns the analysis of the program, computing it if not cached.
+  template<typename T> T &getAnalysis(Prog &prog)
+  {
+    auto &result = progAnalyses_[&AnalysisID<T>::ID];
+    if (!result) {
+      result = std::make_unique<T>(prog);
+    }
+    return static_cast<T &>(*result);
+  }
+
   /// Returns a reference to the configuration.
   const PassConfig &GetConfig() const { return config_; }
   /// Returns a reference to the target.
   const Target *GetTarget() const { return target_; }
+  /// Returns the thread pool, if passes can run jobs in parallel.
+  ThreadPool *GetThreadPool() const { return pool_.get(); }
 
 private:
   /// Description of a pass.
   struct PassInfo {
     /// Instance of the pass.
     std::unique_ptr<Pass> P;
+    /// Function pass interface, if the pass is function-local.
+    FuncPass *F;
     /// ID to save the pass results under.
     const char *ID;
     /// Name of the pass.
     const char *Name;
+    /// Epoch of the last run of a function pass, 0 if it never ran.
+    uint64_t Epoch;
 
-    PassInfo(std::unique_ptr<Pass> &&pass, const char *id, const char *name)
+    PassInfo(
+        std::unique_ptr<Pass> &&pass,
+        FuncPass *func,
+        const char *id,
+        const char *name)
       : P(std::move(pass))
+      , F(func)
       , ID(id)
       , Name(name)
+      , Epoch(0)
     {
     }
   };
 
+  /// Creates a pass, identifying function passes.
+  template<typename T, typename... Args>
+  PassInfo MakePass(const char *id, const Args &... args)
+  {
+    auto pass = std::make_unique<T>(this, args...);
+    FuncPass *func = nullptr;
+    if constexpr (std::is_base_of<FuncPass, T>::value) {
+      func = pass.get();
+    }
+    return PassInfo(std::move(pass), func, id, T::kPassID);
+  }
+
   /// Runs and measures a single pass.
-  bool Run(PassInfo &pass, Prog &prog);
+  bool Run(PassInfo &pass, Prog &prog, unsigned group, unsigned iteration);
+  /// Runs a function pass in an epoch on functions modified since another.
+  bool Run(FuncPass &pass, Prog &prog, uint64_t since, uint64_t epoch);
+
+  /// Looks up a cached function analysis.
+  FuncAnalysis *FindAnalysis(const char *id, Func &func);
+  /// Caches a function analysis.
+  FuncAnalysis &AddAnalysis(
+      const char *id,
+      Func &func,
+      std::unique_ptr<FuncAnalysis> &&result
+  );
+  /// Invalidates the program analyses which were not preserved.
+  void Invalidate(const PreservedAnalyses &preserved);
+  /// Invalidates the function analyses which were not preserved.
+  void Invalidate(Prog &prog, const PreservedAnalyses &preserved);
+  /// Invalidates the analyses of a function which were not preserved.
+  void Invalidate(Func &func, const PreservedAnalyses &preserved);
+  /// Checks that the cached analyses are still valid.
+  void Verify(Prog &prog, const char *name);
 
   /// Description of a pass group.
   struct GroupInfo {
@@ -150,10 +227,10 @@ private:
     /// Flag to indicate whether group repeats until convergence.
     bool Repeat;
 
-    GroupInfo(std::unique_ptr<Pass> &&pass, const char * id, const char *name)
+    GroupInfo(PassInfo &&pass)
       : Repeat(false)
     {
-      Passes.emplace_back(std::move(pass), id, name);
+      Passes.emplace_back(std::move(pass));
     }
 
     GroupInfo(std::vector<PassInfo> &&passes)
@@ -163,24 +240,82 @@ private:
     }
   };
 
+  /// Size of the program, measured for profiling.
+  struct ProgSize {
+    /// Number of functions.
+    size_t Funcs = 0;
+    /// Number of blocks.
+    size_t Blocks = 0;
+    /// Number of instructions.
+    size_t Insts = 0;
+  };
+
+  /// Measurements of a single pass invocation.
+  struct PassRecord {
+    /// Identifier of the pass.
+    const char *Name;
+    /// Index of the group the pass belongs to.
+    unsigned Group;
+    /// Iteration of the group.
+    unsigned Iteration;
+    /// Wall-clock running time, in seconds.
+    double Time;
+    /// Flag indicating whether the pass changed the program.
+    bool Changed;
+    /// Size of the program before the pass.
+    ProgSize Before;
+    /// Size of the program after the pass.
+    ProgSize After;
+    /// Peak resident set size after the pass, in bytes.
+    size_t PeakRSS;
+    /// Statistics which changed while the pass ran.
+    std::vector<std::pair<std::string, int64_t>> Stats;
+  };
+
+  /// Measures the size of a program.
+  static ProgSize GetSize(const Prog &prog);
+  /// Writes the recorded pass measurements to the report file.
+  void WriteTimeReport();
+
   /// Configuration.
   PassConfig config_;
   /// Underlying target.
   const Target *target_;
   /// Name of file to save IR before each pass.
   std::string saveBefore_;
+  /// Writer for snapshots taken before passes following a change.
+  std::unique_ptr<SnapshotWriter> snapshots_;
+  /// Flag indicating whether the program changed since the last snapshot.
+  bool dirty_;
   /// Verbosity flag.
   bool verbose_;
   /// Timing flag.
   bool time_;
+  /// Name of the file to write the JSON time report to.
+  std::string timeReport_;
   /// Flag to verify IR after a transformation.
   bool verify_;
+  /// Thread pool running function passes, if parallelism is enabled.
+  std::unique_ptr<ThreadPool> pool_;
   /// List of passes to run on a program.
   std::vector<GroupInfo> groups_;
   /// Mapping from named passes to IDs.
   std::unordered_map<const char *, Pass *> analyses_;
+  /// Type of per-function analysis caches.
+  using FuncAnalysisMap = std::unordered_map<
+      const char *,
+      std::unique_ptr<FuncAnalysis>
+  >;
+  /// Mapping from function IDs to their cached analyses.
+  std::unordered_map<unsigned, FuncAnalysisMap> funcAnalyses_;
+  /// Cached program analyses.
+  std::unordered_map<const char *, std::unique_ptr<ProgAnalysis>> progAnalyses_;
+  /// Lock protecting the function analyses during parallel passes.
+  std::mutex funcAnalysesLock_;
   /// Mapping from pass names to their running times.
   std::unordered_map<const char *, std::vector<double>> times_;
+  /// Measurements of individual passes, recorded for the time report.
+  std::vector<PassRecord> records_;
   /// Set of disabled passes.
   std::set<std::string> disabled_;
 };
@@ -192,3 +327,15 @@ template<typename T> T* Pass::getAnalysis()
 {
   return passManager_->getAnalysis<T>();
 }
+
+// -----------------------------------------------------------------------------
+template<typename T> T &Pass::getAnalysis(Func &func)
+{
+  return passManager_->getAnalysis<T>(func);
+}
+
+// -----------------------------------------------------------------------------
+template<typename T> T &Pass::getAnalysis(Prog &prog)
+{
+  return passManager_->getAnalysis<T>(prog);
+}
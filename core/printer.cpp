@@ -3,8 +3,10 @@
 // (C) 2018 Nandor Licker. All rights reserved.
 
 #include <llvm/ADT/PostOrderIterator.h>
-#include <llvm/Support/Format.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/NativeFormatting.h>
 
+#include "core/adt/thread_pool.h"
 #include "core/printer.h"
 #include "core/block.h"
 #include "core/cfg.h"
@@ -36,9 +38,7 @@ void Printer::Print(const Prog &prog)
 
   // Print the text segment.
   os_ << "\t.section .text\n";
-  for (const Func &f : prog) {
-    Print(f);
-  }
+  PrintFuncs(prog);
   os_ << "\n";
 
   // Print all data segments.
@@ -64,6 +64,41 @@ void Printer::Print(const Prog &prog)
   }
 }
 
+// -----------------------------------------------------------------------------
+void Printer::PrintFuncs(const Prog &prog)
+{
+  if (threads_ <= 1) {
+    for (const Func &f : prog) {
+      Print(f);
+    }
+    return;
+  }
+
+  std::vector<const Func *> funcs;
+  for (const Func &f : prog) {
+    funcs.push_back(&f);
+  }
+
+  // Print functions into their own buffers, emitting them in order.
+  std::vector<llvm::SmallString<0>> buffers(funcs.size());
+  {
+    ThreadPool pool(threads_);
+    pool.ParallelFor(funcs.size(), [&, this](size_t i) {
+      llvm::raw_svector_ostream os(buffers[i]);
+      Fork(os)->Print(*funcs[i]);
+    });
+  }
+  for (const auto &buffer : buffers) {
+    os_ << buffer;
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::unique_ptr<Printer> Printer::Fork(llvm::raw_ostream &os) const
+{
+  return std::make_unique<Printer>(os);
+}
+
 // -----------------------------------------------------------------------------
 void Printer::Print(const Data &data)
 {
@@ -204,7 +239,7 @@ void Printer::Print(const Func &func)
 
   // Generate names for instructions.
   {
-    llvm::ReversePostOrderTraversal<const Func *> rpot(&func);
+    insts_.reserve(func.inst_size());
     for (const Block &block : func) {
       for (const Inst &inst : block) {
         for (unsigned i = 0, n = inst.GetNumRets(); i < n; ++i) {
@@ -321,9 +356,9 @@ void Printer::Print(ConstRef<Value> val)
           return;
         }
         case Constant::Kind::FLOAT: {
-          union { double d; int64_t i; };
+          union { double d; uint64_t i; };
           d = static_cast<const ConstantFloat &>(c).GetDouble();
-          os_ << llvm::format("0x%016" PRIx64, i);
+          llvm::write_hex(os_, i, llvm::HexPrintStyle::PrefixLower, 18);
           return;
         }
       }
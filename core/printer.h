@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <ostream>
 #include <unordered_map>
 
@@ -25,11 +26,20 @@ class Object;
 
 /**
  * Prints a program.
+ *
+ * With multiple threads, functions are printed into separate buffers by
+ * printers created through Fork, then concatenated in program order.
  */
 class Printer {
 public:
   /// Initialises the printer.
-  Printer(llvm::raw_ostream &os) : os_(os) {}
+  Printer(llvm::raw_ostream &os, unsigned threads = 1)
+    : os_(os)
+    , threads_(threads)
+  {
+  }
+  /// Cleanup.
+  virtual ~Printer() = default;
 
   /// Prints a whole program.
   virtual void Print(const Prog &prog);
@@ -57,16 +67,22 @@ protected:
   virtual void PrintFuncHeader(const Func &func) {}
   /// Hook to print additional information for instructions.
   virtual void PrintInstHeader(const Inst &inst) {}
+  /// Creates a printer for a function on a worker thread.
+  virtual std::unique_ptr<Printer> Fork(llvm::raw_ostream &os) const;
 
 private:
   /// Auto-generated printer implementation.
   void PrintImpl(const Inst &inst);
+  /// Prints the text segment, using multiple threads if requested.
+  void PrintFuncs(const Prog &prog);
 
 protected:
   /// Output stream.
   llvm::raw_ostream &os_;
 
 private:
+  /// Number of threads printing functions.
+  unsigned threads_;
   /// Instruction to identifier map.
   std::unordered_map<ConstRef<Inst>, unsigned> insts_;
 };
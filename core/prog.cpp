@@ -2,6 +2,8 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <atomic>
+
 #include "core/cast.h"
 #include "core/data.h"
 #include "core/func.h"
@@ -64,9 +66,8 @@ void Prog::AddXtor(Xtor *xtor, Xtor *before)
 // -----------------------------------------------------------------------------
 Global *Prog::GetGlobalOrExtern(const std::string_view name)
 {
-  auto it = globals_.find(name);
-  if (it != globals_.end()) {
-    return it->second;
+  if (auto *g = FindGlobal(name)) {
+    return g;
   }
   Extern *e = new Extern(name);
   externs_.push_back(e);
@@ -76,11 +77,7 @@ Global *Prog::GetGlobalOrExtern(const std::string_view name)
 // -----------------------------------------------------------------------------
 Extern *Prog::GetExtern(const std::string_view name)
 {
-  auto it = globals_.find(name);
-  if (it == globals_.end()) {
-    return nullptr;
-  }
-  return ::cast_or_null<Extern>(it->second);
+  return ::cast_or_null<Extern>(FindGlobal(name));
 }
 
 // -----------------------------------------------------------------------------
@@ -108,11 +105,17 @@ Data *Prog::GetData(const std::string_view name)
 // -----------------------------------------------------------------------------
 Global *Prog::GetGlobal(const std::string_view name) const
 {
-  auto it = globals_.find(name);
-  if (it == globals_.end()) {
-    return nullptr;
+  return FindGlobal(name);
+}
+
+// -----------------------------------------------------------------------------
+Global *Prog::FindGlobal(std::string_view name) const
+{
+  // Names which were never interned cannot belong to any global.
+  if (auto handle = Global::GetNames().Find(name)) {
+    return globals_.Find(*handle);
   }
-  return it->second;
+  return nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -178,54 +181,57 @@ llvm::iterator_range<Prog::xtor_iterator> Prog::xtor()
 // -----------------------------------------------------------------------------
 void Prog::insertGlobal(Global *g)
 {
-  auto it = globals_.emplace(g->GetName(), g);
+  std::lock_guard<std::recursive_mutex> guard(globalsLock_);
+  auto it = globals_.Insert(g->name_, g);
   if (it.second) {
     return;
   }
 
-  Global *prev = it.first->second;
+  Global *prev = it.first;
   if (auto *ext = ::cast_or_null<Extern>(prev)) {
     // Delete the extern which was replaced.
     ext->replaceAllUsesWith(g);
     ext->eraseFromParent();
 
     // Try to insert the symbol again.
-    auto st = globals_.emplace(g->GetName(), g);
+    auto st = globals_.Insert(g->name_, g);
     assert(st.second && "symbol not inserted");
   } else if (g->IsLocal()) {
-    std::string orig = g->name_;
-    static unsigned unique;
+    auto &names = Global::GetNames();
+    std::string orig(g->GetName());
+    static std::atomic<unsigned> unique;
     do {
-      g->name_ = orig + "$local" + std::to_string(unique++);
-    } while (!globals_.emplace(g->GetName(), g).second);
+      g->name_ = names.Intern(orig + "$local" + std::to_string(unique++));
+    } while (!globals_.Insert(g->name_, g).second);
   } else if (prev->IsWeak()) {
     prev->replaceAllUsesWith(g);
     prev->eraseFromParent();
-    auto st = globals_.emplace(g->GetName(), g);
+    auto st = globals_.Insert(g->name_, g);
     assert(st.second && "symbol not inserted");
   } else if (prev->IsLocal()) {
     // De-register the old name.
-    globals_.erase(prev->getName());
+    globals_.Erase(prev->name_);
     // Add the exported global with its own name.
-    auto st = globals_.emplace(g->GetName(), g);
+    auto st = globals_.Insert(g->name_, g);
     assert(st.second && "symbol not inserted");
     // Add the local with a new name.
-    std::string orig = prev->name_;
-    static unsigned unique;
+    auto &names = Global::GetNames();
+    std::string orig(prev->GetName());
+    static std::atomic<unsigned> unique;
     do {
-      prev->name_ = orig + "$local" + std::to_string(unique++);
-    } while (!globals_.emplace(prev->GetName(), prev).second);
+      prev->name_ = names.Intern(orig + "$local" + std::to_string(unique++));
+    } while (!globals_.Insert(prev->name_, prev).second);
   } else {
     llvm::report_fatal_error("duplicate symbol: " + prev->getName());
   }
 }
 
 // -----------------------------------------------------------------------------
-void Prog::removeGlobalName(std::string_view name)
+void Prog::removeGlobalName(StringInterner::Handle name)
 {
-  auto it = globals_.find(name);
-  assert(it != globals_.end() && "symbol not found");
-  globals_.erase(it);
+  std::lock_guard<std::recursive_mutex> guard(globalsLock_);
+  [[maybe_unused]] bool erased = globals_.Erase(name);
+  assert(erased && "symbol not found");
 }
 
 // -----------------------------------------------------------------------------
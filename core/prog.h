@@ -6,14 +6,15 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
 #include <vector>
-#include <unordered_map>
 #include <map>
 
 #include <llvm/ADT/ilist.h>
 #include <llvm/ADT/ilist_node.h>
 #include <llvm/ADT/iterator_range.h>
 
+#include "core/adt/symbol_map.h"
 #include "core/constant.h"
 #include "core/expr.h"
 #include "core/extern.h"
@@ -41,46 +42,8 @@ private:
   /// Type of the constructor/destructor list.
   using XtorListType = llvm::ilist<Xtor>;
 
-  /// Iterator over all globals.
-  using GlobalMap = std::unordered_map<std::string_view, Global *>;
-
-  class global_iterator
-    : public llvm::iterator_adaptor_base
-        < global_iterator
-        , GlobalMap::iterator
-        , std::random_access_iterator_tag
-        , Global *
-        >
-  {
-  public:
-    explicit global_iterator(GlobalMap::iterator it)
-      : iterator_adaptor_base(it)
-    {
-    }
-
-    Global *operator*() const { return this->I->second; }
-
-    Global *operator->() const { return this->I->second; }
-  };
-
-  class const_global_iterator
-    : public llvm::iterator_adaptor_base
-        < const_global_iterator
-        , GlobalMap::const_iterator
-        , std::random_access_iterator_tag
-        , const Global *
-        >
-  {
-  public:
-    explicit const_global_iterator(GlobalMap::const_iterator it)
-      : iterator_adaptor_base(it)
-    {
-    }
-
-    const Global *operator*() const { return this->I->second; }
-
-    const Global *operator->() const { return this->I->second; }
-  };
+  /// Mapping from interned names to globals.
+  using GlobalMap = SymbolMap<Global>;
 
 public:
   /// Iterator over the functions.
@@ -99,6 +62,10 @@ public:
   using xtor_iterator = XtorListType::iterator;
   using const_xtor_iterator = XtorListType::const_iterator;
 
+  /// Iterator over all globals.
+  using global_iterator = GlobalMap::iterator;
+  using const_global_iterator = GlobalMap::const_iterator;
+
 public:
   /// Creates a new program.
   Prog(std::string_view path);
@@ -186,10 +153,10 @@ public:
   llvm::iterator_range<xtor_iterator> xtor();
 
   /// Range of globals.
-  global_iterator global_begin() { return global_iterator(globals_.begin()); }
-  global_iterator global_end() { return global_iterator(globals_.end()); }
-  const_global_iterator global_begin() const { return const_global_iterator(globals_.begin()); }
-  const_global_iterator global_end() const { return const_global_iterator(globals_.end()); }
+  global_iterator global_begin() { return globals_.begin(); }
+  global_iterator global_end() { return globals_.end(); }
+  const_global_iterator global_begin() const { return globals_.begin(); }
+  const_global_iterator global_end() const { return globals_.end(); }
   llvm::iterator_range<global_iterator> globals();
   llvm::iterator_range<const_global_iterator> globals() const;
 
@@ -206,7 +173,9 @@ private:
   friend struct llvm::ilist_traits<Object>;
 
   void insertGlobal(Global *g);
-  void removeGlobalName(std::string_view name);
+  void removeGlobalName(StringInterner::Handle name);
+  /// Finds a global by name.
+  Global *FindGlobal(std::string_view name) const;
 
   static FuncListType Prog::*getSublistAccess(Func *) { return &Prog::funcs_; }
   static ExternListType Prog::*getSublistAccess(Extern *) { return &Prog::externs_; }
@@ -217,7 +186,9 @@ private:
   /// Name of the program.
   std::string name_;
   /// Mapping from names to symbols.
-  std::unordered_map<std::string_view, Global *> globals_;
+  GlobalMap globals_;
+  /// Lock for the symbol table, updated when blocks change concurrently.
+  std::recursive_mutex globalsLock_;
   /// Chain of functions.
   FuncListType funcs_;
   /// Chain of data segments.
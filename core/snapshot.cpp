@@ -0,0 +1,72 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <algorithm>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "core/bitcode.h"
+#include "core/clone.h"
+#include "core/prog.h"
+#include "core/snapshot.h"
+
+
+
+// -----------------------------------------------------------------------------
+SnapshotWriter::SnapshotWriter(const std::string &path, unsigned count)
+  : path_(path)
+  , count_(std::max(count, 1u))
+  , seq_(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+SnapshotWriter::~SnapshotWriter()
+{
+  Wait();
+}
+
+// -----------------------------------------------------------------------------
+void SnapshotWriter::Save(Prog &prog, const char *pass, unsigned iteration)
+{
+  // Only one snapshot is written at a time.
+  Wait();
+
+  // Remove the oldest snapshots. All of them were written by now.
+  while (files_.size() >= count_) {
+    llvm::sys::fs::remove(files_.front());
+    files_.pop_front();
+  }
+
+  // Name the file after the pass and the iteration, keeping the extension.
+  llvm::StringRef ext = llvm::sys::path::extension(path_);
+  llvm::StringRef stem = llvm::StringRef(path_).drop_back(ext.size());
+  std::string path;
+  llvm::raw_string_ostream(path)
+      << stem << "." << seq_++ << "." << pass << "." << iteration << ext;
+  files_.push_back(path);
+
+  // The copy shares no values with the original, thus it can be serialised
+  // and freed concurrently with the transformations applied to the program.
+  thread_ = std::thread([copy = Clone(prog), path] {
+    std::error_code err;
+    llvm::raw_fd_ostream os(path, err);
+    if (err) {
+      llvm::errs() << "[Error] Cannot write snapshot: " << err.message();
+      llvm::errs() << "\n";
+      return;
+    }
+    BitcodeWriter(os).Write(*copy);
+  });
+}
+
+// -----------------------------------------------------------------------------
+void SnapshotWriter::Wait()
+{
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
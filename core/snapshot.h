@@ -0,0 +1,54 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+
+class Prog;
+
+
+
+/**
+ * Writes snapshots of a program to a rotating set of bitcode files.
+ *
+ * The program is copied on the calling thread and the copy is serialised
+ * on a background thread, while the caller continues transforming the
+ * original. Only the most recent snapshots are kept on disk.
+ */
+class SnapshotWriter final {
+public:
+  /**
+   * Creates a writer.
+   *
+   * @param path  Path to derive the names of the snapshot files from.
+   * @param count Number of snapshot files to keep.
+   */
+  SnapshotWriter(const std::string &path, unsigned count);
+
+  /// Waits for the pending snapshot to be written.
+  ~SnapshotWriter();
+
+  /// Writes a snapshot of the program, taken before a pass.
+  void Save(Prog &prog, const char *pass, unsigned iteration);
+
+private:
+  /// Waits for the pending snapshot to be written.
+  void Wait();
+
+private:
+  /// Path to derive the names of the snapshot files from.
+  std::string path_;
+  /// Number of snapshots to keep.
+  unsigned count_;
+  /// Sequence number of the next snapshot.
+  unsigned seq_;
+  /// Files written so far, oldest first.
+  std::deque<std::string> files_;
+  /// Thread writing the pending snapshot.
+  std::thread thread_;
+};
@@ -38,6 +38,15 @@ Prog *getProg(T *child)
   }
 }
 
+// -----------------------------------------------------------------------------
+template <typename T>
+void Touch(T *parent)
+{
+  if constexpr (std::is_same<T, Func>::value) {
+    parent->Touch();
+  }
+}
+
 // -----------------------------------------------------------------------------
 template <typename T>
 void SymbolTableListTraits<T>::addNodeToList(T *node)
@@ -48,15 +57,23 @@ void SymbolTableListTraits<T>::addNodeToList(T *node)
   if (auto *table = getProg<ParentTy>(parent)) {
     table->insertGlobal(node);
   }
+  if constexpr (std::is_same<T, Block>::value) {
+    parent->AttachBlock(*node);
+  }
+  Touch<ParentTy>(parent);
 }
 
 // -----------------------------------------------------------------------------
 template <typename T>
 void SymbolTableListTraits<T>::removeNodeFromList(T *node) {
+  if constexpr (std::is_same<T, Block>::value) {
+    getParent()->DetachBlock(*node);
+  }
   node->setParent(nullptr);
   if (auto *table = getProg<ParentTy>(getParent())) {
-    table->removeGlobalName(node->GetName());
+    table->removeGlobalName(node->GetNameHandle());
   }
+  Touch<ParentTy>(getParent());
 }
 
 // -----------------------------------------------------------------------------
@@ -75,7 +92,7 @@ void SymbolTableListTraits<T>::transferNodesFromList(
     for (auto it = first; it != last; ++it) {
       T &V = *it;
       if (oldProg) {
-        oldProg->removeGlobalName(V.GetName());
+        oldProg->removeGlobalName(V.GetNameHandle());
       }
       V.setParent(newParent);
       if (newProg) {
@@ -87,6 +104,14 @@ void SymbolTableListTraits<T>::transferNodesFromList(
       it->setParent(newParent);
     }
   }
+  if constexpr (std::is_same<T, Block>::value) {
+    for (auto it = first; it != last; ++it) {
+      oldParent->DetachBlock(*it);
+      newParent->AttachBlock(*it);
+    }
+  }
+  Touch<ParentTy>(newParent);
+  Touch<ParentTy>(oldParent);
 }
 
 // -----------------------------------------------------------------------------
@@ -117,10 +142,10 @@ void SymbolTableListTraits<Func>::removeNodeFromList(Func *func)
   auto *prog = func->getParent();
   func->setParent(nullptr);
   for (Block &block : *func) {
-    parent->removeGlobalName(block.GetName());
+    parent->removeGlobalName(block.GetNameHandle());
   }
   if (prog) {
-    prog->removeGlobalName(func->GetName());
+    prog->removeGlobalName(func->GetNameHandle());
   }
 }
 
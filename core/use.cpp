@@ -2,13 +2,81 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <mutex>
 
+#include "core/block.h"
+#include "core/cast.h"
+#include "core/func.h"
+#include "core/global.h"
+#include "core/inst.h"
 #include "core/use.h"
 #include "core/value.h"
 
 
+
+// -----------------------------------------------------------------------------
+static constexpr unsigned kNumLocks = 64;
+/// Flag indicating whether functions are being transformed concurrently.
+static std::atomic<bool> kConcurrent(false);
+/// Striped locks protecting the use lists of shared values.
+static std::mutex kLocks[kNumLocks];
+
+// -----------------------------------------------------------------------------
+static std::unique_lock<std::mutex> LockUses(Value *v)
+{
+  if (!kConcurrent.load(std::memory_order_acquire)) {
+    return {};
+  }
+  // Instructions and blocks are only referenced from their own function.
+  switch (v->GetKind()) {
+    case Value::Kind::INST: {
+      return {};
+    }
+    case Value::Kind::GLOBAL: {
+      if (static_cast<Global *>(v)->Is(Global::Kind::BLOCK)) {
+        return {};
+      }
+      break;
+    }
+    case Value::Kind::EXPR:
+    case Value::Kind::CONST: {
+      break;
+    }
+  }
+  auto key = reinterpret_cast<uintptr_t>(v) >> 4;
+  return std::unique_lock<std::mutex>(kLocks[key % kNumLocks]);
+}
+
+// -----------------------------------------------------------------------------
+static void TouchUser(User *user)
+{
+  // Operands of instructions are part of the body of their function.
+  if (auto *inst = ::cast_or_null<Inst>(user)) {
+    if (Block *block = inst->getParent()) {
+      if (Func *func = block->getParent()) {
+        func->Touch();
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void TouchValue(Value *v)
+{
+  // Use lists of functions and blocks determine whether their address is
+  // taken, affecting the transformations applicable to their functions.
+  if (auto *func = ::cast_or_null<Func>(v)) {
+    func->Touch();
+  } else if (auto *block = ::cast_or_null<Block>(v)) {
+    if (Func *func = block->getParent()) {
+      func->Touch();
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 Use::Use(Ref<Value> val, User *user)
   : val_(val), user_(user)
@@ -29,10 +97,13 @@ Use &Use::operator=(Ref<Value> val)
 void Use::Remove()
 {
   if (val_ && (reinterpret_cast<uintptr_t>(val_.Get()) & 1) == 0) {
+    auto guard = LockUses(val_.Get());
     if (next_) { next_->prev_ = prev_; }
     if (prev_) { prev_->next_ = next_; }
     if (this == val_->users_) { val_->users_ = next_; }
     next_ = prev_ = nullptr;
+    TouchValue(val_.Get());
+    TouchUser(user_);
   }
 }
 
@@ -40,10 +111,13 @@ void Use::Remove()
 void Use::Add()
 {
   if (val_ && (reinterpret_cast<uintptr_t>(val_.Get()) & 1) == 0) {
+    auto guard = LockUses(val_.Get());
     next_ = val_->users_;
     prev_ = nullptr;
     if (next_) { next_->prev_ = this; }
     val_->users_ = this;
+    TouchValue(val_.Get());
+    TouchUser(user_);
   }
 }
 
@@ -52,3 +126,9 @@ Use::~Use()
 {
   Remove();
 }
+
+// -----------------------------------------------------------------------------
+void Use::SetConcurrent(bool concurrent)
+{
+  kConcurrent.store(concurrent, std::memory_order_release);
+}
@@ -64,6 +64,9 @@ public:
   // Checks if the use points to a value.
   operator bool() const { return val_; }
 
+  /// Enables locking on the use lists of values shared between functions.
+  static void SetConcurrent(bool concurrent);
+
 private:
   friend class Value;
   friend class User;
@@ -4,6 +4,7 @@
 
 #include <cassert>
 
+#include "core/adt/slab.h"
 #include "core/user.h"
 #include "core/block.h"
 #include "core/cast.h"
@@ -66,6 +67,24 @@ ConstRef<Block> User::const_conv_op_iterator<Block>::operator->() const
   return ::cast<Block>(*this->I);
 }
 
+// -----------------------------------------------------------------------------
+static Use *AllocateUses(const User *user, unsigned n)
+{
+  // Expressions can be shared with data and outlive the function they were
+  // built in, thus their operands are kept in the shared arena.
+  if (user->Is(Value::Kind::EXPR)) {
+    SlabArena::Scope scope(nullptr);
+    return static_cast<Use *>(SlabAllocator::Allocate(n * sizeof(Use)));
+  }
+  return static_cast<Use *>(SlabAllocator::Allocate(n * sizeof(Use)));
+}
+
+// -----------------------------------------------------------------------------
+static void FreeUses(Use *uses, unsigned n)
+{
+  SlabAllocator::Deallocate(static_cast<void *>(uses), n * sizeof(Use));
+}
+
 // -----------------------------------------------------------------------------
 User::User(Kind kind, unsigned numOps)
   : Value(kind)
@@ -73,7 +92,7 @@ User::User(Kind kind, unsigned numOps)
   , uses_(nullptr)
 {
   if (numOps > 0) {
-    uses_ = static_cast<Use *>(malloc(numOps_ * sizeof(Use)));
+    uses_ = AllocateUses(this, numOps_);
     for (unsigned i = 0; i < numOps_; ++i) {
       new (&uses_[i]) Use(nullptr, this);
     }
@@ -86,7 +105,7 @@ User::~User()
   for (unsigned i = 0; i < numOps_; ++i) {
     uses_[i] = nullptr;
   }
-  free(static_cast<void *>(uses_));
+  FreeUses(uses_, numOps_);
 }
 
 // -----------------------------------------------------------------------------
@@ -145,12 +164,12 @@ void User::resizeUses(unsigned n)
     for (unsigned i = 0; i < numOps_; ++i) {
       uses_[i] = nullptr;
     }
-    free(static_cast<void *>(uses_));
+    FreeUses(uses_, numOps_);
     uses_ = nullptr;
     numOps_ = n;
   } else {
     // Transfer old uses to newly allocated ones.
-    Use *newUses = static_cast<Use *>(malloc(n * sizeof(Use)));
+    Use *newUses = AllocateUses(this, n);
     for (unsigned i = 0; i < numOps_; ++i) {
       uses_[i].Remove();
       if (i < n) {
@@ -159,9 +178,7 @@ void User::resizeUses(unsigned n)
     }
 
     // Switch the lists.
-    if (uses_) {
-      free(uses_);
-    }
+    FreeUses(uses_, numOps_);
     uses_ = newUses;
 
     // Initialise the new elements.
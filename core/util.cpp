@@ -5,6 +5,7 @@
 #include <llvm/Support/Endian.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include "core/bitcode.h"
 #include "core/parser.h"
@@ -34,12 +35,16 @@ bool IsLLIRObject(llvm::StringRef buffer)
 }
 
 // -----------------------------------------------------------------------------
-std::unique_ptr<Prog> Parse(llvm::StringRef buffer, std::string_view name)
+std::unique_ptr<Prog> Parse(
+    llvm::StringRef buffer,
+    std::string_view name,
+    unsigned threads)
 {
+  llvm::TimeTraceScope scope("Parse", [name] { return std::string(name); });
   if (ReadData<uint32_t>(buffer, 0) != kLLIRMagic) {
-    return Parser(buffer, name).Parse();
+    return Parser(buffer, name, threads).Parse();
   }
-  return BitcodeReader(buffer).Read();
+  return BitcodeReader(buffer, threads).Read();
 }
 
 // -----------------------------------------------------------------------------
@@ -14,6 +14,12 @@ class Prog;
 
 /// Magic number for LLIR bitcode files.
 constexpr uint32_t kLLIRMagic = 0x52494C4C;
+/// Marker following the magic in files which carry a revision. Unrevised
+/// files continue with the length of the program name, which cannot be
+/// this large.
+constexpr uint32_t kLLIRRevisionMarker = 0xFFFFFFFF;
+/// Revision of the bitcode format.
+constexpr uint32_t kLLIRVersion = 2;
 /// Returns true if the buffer contains and LLIR object.
 bool IsLLIRObject(llvm::StringRef buffer);
 
@@ -47,7 +53,11 @@ template<typename T> T ReadData(llvm::StringRef buffer, uint64_t offset)
 /**
  * Parses an object or a bitcode file.
  */
-std::unique_ptr<Prog> Parse(llvm::StringRef buffer, std::string_view name);
+std::unique_ptr<Prog> Parse(
+    llvm::StringRef buffer,
+    std::string_view name,
+    unsigned threads = 1
+);
 
 /**
  * Converts a path to an absolute path.
@@ -15,6 +15,7 @@
 #include <llvm/IR/Mangler.h>
 #include <llvm/MC/MCObjectFileInfo.h>
 #include <llvm/MC/MCStreamer.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include "core/block.h"
 #include "core/cast.h"
@@ -57,6 +58,8 @@ AnnotPrinter::AnnotPrinter(
 // -----------------------------------------------------------------------------
 bool AnnotPrinter::runOnModule(llvm::Module &M)
 {
+  llvm::TimeTraceScope scope("AnnotPrinter");
+
   const unsigned adjust = GetImplicitStackSize();
   auto &MMI = getAnalysis<llvm::MachineModuleInfoWrapperPass>().getMMI();
 
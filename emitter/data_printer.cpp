@@ -6,6 +6,7 @@
 #include <llvm/CodeGen/MachineModuleInfo.h>
 #include <llvm/IR/Mangler.h>
 #include <llvm/MC/MCSectionELF.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include "core/cast.h"
 #include "core/data.h"
@@ -46,6 +47,8 @@ DataPrinter::DataPrinter(
 // -----------------------------------------------------------------------------
 bool DataPrinter::runOnModule(llvm::Module &)
 {
+  llvm::TimeTraceScope scope("DataPrinter");
+
   for (const Extern &ext : prog_.externs()) {
     LowerExtern(ext);
   }
@@ -17,6 +17,7 @@
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/Target/TargetLoweringObjectFile.h>
@@ -186,9 +187,15 @@ void Emitter::Emit(llvm::CodeGenFileType type, const Prog &prog)
 
     // Run the printer, emitting code.
     static char kBeginID, kEndID;
-    passMngr.add(new LambdaPass(kBeginID, [&emitSymbol] { emitSymbol("_begin"); }));
+    passMngr.add(new LambdaPass(kBeginID, [&emitSymbol] {
+      llvm::timeTraceProfilerBegin("MCPrinter", "");
+      emitSymbol("_begin");
+    }));
     passMngr.add(printer);
-    passMngr.add(new LambdaPass(kEndID, [&emitSymbol] { emitSymbol("_end"); }));
+    passMngr.add(new LambdaPass(kEndID, [&emitSymbol] {
+      emitSymbol("_end");
+      llvm::timeTraceProfilerEnd();
+    }));
 
     // Add a pass to clean up memory.
     passMngr.add(llvm::createFreeMachineFunctionPass());
@@ -9,10 +9,18 @@
 
 #include <llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/CodeGen.h>
 #include <llvm/Support/raw_ostream.h>
 
 #include "core/target.h"
 
+namespace llvm {
+class LLVMTargetMachine;
+class MCContext;
+class MCStreamer;
+class TargetLoweringObjectFile;
+}
+
 class Prog;
 class ISel;
 class AnnotPrinter;
@@ -19,6 +19,7 @@
 #include <llvm/IR/GlobalValue.h>
 #include <llvm/IR/Mangler.h>
 #include <llvm/IR/LegacyPassManagers.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include "emitter/isel.h"
 #include "core/block.h"
@@ -123,6 +124,8 @@ bool ISel::runOnModule(llvm::Module &Module)
 
   // Generate code for functions.
   for (const Func &func : prog_) {
+    llvm::TimeTraceScope scope("ISel", func.getName());
+
     // Save a pointer to the current function.
     func_ = &func;
     lva_ = nullptr;
@@ -659,12 +662,12 @@ llvm::SDValue ISel::GetValue(ConstRef<Inst> inst)
     return vt->second;
   }
 
-  if (auto rt = regs_.find(inst); rt != regs_.end()) {
+  if (auto *rt = regs_.Find(inst)) {
     auto &DAG = GetDAG();
     auto &Ctx = *DAG.getContext();
 
     llvm::SmallVector<SDValue, 2> parts;
-    for (auto &[reg, regVT] : rt->second) {
+    for (auto &[reg, regVT] : *rt) {
       parts.push_back(DAG.getCopyFromReg(
           DAG.getEntryNode(),
           SDL_,
@@ -704,12 +707,11 @@ llvm::SDValue ISel::GetValue(ConstRef<Inst> inst)
 void ISel::Export(ConstRef<Inst> inst, SDValue value)
 {
   values_[inst] = value;
-  auto it = regs_.find(inst);
-  if (it != regs_.end()) {
+  if (auto *regs = regs_.Find(inst)) {
     if (inst.GetType() == Type::V64) {
-      pendingValueInsts_.emplace(inst, it->second);
+      pendingValueInsts_.emplace(inst, *regs);
     } else {
-      pendingPrimInsts_.emplace(inst, it->second);
+      pendingPrimInsts_.emplace(inst, *regs);
     }
   }
 }
@@ -1653,18 +1655,17 @@ void ISel::HandleSuccessorPHI(const Block *block)
       RegParts regs;
       switch (inst->GetKind()) {
         default: {
-          auto it = regs_.find(inst);
-          assert(it != regs_.end() && "missing vreg value");
-          regs = it->second;
+          auto *it = regs_.Find(inst);
+          assert(it && "missing vreg value");
+          regs = *it;
           break;
         }
         case Inst::Kind::MOV: {
           ConstRef<Value> arg = GetMoveArg(::cast<MovInst>(inst));
           switch (arg->GetKind()) {
             case Value::Kind::INST: {
-              auto it = regs_.find(inst);
-              if (it != regs_.end()) {
-                regs = it->second;
+              if (auto *it = regs_.Find(inst)) {
+                regs = *it;
               } else {
                 regs = ExportValue(LowerConstant(inst));
               }
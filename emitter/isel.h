@@ -10,6 +10,7 @@
 #include <llvm/CodeGen/SelectionDAG/ScheduleDAGSDNodes.h>
 #include <llvm/CodeGen/SelectionDAGNodes.h>
 
+#include "core/adt/dense_inst_map.h"
 #include "core/analysis/live_variables.h"
 #include "core/insts.h"
 #include "core/type.h"
@@ -330,7 +331,7 @@ protected:
   /// Mapping from nodes to values.
   std::unordered_map<ConstRef<Inst>, llvm::SDValue> values_;
   /// Mapping from nodes to registers.
-  std::unordered_map<ConstRef<Inst>, RegParts> regs_;
+  DenseInstMap<RegParts> regs_;
   /// Mapping from stack_object indices to llvm stack objects.
   llvm::DenseMap<unsigned, unsigned> stackIndices_;
   /// Frame start index, if necessary.
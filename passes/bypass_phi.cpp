@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <stack>
 
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/Statistic.h>
 
 #include "core/block.h"
@@ -14,6 +15,7 @@
 #include "core/prog.h"
 #include "core/insts.h"
 #include "core/clone.h"
+#include "core/pass_manager.h"
 #include "core/analysis/dominator.h"
 #include "passes/bypass_phi.h"
 
@@ -55,6 +57,12 @@ const char *BypassPhiPass::GetPassName() const
   return "Control Flow Simplification";
 }
 
+// -----------------------------------------------------------------------------
+PreservedAnalyses BypassPhiPass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<DominatorAnalysis>();
+}
+
 // -----------------------------------------------------------------------------
 namespace {
 class Cloner final : public CloneVisitor {
@@ -126,9 +134,10 @@ bool BypassPhiPass::Bypass(
   }
 
   // Find the set of nodes dominated by the original block.
+  auto &doms = getAnalysis<DominatorAnalysis>(f);
   std::set<Block *> dominatedByBlock;
   {
-    DominatorTree DT(f);
+    auto &DT = doms.GetDominatorTree();
     std::function<void(Block *)> traverse = [&](Block *b)
     {
       dominatedByBlock.insert(b);
@@ -139,31 +148,35 @@ bool BypassPhiPass::Bypass(
     traverse(&block);
   }
 
+  // Helper to redirect the edges of a block, recording CFG updates.
+  std::vector<DominatorAnalysis::Update> updates;
+  auto redirect = [&] (Block *b, Block *from, Block *to)
+  {
+    bool hadEdge = llvm::is_contained(b->successors(), to);
+    auto *term = b->GetTerminator();
+    auto *newTerm = Cloner(from, to).Clone(term);
+    b->AddInst(newTerm);
+    term->replaceAllUsesWith(newTerm);
+    term->eraseFromParent();
+    updates.emplace_back(llvm::cfg::UpdateKind::Delete, b, from);
+    if (!hadEdge) {
+      updates.emplace_back(llvm::cfg::UpdateKind::Insert, b, to);
+    }
+  };
+
   // Bypass the block from pred to target.
   Block *phiPlace = nullptr;
   if (target->pred_size() == 1) {
     phiPlace = target;
-    auto *predTerm = pred->GetTerminator();
-    auto *newPredTerm = Cloner(&block, target).Clone(predTerm);
-    pred->AddInst(newPredTerm);
-    predTerm->replaceAllUsesWith(newPredTerm);
-    predTerm->eraseFromParent();
+    redirect(pred, &block, target);
   } else {
     auto *join = new Block(target->getName());
     target->getParent()->AddBlock(join, target);
     join->AddInst(new JumpInst(target, {}));
+    updates.emplace_back(llvm::cfg::UpdateKind::Insert, join, target);
 
-    auto *predTerm = pred->GetTerminator();
-    auto *newPredTerm = Cloner(&block, join).Clone(predTerm);
-    pred->AddInst(newPredTerm);
-    predTerm->replaceAllUsesWith(newPredTerm);
-    predTerm->eraseFromParent();
-
-    auto *blockTerm = block.GetTerminator();
-    auto *newBlockTerm = Cloner(target, join).Clone(blockTerm);
-    block.AddInst(newBlockTerm);
-    blockTerm->replaceAllUsesWith(newBlockTerm);
-    blockTerm->eraseFromParent();
+    redirect(pred, &block, join);
+    redirect(&block, target, join);
 
     phiPlace = join;
     for (PhiInst &phi : target->phis()) {
@@ -186,9 +199,10 @@ bool BypassPhiPass::Bypass(
     phis.emplace_back(&phi, newPhi);
   }
 
-  DominatorTree DT(f);
-  DominanceFrontier DF;
-  DF.analyze(DT);
+  // Update the cached dominator tree instead of rebuilding it.
+  doms.ApplyUpdates(updates);
+  auto &DT = doms.GetDominatorTree();
+  auto &DF = doms.GetDominanceFrontier();
 
   std::unordered_map<PhiInst *, PhiInst *> newPhis;
   for (auto [oldPhi, newPhi] : phis) {
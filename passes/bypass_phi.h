@@ -31,6 +31,9 @@ public:
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
   /// Bypasses redundant comparisons involving PHIs.
   bool BypassPhiCmp(Block &block);
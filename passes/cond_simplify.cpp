@@ -15,6 +15,7 @@
 #include "core/inst_visitor.h"
 #include "core/inst_compare.h"
 #include "core/analysis/dominator.h"
+#include "core/pass_manager.h"
 #include "passes/cond_simplify.h"
 
 #define DEBUG_TYPE "cond-simplify"
@@ -118,9 +119,9 @@ static std::optional<int64_t> GetConstant(Ref<Inst> inst)
 // -----------------------------------------------------------------------------
 class CondSimplifier : public InstVisitor<bool> {
 public:
-  CondSimplifier(Func &func)
+  CondSimplifier(Func &func, DominatorTree &dt)
     : func_(func)
-    , dt_(func)
+    , dt_(dt)
   {
   }
 
@@ -362,7 +363,7 @@ private:
   /// Function to simplify.
   Func &func_;
   /// Dominator tree.
-  DominatorTree dt_;
+  DominatorTree &dt_;
   /// Stack of conditions.
   std::vector<Condition> conds_;
   /// Stack of dominators.
@@ -378,13 +379,20 @@ bool CondSimplifyPass::Run(Prog &prog)
 {
   bool changed = false;
   for (Func &func : prog) {
-    if (CondSimplifier(func).Traverse(func.getEntryBlock())) {
+    auto &dt = getAnalysis<DominatorAnalysis>(func).GetDominatorTree();
+    if (CondSimplifier(func, dt).Traverse(func.getEntryBlock())) {
       changed = true;
     }
   }
   return changed;
 }
 
+// -----------------------------------------------------------------------------
+PreservedAnalyses CondSimplifyPass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<DominatorAnalysis>();
+}
+
 
 // -----------------------------------------------------------------------------
 const char *CondSimplifyPass::GetPassName() const
@@ -26,4 +26,7 @@ public:
 
   /// Returns the name of the pass.
   const char *GetPassName() const override;
+
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
 };
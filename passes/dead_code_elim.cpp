@@ -2,6 +2,8 @@
 // Licensing information can be found in the LICENSE file.
 // (C) 2018 Nandor Licker. All rights reserved.
 
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/Statistic.h>
 
 #include "core/block.h"
@@ -10,7 +12,9 @@
 #include "core/func.h"
 #include "core/prog.h"
 #include "core/analysis/dominator.h"
+#include "core/pass_manager.h"
 #include "passes/dead_code_elim.h"
+#include "passes/pta.h"
 
 #define DEBUG_TYPE "dead-code-elim"
 
@@ -22,30 +26,25 @@ STATISTIC(NumBlocksRemoved, "Unreachable blocks removed");
 const char *DeadCodeElimPass::kPassID = "dead-code-elim";
 
 // -----------------------------------------------------------------------------
-bool DeadCodeElimPass::Run(Prog &prog)
+const char *DeadCodeElimPass::GetPassName() const
 {
-  bool changed = false;
-  for (auto &func : prog) {
-    if (Run(func)) {
-      LLVM_DEBUG(llvm::dbgs() << func.getName() << "\n");
-      changed = true;
-    }
-  }
-  return changed;
+  return "Dead Code Elimination";
 }
 
 // -----------------------------------------------------------------------------
-const char *DeadCodeElimPass::GetPassName() const
+PreservedAnalyses DeadCodeElimPass::GetPreserved() const
 {
-  return "Dead Code Elimination";
+  return PreservedAnalyses()
+      .Preserve<PointsToAnalysis>()
+      .Preserve<DominatorAnalysis>();
 }
 
 // -----------------------------------------------------------------------------
 bool DeadCodeElimPass::Run(Func &func)
 {
-  PostDominatorTree PDT(func);
-  PostDominanceFrontier PDF;
-  PDF.analyze(PDT);
+  auto &doms = getAnalysis<DominatorAnalysis>(func);
+  auto &PDT = doms.GetPostDominatorTree();
+  auto &PDF = doms.GetPostDominanceFrontier();
 
   std::set<Inst *> marked;
   std::queue<Inst *> work;
@@ -117,6 +116,32 @@ bool DeadCodeElimPass::Run(Func &func)
   // Count the number of dead blocks.
   NumBlocksRemoved += func.size() - useful.size();
 
+  // Helper to replace a terminator, recording the edges which changed.
+  std::vector<DominatorAnalysis::Update> updates;
+  auto replace = [&] (Block &block, Inst *inst, Inst *term)
+  {
+    llvm::SmallVector<Block *, 4> oldSuccs(
+        block.succ_begin(),
+        block.succ_end()
+    );
+    block.AddInst(term);
+    inst->eraseFromParent();
+    llvm::SmallVector<Block *, 4> newSuccs(
+        block.succ_begin(),
+        block.succ_end()
+    );
+    for (Block *succ : oldSuccs) {
+      if (!llvm::is_contained(newSuccs, succ)) {
+        updates.emplace_back(llvm::cfg::UpdateKind::Delete, &block, succ);
+      }
+    }
+    for (Block *succ : newSuccs) {
+      if (!llvm::is_contained(oldSuccs, succ)) {
+        updates.emplace_back(llvm::cfg::UpdateKind::Insert, &block, succ);
+      }
+    }
+  };
+
   // Remove unmarked instructions.
   bool changed = false;
   for (auto &block : func) {
@@ -131,13 +156,11 @@ bool DeadCodeElimPass::Run(Func &func)
         case Inst::Kind::JUMP: {
           if (auto *target = findTarget(inst)) {
             if (target != static_cast<JumpInst *>(inst)->GetTarget()) {
-              block.AddInst(new JumpInst(target, inst->GetAnnots()));
-              inst->eraseFromParent();
+              replace(block, inst, new JumpInst(target, inst->GetAnnots()));
               changed = true;
             }
           } else {
-            block.AddInst(new TrapInst(inst->GetAnnots()));
-            inst->eraseFromParent();
+            replace(block, inst, new TrapInst(inst->GetAnnots()));
             changed = true;
           }
           break;
@@ -145,11 +168,10 @@ bool DeadCodeElimPass::Run(Func &func)
         case Inst::Kind::SWITCH:
         case Inst::Kind::JUMP_COND: {
           if (auto *target = findTarget(inst)) {
-            block.AddInst(new JumpInst(target, inst->GetAnnots()));
+            replace(block, inst, new JumpInst(target, inst->GetAnnots()));
           } else {
-            block.AddInst(new TrapInst(inst->GetAnnots()));
+            replace(block, inst, new TrapInst(inst->GetAnnots()));
           }
-          inst->eraseFromParent();
           changed = true;
           break;
         }
@@ -161,5 +183,12 @@ bool DeadCodeElimPass::Run(Func &func)
       }
     }
   }
+  if (changed) {
+    LLVM_DEBUG(llvm::dbgs() << func.getName() << "\n");
+  }
+  // Keep the dominance information of the function in sync with the CFG.
+  if (!updates.empty()) {
+    doms.ApplyUpdates(updates);
+  }
   return changed;
 }
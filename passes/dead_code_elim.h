@@ -11,21 +11,20 @@
 /**
  * Pass which eliminates unused functions and symbols.
  */
-class DeadCodeElimPass final : public Pass {
+class DeadCodeElimPass final : public FuncPass {
 public:
   /// Pass identifier.
   static const char *kPassID;
 
   /// Initialises the pass.
-  DeadCodeElimPass(PassManager *passManager) : Pass(passManager) {}
+  DeadCodeElimPass(PassManager *passManager) : FuncPass(passManager) {}
 
-  /// Runs the pass.
-  bool Run(Prog &prog) override;
+  /// Runs the pass on a function.
+  bool Run(Func &func) override;
 
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
-private:
-  /// Runs the pass on a function.
-  bool Run(Func &func);
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
 };
@@ -5,6 +5,7 @@
 #include <llvm/ADT/Statistic.h>
 #include <llvm/ADT/SmallPtrSet.h>
 
+#include "core/analysis.h"
 #include "core/block.h"
 #include "core/cast.h"
 #include "core/data.h"
@@ -27,6 +28,12 @@ const char *DeadDataElimPass::GetPassName() const
   return "Data Elimination";
 }
 
+// -----------------------------------------------------------------------------
+PreservedAnalyses DeadDataElimPass::GetPreserved() const
+{
+  return PreservedAnalyses::All();
+}
+
 
 
 // -----------------------------------------------------------------------------
@@ -27,6 +27,9 @@ public:
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
   /// Remove unused externs.
   bool RemoveExterns(Prog &prog);
@@ -14,6 +14,7 @@
 #include "core/func.h"
 #include "core/pass_manager.h"
 #include "core/prog.h"
+#include "core/analysis/call_graph.h"
 #include "passes/dead_func_elim.h"
 #include "passes/pta.h"
 
@@ -35,6 +36,8 @@ bool DeadFuncElimPass::Run(Prog &prog)
 
   // Get the points-to analysis.
   auto *pta = getAnalysis<PointsToAnalysis>();
+  // Get the call graph, to be kept up to date.
+  auto &cg = getAnalysis<CallGraphAnalysis>(prog);
 
   // Find all functions which are referenced from data sections.
   for (auto &func : prog) {
@@ -89,6 +92,7 @@ bool DeadFuncElimPass::Run(Prog &prog)
     }
 
     if (f->use_empty()) {
+      cg.Remove(*f);
       f->eraseFromParent();
       NumFuncsRemoved++;
       continue;
@@ -99,6 +103,7 @@ bool DeadFuncElimPass::Run(Prog &prog)
       auto *bb = new Block((".L" + f->getName() + "_dead_trap").str());
       f->AddBlock(bb);
       bb->AddInst(new TrapInst({}));
+      cg.Update(*f);
       NumFuncsRemoved++;
       changed = true;
     }
@@ -111,3 +116,11 @@ const char *DeadFuncElimPass::GetPassName() const
 {
   return "Dead Function Elimination";
 }
+
+// -----------------------------------------------------------------------------
+PreservedAnalyses DeadFuncElimPass::GetPreserved() const
+{
+  return PreservedAnalyses()
+      .Preserve<PointsToAnalysis>()
+      .Preserve<CallGraphAnalysis>();
+}
@@ -3,8 +3,10 @@
 // (C) 2018 Nandor Licker. All rights reserved.
 
 #include <set>
-#include <map>
 
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/Statistic.h>
 
 #include "core/block.h"
@@ -14,6 +16,7 @@
 #include "core/inst_visitor.h"
 #include "core/inst_compare.h"
 #include "core/analysis/dominator.h"
+#include "core/analysis/kildall.h"
 #include "passes/dead_store.h"
 
 #define DEBUG_TYPE "dead-store"
@@ -42,10 +45,6 @@ bool DeadStorePass::Run(Prog &prog)
   return changed;
 }
 
-// -----------------------------------------------------------------------------
-using StoreMap = std::map<Global *, MemoryStoreInst *>;
-using BlockToStores = std::map<Block *, StoreMap>;
-
 // -----------------------------------------------------------------------------
 static Global *ToGlobal(Ref<Inst> addr)
 {
@@ -66,121 +65,112 @@ static Global *ToGlobal(Ref<Inst> addr)
   return nullptr;
 }
 
+// -----------------------------------------------------------------------------
+using DeadStoreSolverBase = BitVectorSolver
+    < Direction::BACKWARD
+    , Meet::INTERSECT
+    >;
+
 // -----------------------------------------------------------------------------
 class DeadStoreVisitor : public InstVisitor<void> {
 public:
-  DeadStoreVisitor(StoreMap &stores) : stores_(stores) {}
+  DeadStoreVisitor(
+      const llvm::DenseMap<Global *, unsigned> &globals,
+      DeadStoreSolverBase::KillGen &kg)
+    : globals_(globals)
+    , kg_(kg)
+  {
+  }
 
   void VisitInst(Inst &i) { }
 
   void VisitMemoryStoreInst(MemoryStoreInst &store)
   {
     if (auto *g = ToGlobal(store.GetAddr())) {
-      stores_[g] = &store;
+      kg_.Gen(globals_.find(g)->second);
     } else {
-      stores_.clear();
+      kg_.KillAll();
     }
   }
 
-  void VisitMemoryLoadInst(MemoryLoadInst &store) { stores_.clear(); }
-  void VisitBarrierInst(BarrierInst &i) { stores_.clear(); }
-  void VisitMemoryExchangeInst(MemoryExchangeInst &i) { stores_.clear(); }
-  void VisitCallSite(CallSite &i) { stores_.clear(); }
-  void VisitX86_FPUControlInst(X86_FPUControlInst &i) { stores_.clear(); }
+  void VisitMemoryLoadInst(MemoryLoadInst &store) { kg_.KillAll(); }
+  void VisitBarrierInst(BarrierInst &i) { kg_.KillAll(); }
+  void VisitMemoryExchangeInst(MemoryExchangeInst &i) { kg_.KillAll(); }
+  void VisitCallSite(CallSite &i) { kg_.KillAll(); }
+  void VisitX86_FPUControlInst(X86_FPUControlInst &i) { kg_.KillAll(); }
 
 private:
-  /// Mapping to alter.
-  StoreMap &stores_;
+  /// Indices of the stored globals.
+  const llvm::DenseMap<Global *, unsigned> &globals_;
+  /// Sets to update.
+  DeadStoreSolverBase::KillGen &kg_;
 };
 
-
-
 // -----------------------------------------------------------------------------
-bool DeadStorePass::RemoveLocalDeadStores(Func &func)
-{
-  BlockToStores storesIn;
-  BlockToStores storesOut;
+class DeadStoreSolver final : public DeadStoreSolverBase {
+public:
+  DeadStoreSolver(Func &func, const llvm::DenseMap<Global *, unsigned> &globals)
+    : DeadStoreSolverBase(func, globals.size())
+    , globals_(globals)
+  {
+  }
 
-  std::queue<Block *> q;
-  for (Block &block : func) {
-    if (block.succ_empty()) {
-      q.push(&block);
-    }
+  /// Returns the stores which are overwritten on all paths.
+  llvm::ArrayRef<MemoryStoreInst *> GetDeadStores() const { return dead_; }
+
+private:
+  void Build(Inst &inst, KillGen &kg) override
+  {
+    DeadStoreVisitor(globals_, kg).Dispatch(inst);
   }
 
-  while (!q.empty()) {
-    Block &block = *q.front();
-    q.pop();
-
-    bool changed = false;
-    StoreMap blockStoresIn;
-    if (!block.succ_empty()) {
-      auto begin = block.succ_begin();
-      blockStoresIn = storesOut[*begin];
-      for (auto it = std::next(begin); it != block.succ_end(); ++it) {
-        auto &outs = storesOut[*it];
-        for (auto bt = blockStoresIn.begin(); bt != blockStoresIn.end(); ) {
-          auto et = outs.find(bt->first);
-          if (et == outs.end() || et->second != bt->second) {
-            blockStoresIn.erase(bt++);
-            continue;
-          } else {
-            ++bt;
-          }
+  void Traverse(Inst &inst, const llvm::BitVector &flow) override
+  {
+    if (auto *store = ::cast_or_null<MemoryStoreInst>(&inst)) {
+      if (auto *g = ToGlobal(store->GetAddr())) {
+        if (flow.test(globals_.find(g)->second)) {
+          dead_.push_back(store);
         }
       }
     }
+  }
 
-    {
-      auto it = storesIn.emplace(&block, blockStoresIn);
-      if (it.second) {
-        changed = true;
-      } else if (it.first->second != blockStoresIn) {
-        it.first->second = blockStoresIn;
-        changed = true;
-      }
-    }
-
-    StoreMap blockStoresOut(blockStoresIn);
-    for (auto it = block.rbegin(); it != block.rend(); ++it) {
-      DeadStoreVisitor(blockStoresOut).Dispatch(*it);
-    }
+private:
+  /// Indices of the stored globals.
+  const llvm::DenseMap<Global *, unsigned> &globals_;
+  /// Stores found to be dead.
+  std::vector<MemoryStoreInst *> dead_;
+};
 
-    {
-      auto it = storesOut.emplace(&block, blockStoresOut);
-      if (it.second) {
-        changed = true;
-      } else if (it.first->second != blockStoresOut) {
-        it.first->second = blockStoresOut;
-        changed = true;
-      }
-    }
 
-    if (changed) {
-      for (auto *succ : block.predecessors()) {
-        q.push(succ);
-      }
-    }
-  }
 
-  for (auto &block : func) {
-    auto stores = storesIn[&block];
-    for (auto it = block.rbegin(); it != block.rend(); ) {
-      Inst &inst = *it++;
+// -----------------------------------------------------------------------------
+bool DeadStorePass::RemoveLocalDeadStores(Func &func)
+{
+  // Number the globals which are stored to.
+  llvm::DenseMap<Global *, unsigned> globals;
+  for (Block &block : func) {
+    for (Inst &inst : block) {
       if (auto *store = ::cast_or_null<MemoryStoreInst>(&inst)) {
         if (auto *g = ToGlobal(store->GetAddr())) {
-          if (auto it = stores.find(g); it != stores.end()) {
-            NumStoresErased++;
-            store->eraseFromParent();
-            continue;
-          }
+          globals.try_emplace(g, globals.size());
         }
       }
-      DeadStoreVisitor(stores).Dispatch(inst);
     }
   }
+  if (globals.empty()) {
+    return false;
+  }
 
-  return false;
+  // A store is dead if the global is overwritten on all paths before
+  // any instruction which might read it.
+  DeadStoreSolver solver(func, globals);
+  solver.Solve();
+  for (MemoryStoreInst *store : solver.GetDeadStores()) {
+    NumStoresErased++;
+    store->eraseFromParent();
+  }
+  return !solver.GetDeadStores().empty();
 }
 
 // -----------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 #include "core/prog.h"
 #include "core/insts.h"
 #include "core/analysis/dominator.h"
+#include "core/pass_manager.h"
 #include "passes/dedup_const.h"
 
 
@@ -35,7 +36,7 @@ static std::optional<int64_t> GetConstant(Inst &inst)
 namespace {
 class DedupConst {
 public:
-  DedupConst(Func &func) : doms_(func) {}
+  DedupConst(DominatorTree &doms) : doms_(doms) {}
 
   unsigned Visit(Block &block)
   {
@@ -70,7 +71,7 @@ public:
 
 private:
   /// Dominator tree.
-  DominatorTree doms_;
+  DominatorTree &doms_;
   /// Constants available for simplification.
   std::unordered_map<std::pair<Type, int64_t>, Ref<Inst>> movs_;
 };
@@ -81,7 +82,8 @@ bool DedupConstPass::Run(Prog &prog)
 {
   bool changed = false;
   for (auto &func : prog) {
-    changed = DedupConst(func).Visit(func.getEntryBlock()) || changed;
+    auto &doms = getAnalysis<DominatorAnalysis>(func).GetDominatorTree();
+    changed = DedupConst(doms).Visit(func.getEntryBlock()) || changed;
   }
   return changed;
 }
@@ -91,3 +93,9 @@ const char *DedupConstPass::GetPassName() const
 {
   return "Constant Deduplication";
 }
+
+// -----------------------------------------------------------------------------
+PreservedAnalyses DedupConstPass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<DominatorAnalysis>();
+}
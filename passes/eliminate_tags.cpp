@@ -65,9 +65,9 @@ private:
 // -----------------------------------------------------------------------------
 class EliminateTags final {
 public:
-  EliminateTags(Prog &prog, const Target *target)
+  EliminateTags(Prog &prog, Pass *pass, const Target *target)
     : prog_(prog)
-    , types_(prog, target, optBanPolymorphism)
+    , types_(prog, pass, target, optBanPolymorphism)
   {
     LLVM_DEBUG(types_.dump(llvm::dbgs()));
   }
@@ -181,12 +181,12 @@ bool EliminateTags::NarrowTypes()
             mov->eraseFromParent();
           } else if (rewrite) {
             auto *newInst = new MovInst(Type::I64, ref, mov->GetAnnots());
+            block->AddInst(newInst, inst);
             types_.Replace(
                 inst->GetSubValue(0),
                 newInst->GetSubValue(0),
                 types[0]
             );
-            block->AddInst(newInst, inst);
             inst->replaceAllUsesWith(newInst);
             inst->eraseFromParent();
           }
@@ -194,17 +194,18 @@ bool EliminateTags::NarrowTypes()
           Type ty = newTypes[arg->GetIndex()].GetType();
           if (rewrite && ty != arg->GetType()) {
             auto *newInst = new ArgInst(ty, arg->GetIndex(), arg->GetAnnots());
+            block->AddInst(newInst, arg);
             types_.Replace(
                 arg->GetSubValue(0),
                 newInst->GetSubValue(0),
                 types[0]
             );
-            block->AddInst(newInst, arg);
             arg->replaceAllUsesWith(newInst);
             arg->eraseFromParent();
           }
         } else if (rewrite) {
           auto newInst = TypeRewriter(types).Clone(inst);
+          block->AddInst(newInst, inst);
           for (unsigned i = 0, n = types.size(); i < n; ++i) {
             types_.Replace(
                 inst->GetSubValue(i),
@@ -212,7 +213,6 @@ bool EliminateTags::NarrowTypes()
                 types[i]
             );
           }
-          block->AddInst(newInst, inst);
           inst->replaceAllUsesWith(newInst);
           inst->eraseFromParent();
         }
@@ -414,8 +414,8 @@ Inst *EliminateTags::PeepholeAddCmp(Inst &inst)
       cmp->GetCC(),
       cmp->GetAnnots()
   );
-  types_.Replace(cmp, newCmp);
   block->AddInst(newCmp, &inst);
+  types_.Replace(cmp, newCmp);
   cmp->replaceAllUsesWith(newCmp);
   cmp->eraseFromParent();
   ++NumAddCmp;
@@ -425,7 +425,7 @@ Inst *EliminateTags::PeepholeAddCmp(Inst &inst)
 // -----------------------------------------------------------------------------
 bool EliminateTagsPass::Run(Prog &prog)
 {
-  EliminateTags pass(prog, GetTarget());
+  EliminateTags pass(prog, this, GetTarget());
   bool changed = false;
   changed = pass.NarrowTypes() || changed;
   changed = pass.RewriteConst() || changed;
@@ -9,6 +9,7 @@
 #include "core/func.h"
 #include "core/pass_manager.h"
 #include "core/prog.h"
+#include "core/analysis/call_graph.h"
 #include "passes/global_forward.h"
 #include "passes/global_forward/nodes.h"
 #include "passes/global_forward/forwarder.h"
@@ -36,7 +37,8 @@ bool GlobalForwardPass::Run(Prog &prog)
     return false;
   }
 
-  GlobalForwarder forwarder(prog, *entry);
+  auto &cg = getAnalysis<CallGraphAnalysis>(prog);
+  GlobalForwarder forwarder(prog, *entry, cg, GetThreadPool());
 
   bool changed = false;
   changed = forwarder.Forward() || changed;
@@ -38,23 +38,22 @@ static bool IsSingleUse(const Func &func)
 }
 
 // -----------------------------------------------------------------------------
-GlobalForwarder::GlobalForwarder(Prog &prog, Func &entry)
+GlobalForwarder::GlobalForwarder(
+    Prog &prog,
+    Func &entry,
+    CallGraphAnalysis &cg,
+    ThreadPool *pool)
   : prog_(prog)
   , entry_(entry)
 {
   ObjectGraph og(prog);
-  CallGraph cg(prog);
-  ReferenceGraph rg(prog, cg);
+  ReferenceGraph rg(prog, cg, pool);
 
-  for (auto it = llvm::scc_begin(&cg); !it.isAtEnd(); ++it) {
+  for (const auto &scc : cg.GetSCCs()) {
     // Create a node for the entire SCC.
     ID<Func> id = funcs_.size();
     funcs_.emplace_back(std::make_unique<FuncClosure>());
-    for (auto *funcNode : *it) {
-      auto *func = funcNode->GetCaller();
-      if (!func) {
-        continue;
-      }
+    for (Func *func : scc) {
       funcToID_.emplace(func, id);
     }
   }
@@ -108,70 +107,51 @@ GlobalForwarder::GlobalForwarder(Prog &prog, Func &entry)
     }
   }
 
-  for (auto it = llvm::scc_begin(&cg); !it.isAtEnd(); ++it) {
-    for (auto *funcNode : *it) {
-      auto *func = funcNode->GetCaller();
-      if (!func) {
-        continue;
-      }
+  for (const auto &scc : cg.GetSCCs()) {
+    for (Func *func : scc) {
       auto &node = *funcs_[GetFuncID(*func)];
       auto &rgNode = rg[*func];
       node.Raises = rgNode.HasRaise;
       node.Indirect = rgNode.HasIndirectCalls;
 
-      for (auto *read : rgNode.ReadRanges) {
+      auto load = [&, this] (ID<Object> id) {
         // Entire transitive closure is loaded, only pointees escape.
-        auto objectID = GetObjectID(read);
+        auto objectID = GetObjectID(&rg.Map(id));
         auto &obj = *objects_[objectID];
         node.Funcs.Union(obj.Funcs);
         node.Escaped.Union(obj.Objects);
         node.Loaded.Insert(objectID);
+      };
+      for (auto id : rgNode.ReadRanges) {
+        load(id);
       }
-      for (auto &[read, offsets] : rgNode.ReadOffsets) {
-        // Entire transitive closure is loaded, only pointees escape.
-        auto objectID = GetObjectID(read);
-        auto &obj = *objects_[objectID];
-        node.Funcs.Union(obj.Funcs);
-        node.Escaped.Union(obj.Objects);
-        node.Loaded.Insert(objectID);
+      for (auto &[id, offsets] : rgNode.ReadOffsets) {
+        load(id);
       }
-      for (auto *written : rgNode.WrittenRanges) {
+      for (auto id : rgNode.WrittenRanges) {
         // The specific item is changed.
-        node.Stored.Insert(GetObjectID(written));
+        node.Stored.Insert(GetObjectID(&rg.Map(id)));
       }
-      for (auto &[written, offsets] : rgNode.WrittenOffsets) {
+      for (auto &[id, offsets] : rgNode.WrittenOffsets) {
         // The specific item is changed.
-        node.Stored.Insert(GetObjectID(written));
+        node.Stored.Insert(GetObjectID(&rg.Map(id)));
       }
-      for (auto *g : rgNode.Escapes) {
-        switch (g->GetKind()) {
-          case Global::Kind::FUNC: {
-            auto &func = static_cast<Func &>(*g);
-            node.Funcs.Insert(GetFuncID(func));
-            continue;
-          }
-          case Global::Kind::ATOM: {
-            auto *object = static_cast<Atom &>(*g).getParent();
-            auto objectID = GetObjectID(object);
-            auto &obj = *objects_[objectID];
-            // Transitive closure is fully tainted.
-            node.Funcs.Union(obj.Funcs);
-            node.Escaped.Union(obj.Objects);
-            node.Escaped.Insert(objectID);
-            node.Loaded.Union(obj.Objects);
-            node.Loaded.Insert(objectID);
-            node.Stored.Union(obj.Objects);
-            node.Stored.Insert(objectID);
-            continue;
-          }
-          case Global::Kind::BLOCK:
-          case Global::Kind::EXTERN: {
-            // Blocks and externs are not recorded.
-            continue;
-          }
-        }
-        llvm_unreachable("invalid global kind");
+      for (auto id : rgNode.EscapedFuncs) {
+        node.Funcs.Insert(GetFuncID(rg.Map(id)));
+      }
+      for (auto id : rgNode.EscapedObjects) {
+        auto objectID = GetObjectID(&rg.Map(id));
+        auto &obj = *objects_[objectID];
+        // Transitive closure is fully tainted.
+        node.Funcs.Union(obj.Funcs);
+        node.Escaped.Union(obj.Objects);
+        node.Escaped.Insert(objectID);
+        node.Loaded.Union(obj.Objects);
+        node.Loaded.Insert(objectID);
+        node.Stored.Union(obj.Objects);
+        node.Stored.Insert(objectID);
       }
+      // Blocks and externs are not recorded.
     }
   }
 }
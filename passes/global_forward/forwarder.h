@@ -12,6 +12,8 @@
 #include "passes/global_forward/nodes.h"
 
 class MovInst;
+class CallGraphAnalysis;
+class ThreadPool;
 
 
 
@@ -21,7 +23,12 @@ class MovInst;
 class GlobalForwarder final {
 public:
   /// Initialise the analysis.
-  GlobalForwarder(Prog &prog, Func &entry);
+  GlobalForwarder(
+      Prog &prog,
+      Func &entry,
+      CallGraphAnalysis &cg,
+      ThreadPool *pool
+  );
 
   /// Simplify loads and build the graph for the reverse transformations.
   bool Forward();
@@ -18,9 +18,6 @@ class MemoryStoreInst;
 
 
 
-/// Map of offsets into an object.
-using ObjectOffsetMap = std::unordered_map<ID<Object>, OffsetSet>;
-
 /// Transitive closure of an object.
 struct ObjectClosure {
   /// Set of referenced functions.
@@ -8,8 +8,8 @@
 
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/SmallPtrSet.h>
-#include <llvm/ADT/SCCIterator.h>
 
+#include "core/adt/slab.h"
 #include "core/block.h"
 #include "core/cast.h"
 #include "core/cfg.h"
@@ -194,37 +194,25 @@ bool InlinerPass::Run(Prog &prog)
   counts_.clear();
 
   // Run the necessary analyses.
-  CallGraph cg(prog);
+  auto &cg = getAnalysis<CallGraphAnalysis>(prog);
   TrampolineGraph tg(&prog);
 
-  // Since the functions cannot be changed while the call graph is
-  // built, identify SCCs and save the topological ordering first.
+  // Since the SCCs are updated as functions change, identify
+  // recursive functions and save the topological ordering first.
   std::set<const Func *> inSCC;
   std::vector<Func *> inlineOrder;
-  for (auto it = llvm::scc_begin(&cg); !it.isAtEnd(); ++it) {
+  for (const auto &scc : cg.GetSCCs()) {
     // Record nodes in the SCC.
-    const std::vector<const CallGraph::Node *> &scc = *it;
-    if (scc.size() == 1 && scc[0]->IsRecursive()) {
-      if (auto *f = scc[0]->GetCaller()) {
-        inSCC.insert(f);
-      }
+    if (scc.size() == 1 && cg.IsRecursive(*scc[0])) {
+      inSCC.insert(scc[0]);
     } else if (scc.size() > 1) {
-      std::set<Func *> funcs;
-      for (auto *node : scc) {
-        if (auto *f = node->GetCaller()) {
-          funcs.insert(f);
-        }
-      }
+      std::set<Func *> funcs(scc.begin(), scc.end());
       const auto &points = FindArticulationPoints(funcs);
       for (auto *node : points.empty() ? funcs : points) {
         inSCC.insert(node);
       }
     }
-    for (auto *node : scc) {
-      if (auto *f = node->GetCaller()) {
-        inlineOrder.push_back(f);
-      }
-    }
+    inlineOrder.insert(inlineOrder.end(), scc.begin(), scc.end());
   }
 
   // Inline around the initialisation path.
@@ -267,7 +255,10 @@ bool InlinerPass::Run(Prog &prog)
           ++it;
           continue;
         }
-        InlineHelper(call, callee, tg).Inline();
+        {
+          SlabArena::Scope scope(caller->GetArena());
+          InlineHelper(call, callee, tg).Inline();
+        }
         inlined = true;
 
         if (mov->use_empty()) {
@@ -276,6 +267,7 @@ bool InlinerPass::Run(Prog &prog)
       }
       if (inlined) {
         caller->RemoveUnreachable();
+        cg.Update(*caller);
         changed = true;
       }
     }
@@ -291,6 +283,7 @@ bool InlinerPass::Run(Prog &prog)
 
     // Do not inline if the caller has no uses.
     if (caller->use_empty() && !caller->IsEntry()) {
+      cg.Remove(*caller);
       caller->eraseFromParent();
       deleted.insert(caller);
       continue;
@@ -321,8 +314,11 @@ bool InlinerPass::Run(Prog &prog)
         continue;
       }
 
-      // Perform the inlining.
-      InlineHelper(call, callee, tg).Inline();
+      // Perform the inlining, placing the copies in the caller's arena.
+      {
+        SlabArena::Scope scope(caller->GetArena());
+        InlineHelper(call, callee, tg).Inline();
+      }
       inlined = true;
 
       // If callee is dead, delete it.
@@ -330,6 +326,7 @@ bool InlinerPass::Run(Prog &prog)
         mov->eraseFromParent();
       }
       if (callee->use_empty() && !callee->IsEntry()) {
+        cg.Remove(*callee);
         callee->eraseFromParent();
         deleted.insert(callee);
       } else {
@@ -344,6 +341,7 @@ bool InlinerPass::Run(Prog &prog)
     }
     if (inlined) {
       caller->RemoveUnreachable();
+      cg.Update(*caller);
       changed = true;
     }
   }
@@ -351,6 +349,12 @@ bool InlinerPass::Run(Prog &prog)
   return changed;
 }
 
+// -----------------------------------------------------------------------------
+PreservedAnalyses InlinerPass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<CallGraphAnalysis>();
+}
+
 // -----------------------------------------------------------------------------
 const char *InlinerPass::GetPassName() const
 {
@@ -28,6 +28,9 @@ public:
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
   /// Count the number of uses of a function.
   std::pair<unsigned, unsigned> CountUses(const Func &func);
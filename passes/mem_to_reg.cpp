@@ -14,8 +14,10 @@
 #include "core/func.h"
 #include "core/prog.h"
 #include "core/insts.h"
+#include "core/pass_manager.h"
 #include "core/analysis/dominator.h"
 #include "passes/mem_to_reg.h"
+#include "passes/pta.h"
 
 
 
@@ -133,27 +135,37 @@ std::optional<PtrUses> FindUses(
 }
 
 // -----------------------------------------------------------------------------
-bool MemoryToRegisterPass::Run(Prog &prog)
+void MemoryToRegisterPass::Prepare(Prog &prog)
 {
-  bool changed = false;
+  // The use lists of functions cannot be walked while other functions are
+  // transformed concurrently, thus escaping functions are identified here.
+  addressTaken_.clear();
   for (Func &func : prog) {
-    if (!func.HasAddressTaken()) {
-      changed = Run(func) || changed;
+    if (func.HasAddressTaken()) {
+      addressTaken_.insert(&func);
     }
   }
-  return changed;
+}
+
+// -----------------------------------------------------------------------------
+bool MemoryToRegisterPass::Run(Func &func)
+{
+  if (addressTaken_.count(&func)) {
+    return false;
+  }
+  return Promote(func);
 }
 
 // -----------------------------------------------------------------------------
 static void ReplaceObject(
     Func &func,
+    DominatorAnalysis &doms,
     const PtrUses &uses,
     const llvm::DenseMap<int64_t, Type> &offsets)
 {
-  // Build the dominator tree for the function.
-  DominatorTree DT(func);
-  DominanceFrontier DF;
-  DF.analyze(DT);
+  // Promotion does not alter the CFG: the cached dominators remain valid.
+  auto &DT = doms.GetDominatorTree();
+  auto &DF = doms.GetDominanceFrontier();
 
   // Find the stores and place PHIs at their frontiers.
   for (auto [off, ty] : offsets) {
@@ -263,7 +275,7 @@ static void ReplaceObject(
 }
 
 // -----------------------------------------------------------------------------
-bool MemoryToRegisterPass::Run(Func &func)
+bool MemoryToRegisterPass::Promote(Func &func)
 {
   if (func.getName() != "dlopen") return false;
 
@@ -323,7 +335,7 @@ bool MemoryToRegisterPass::Run(Func &func)
       continue;
     }
     // If there is no overlap, structure can be broken down.
-    ReplaceObject(func, allUses, offsets);
+    ReplaceObject(func, getAnalysis<DominatorAnalysis>(func), allUses, offsets);
     changed = true;
   }
   return changed;
@@ -334,3 +346,11 @@ const char *MemoryToRegisterPass::GetPassName() const
 {
   return "Structure to Register";
 }
+
+// -----------------------------------------------------------------------------
+PreservedAnalyses MemoryToRegisterPass::GetPreserved() const
+{
+  return PreservedAnalyses()
+      .Preserve<PointsToAnalysis>()
+      .Preserve<DominatorAnalysis>();
+}
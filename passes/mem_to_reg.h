@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <unordered_set>
+
 #include "core/pass.h"
 
 class Func;
@@ -14,21 +16,30 @@ class MovInst;
 /**
  * Pass to eliminate unnecessary moves.
  */
-class MemoryToRegisterPass final : public Pass {
+class MemoryToRegisterPass final : public FuncPass {
 public:
   /// Pass identifier.
   static const char *kPassID;
 
   /// Initialises the pass.
-  MemoryToRegisterPass(PassManager *passManager) : Pass(passManager) {}
+  MemoryToRegisterPass(PassManager *passManager) : FuncPass(passManager) {}
 
-  /// Runs the pass.
-  bool Run(Prog &prog) override;
+  /// Finds the functions whose address is taken.
+  void Prepare(Prog &prog) override;
+  /// Runs the pass on a function.
+  bool Run(Func &func) override;
 
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
-  /// Runs the pass on a function.
-  bool Run(Func &func);
+  /// Promotes the stack objects of a function.
+  bool Promote(Func &func);
+
+private:
+  /// Functions whose address is taken, found before the parallel run.
+  std::unordered_set<const Func *> addressTaken_;
 };
@@ -11,7 +11,9 @@
 #include "core/func.h"
 #include "core/insts.h"
 #include "core/prog.h"
+#include "core/analysis/dominator.h"
 #include "passes/move_elim.h"
+#include "passes/pta.h"
 
 #define DEBUG_TYPE "move-elim"
 
@@ -35,24 +37,22 @@ static bool CanEliminate(Ref<MovInst> mov, Ref<Inst> arg)
 }
 
 // -----------------------------------------------------------------------------
-bool MoveElimPass::Run(Prog &prog)
+bool MoveElimPass::Run(Func &func)
 {
   bool changed = false;
-  for (auto &func : prog) {
-    for (auto *block : llvm::ReversePostOrderTraversal<Func*>(&func)) {
-      for (auto it = block->begin(); it != block->end(); ) {
-        if (auto *mov = ::cast_or_null<MovInst>(&*it++)) {
-          if (Ref<Inst> arg = ::cast_or_null<Inst>(mov->GetArg())) {
-            if (CanEliminate(mov, arg)) {
-              // Since in this form we have PHIs, moves which rename
-              // virtual registers are not required and can be replaced
-              // with the virtual register they copy from.
-              mov->replaceAllUsesWith(arg);
-              mov->eraseFromParent();
-              changed = true;
-              ++NumMovsForwarded;
-              continue;
-            }
+  for (auto *block : llvm::ReversePostOrderTraversal<Func*>(&func)) {
+    for (auto it = block->begin(); it != block->end(); ) {
+      if (auto *mov = ::cast_or_null<MovInst>(&*it++)) {
+        if (Ref<Inst> arg = ::cast_or_null<Inst>(mov->GetArg())) {
+          if (CanEliminate(mov, arg)) {
+            // Since in this form we have PHIs, moves which rename
+            // virtual registers are not required and can be replaced
+            // with the virtual register they copy from.
+            mov->replaceAllUsesWith(arg);
+            mov->eraseFromParent();
+            changed = true;
+            ++NumMovsForwarded;
+            continue;
           }
         }
       }
@@ -66,3 +66,11 @@ const char *MoveElimPass::GetPassName() const
 {
   return "Move Elimination";
 }
+
+// -----------------------------------------------------------------------------
+PreservedAnalyses MoveElimPass::GetPreserved() const
+{
+  return PreservedAnalyses()
+      .Preserve<PointsToAnalysis>()
+      .Preserve<DominatorAnalysis>();
+}
@@ -11,17 +11,20 @@
 /**
  * Pass to eliminate unnecessary moves.
  */
-class MoveElimPass final : public Pass {
+class MoveElimPass final : public FuncPass {
 public:
   /// Pass identifier.
   static const char *kPassID;
 
   /// Initialises the pass.
-  MoveElimPass(PassManager *passManager) : Pass(passManager) {}
+  MoveElimPass(PassManager *passManager) : FuncPass(passManager) {}
 
-  /// Runs the pass.
-  bool Run(Prog &prog) override;
+  /// Runs the pass on a function.
+  bool Run(Func &func) override;
 
   /// Returns the name of the pass.
   const char *GetPassName() const override;
+
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
 };
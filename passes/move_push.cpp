@@ -12,6 +12,7 @@
 #include "core/clone.h"
 #include "core/func.h"
 #include "core/insts.h"
+#include "core/pass_manager.h"
 #include "core/prog.h"
 #include "passes/move_push.h"
 
@@ -52,7 +53,7 @@ bool MovePushPass::Run(Prog &prog)
 {
   bool changed = false;
   for (auto &func : prog) {
-    std::unique_ptr<PostDominatorTree> pdt = nullptr;
+    PostDominatorTree *pdt = nullptr;
     for (auto *block : llvm::ReversePostOrderTraversal<Func*>(&func)) {
       for (auto it = block->begin(); it != block->end(); ) {
         auto *mov = ::cast_or_null<MovInst>(&*it++);
@@ -64,7 +65,7 @@ bool MovePushPass::Run(Prog &prog)
           continue;
         }
         if (!pdt) {
-          pdt.reset(new PostDominatorTree(func));
+          pdt = &getAnalysis<DominatorAnalysis>(func).GetPostDominatorTree();
         }
         if (!pdt->dominates(block, arg->getParent())) {
           continue;
@@ -88,3 +89,9 @@ const char *MovePushPass::GetPassName() const
 {
   return "Move Type Rewriting";
 }
+
+// -----------------------------------------------------------------------------
+PreservedAnalyses MovePushPass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<DominatorAnalysis>();
+}
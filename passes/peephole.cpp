@@ -13,6 +13,7 @@
 #include "core/prog.h"
 #include "core/insts.h"
 #include "passes/peephole.h"
+#include "passes/pta.h"
 
 #define DEBUG_TYPE "peephole"
 
@@ -33,14 +34,18 @@ const char *PeepholePass::GetPassName() const
 }
 
 // -----------------------------------------------------------------------------
-bool PeepholePass::Run(Prog &prog)
+PreservedAnalyses PeepholePass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<PointsToAnalysis>();
+}
+
+// -----------------------------------------------------------------------------
+bool PeepholePass::Run(Func &func)
 {
   bool changed = false;
-  for (auto &func : prog) {
-    for (auto &block : func) {
-      for (auto it = block.begin(); it != block.end(); ) {
-        changed = Dispatch(*it++) || changed;
-      }
+  for (auto &block : func) {
+    for (auto it = block.begin(); it != block.end(); ) {
+      changed = Dispatch(*it++) || changed;
     }
   }
   return changed;
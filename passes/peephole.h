@@ -15,20 +15,23 @@ class MovInst;
 /**
  * Pass to eliminate unnecessary moves.
  */
-class PeepholePass final : public Pass, InstVisitor<bool> {
+class PeepholePass final : public FuncPass, InstVisitor<bool> {
 public:
   /// Pass identifier.
   static const char *kPassID;
 
   /// Initialises the pass.
-  PeepholePass(PassManager *passManager) : Pass(passManager) {}
+  PeepholePass(PassManager *passManager) : FuncPass(passManager) {}
 
-  /// Runs the pass.
-  bool Run(Prog &prog) override;
+  /// Runs the pass on a function.
+  bool Run(Func &func) override;
 
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
   bool VisitInst(Inst &inst) override { return false; }
   bool VisitAddInst(AddInst &inst) override;
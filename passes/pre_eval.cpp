@@ -5,6 +5,7 @@
 #include <queue>
 
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include "core/block.h"
 #include "core/cast.h"
@@ -34,7 +35,10 @@ const char *PreEvalPass::kPassID = "pre-eval";
 namespace {
 class ReferenceGraphImpl final : public ReferenceGraph {
 public:
-  ReferenceGraphImpl(Prog &prog, CallGraph &cg) : ReferenceGraph(prog, cg) { }
+  ReferenceGraphImpl(Prog &prog, CallGraphAnalysis &cg, ThreadPool *pool)
+    : ReferenceGraph(prog, cg, pool)
+  {
+  }
 
   bool Skip(Func &func) override { return false; } //return IsAllocation(func); }
 };
@@ -43,9 +47,9 @@ public:
 // -----------------------------------------------------------------------------
 class PreEvaluator final {
 public:
-  PreEvaluator(Prog &prog)
-    : cg_(prog)
-    , refs_(prog, cg_)
+  PreEvaluator(Prog &prog, CallGraphAnalysis &cg, ThreadPool *pool)
+    : cg_(cg)
+    , refs_(prog, cg, pool)
     , ctx_(heap_, state_)
   {
   }
@@ -97,7 +101,7 @@ private:
 
 private:
   /// Call graph of the program.
-  CallGraph cg_;
+  CallGraphAnalysis &cg_;
   /// Set of symbols referenced by each function.
   ReferenceGraphImpl refs_;
   /// Mapping from various objects to object IDs.
@@ -149,9 +153,13 @@ bool PreEvaluator::Evaluate(Func &start)
   }
 
   // Loop until main path is exhausted.
-  Run();
+  {
+    llvm::TimeTraceScope scope("PreEvaluate", start.getName());
+    Run();
+  }
 
   // Optimise the startup path based on information gathered by the analysis.
+  llvm::TimeTraceScope scope("PreEvalSimplify", start.getName());
   return Simplify(start);
 }
 
@@ -724,7 +732,7 @@ bool PreEvaluator::ShouldApproximate(Func &callee)
   if (IsAllocation(callee)) {
     return true;
   }
-  const CallGraph::Node *node = cg_[&callee];
+  const CallGraph::Node *node = cg_.GetCallGraph()[&callee];
   assert(node && "missing call graph node");
   if (node->IsRecursive()) {
     // Do not enter self-recursive functions.
@@ -1168,7 +1176,8 @@ bool PreEvalPass::Run(Prog &prog)
   if (!entry) {
     return false;
   }
-  return PreEvaluator(prog).Evaluate(*entry);
+  auto &cg = getAnalysis<CallGraphAnalysis>(prog);
+  return PreEvaluator(prog, cg, GetThreadPool()).Evaluate(*entry);
 }
 
 // -----------------------------------------------------------------------------
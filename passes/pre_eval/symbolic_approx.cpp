@@ -8,6 +8,7 @@
 #include "core/atom.h"
 
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/TimeProfiler.h>
 
 #include "core/analysis/reference_graph.h"
 #include "passes/pre_eval/pointer_closure.h"
@@ -42,6 +43,11 @@ bool IsAllocation(Func &func)
 // -----------------------------------------------------------------------------
 bool SymbolicApprox::Approximate(CallSite &call)
 {
+  llvm::TimeTraceScope scope("ApproximateCall", [&] {
+    auto *callee = call.GetDirectCallee();
+    return callee ? std::string(callee->getName()) : "<indirect>";
+  });
+
   auto &frame = *ctx_.GetActiveFrame();
   auto index = frame.GetIndex();
   if (auto *func = call.GetDirectCallee()) {
@@ -171,6 +177,11 @@ void SymbolicApprox::Approximate(
     const std::set<DAGBlock *> &bypassed,
     const std::set<SymbolicContext *> &contexts)
 {
+  llvm::TimeTraceScope scope("ApproximateBranches", [&] {
+    auto *func = frame.GetFunc();
+    return func ? std::string(func->getName()) : "";
+  });
+
   // Compute the union of all contexts.
   LLVM_DEBUG(llvm::dbgs() << "Merging " << contexts.size() << " contexts\n");
   LLVM_DEBUG(llvm::dbgs() << "\tFrame: " << &frame << "\n");
@@ -322,40 +333,26 @@ SymbolicApprox::Approximation SymbolicApprox::ApproximateNodes(
       auto &node = refs_[*f];
       indirect = indirect || node.HasIndirectCalls;
       raises = raises || node.HasRaise;
-      for (auto *g : node.Escapes) {
-        LLVM_DEBUG(llvm::dbgs() << "\t" << g->getName() << "\n");
-        switch (g->GetKind()) {
-          case Global::Kind::FUNC: {
-            closure.Add(static_cast<Func *>(g));
-            continue;
-          }
-          case Global::Kind::ATOM: {
-            auto *obj = static_cast<Atom *>(g)->getParent();
-            closure.AddEscaped(obj);
-            continue;
-          }
-          case Global::Kind::EXTERN: {
-            // TODO: follow externs.
-            continue;
-          }
-          case Global::Kind::BLOCK: {
-            // TODO: add blocks.
-            continue;
-          }
-        }
-        llvm_unreachable("invalid global kind");
+      for (auto id : node.EscapedFuncs) {
+        auto &g = refs_.Map(id);
+        LLVM_DEBUG(llvm::dbgs() << "\t" << g.getName() << "\n");
+        closure.Add(&g);
       }
-      for (auto *o : node.ReadRanges) {
-        closure.AddRead(o);
+      for (auto id : node.EscapedObjects) {
+        closure.AddEscaped(&refs_.Map(id));
       }
-      for (auto [o, offsets] : node.ReadOffsets) {
-        closure.AddRead(o);
+      // TODO: follow externs and add blocks.
+      for (auto id : node.ReadRanges) {
+        closure.AddRead(&refs_.Map(id));
       }
-      for (auto *o : node.WrittenRanges) {
-        closure.AddWritten(o);
+      for (auto &[id, offsets] : node.ReadOffsets) {
+        closure.AddRead(&refs_.Map(id));
       }
-      for (auto [o, offsets] : node.WrittenOffsets) {
-        closure.AddWritten(o);
+      for (auto id : node.WrittenRanges) {
+        closure.AddWritten(&refs_.Map(id));
+      }
+      for (auto &[id, offsets] : node.WrittenOffsets) {
+        closure.AddWritten(&refs_.Map(id));
       }
     } else {
       indirect = true;
@@ -378,39 +375,24 @@ SymbolicApprox::Approximation SymbolicApprox::ApproximateNodes(
 
       auto &node = refs_[heap_.Map(id)];
       raises = raises || node.HasRaise;
-      for (auto *g : node.Escapes) {
-        switch (g->GetKind()) {
-          case Global::Kind::FUNC: {
-            qf.push(heap_.Function(static_cast<Func *>(g)));
-            continue;
-          }
-          case Global::Kind::ATOM: {
-            auto *obj = static_cast<Atom *>(g)->getParent();
-            closure.AddEscaped(obj);
-            continue;
-          }
-          case Global::Kind::EXTERN: {
-            // TODO: follow externs.
-            continue;
-          }
-          case Global::Kind::BLOCK: {
-            // TODO: add blocks.
-            continue;
-          }
-        }
-        llvm_unreachable("invalid global kind");
+      for (auto id : node.EscapedFuncs) {
+        qf.push(heap_.Function(&refs_.Map(id)));
+      }
+      for (auto id : node.EscapedObjects) {
+        closure.AddEscaped(&refs_.Map(id));
       }
-      for (auto *o : node.ReadRanges) {
-        closure.AddRead(o);
+      // TODO: follow externs and add blocks.
+      for (auto id : node.ReadRanges) {
+        closure.AddRead(&refs_.Map(id));
       }
-      for (auto &[o, offsets] : node.ReadOffsets) {
-        closure.AddRead(o);
+      for (auto &[id, offsets] : node.ReadOffsets) {
+        closure.AddRead(&refs_.Map(id));
       }
-      for (auto *o : node.WrittenRanges) {
-        closure.AddWritten(o);
+      for (auto id : node.WrittenRanges) {
+        closure.AddWritten(&refs_.Map(id));
       }
-      for (auto &[o, offsets] : node.WrittenOffsets) {
-        closure.AddWritten(o);
+      for (auto &[id, offsets] : node.WrittenOffsets) {
+        closure.AddWritten(&refs_.Map(id));
       }
       for (auto id : closure.funcs()) {
         if (!visited.Contains(id)) {
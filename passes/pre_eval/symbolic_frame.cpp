@@ -59,7 +59,7 @@ void SymbolicFrame::Leave()
 {
   valid_ = false;
   current_ = nullptr;
-  values_.clear();
+  values_.Clear();
   bypass_.clear();
   counts_.clear();
 }
@@ -70,11 +70,11 @@ bool SymbolicFrame::Set(Ref<Inst> inst, const SymbolicValue &value)
   assert(inst->getParent()->getParent() == GetFunc() && "invalid set");
 
   state_.Map(inst, value);
-  auto it = values_.emplace(inst, value);
+  auto it = values_.Emplace(inst, value);
   if (it.second) {
     return true;
   }
-  auto &oldValue = it.first->second;
+  auto &oldValue = *it.first;
   if (oldValue == value) {
     return false;
   }
@@ -85,20 +85,15 @@ bool SymbolicFrame::Set(Ref<Inst> inst, const SymbolicValue &value)
 // -----------------------------------------------------------------------------
 const SymbolicValue &SymbolicFrame::Find(ConstRef<Inst> inst)
 {
-  auto it = values_.find(inst);
-  assert(it != values_.end() && "value not computed");
-  return it->second;
+  auto *value = values_.Find(inst);
+  assert(value && "value not computed");
+  return *value;
 }
 
 // -----------------------------------------------------------------------------
 const SymbolicValue *SymbolicFrame::FindOpt(ConstRef<Inst> inst)
 {
-  auto it = values_.find(inst);
-  if (it == values_.end()) {
-    return nullptr;
-  } else {
-    return &it->second;
-  }
+  return values_.Find(inst);
 }
 
 // -----------------------------------------------------------------------------
@@ -116,10 +111,8 @@ void SymbolicFrame::Merge(const SymbolicFrame &that)
   assert(index_ == that.index_ && "mismatched indices");
 
   for (auto &[id, value] : that.values_) {
-    if (auto it = values_.find(id); it != values_.end()) {
-      it->second.Merge(value);
-    } else {
-      values_.emplace(id, value);
+    if (auto it = values_.Emplace(id, value); !it.second) {
+      it.first->Merge(value);
     }
   }
 }
@@ -11,6 +11,7 @@
 #include <llvm/ADT/iterator.h>
 #include <llvm/ADT/iterator_range.h>
 
+#include "core/adt/dense_inst_map.h"
 #include "core/dag.h"
 #include "core/func.h"
 #include "passes/pre_eval/symbolic_value.h"
@@ -183,7 +184,7 @@ private:
   /// Mapping from object IDs to objects.
   ObjectMap objects_;
   /// Mapping from instructions to their symbolic values.
-  std::unordered_map<ConstRef<Inst>, SymbolicValue> values_;
+  DenseInstMap<SymbolicValue> values_;
   /// Block being executed.
   Block *current_;
   /// Heap checkpoints at bypass points.
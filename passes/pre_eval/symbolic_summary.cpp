@@ -9,16 +9,16 @@
 // -----------------------------------------------------------------------------
 SymbolicValue SymbolicSummary::Lookup(ConstRef<Inst> ref)
 {
-  auto it = values_.find(ref);
-  assert(it != values_.end() && "missing value");
-  return it->second;
+  auto *value = values_.Find(ref);
+  assert(value && "missing value");
+  return *value;
 }
 
 // -----------------------------------------------------------------------------
 void SymbolicSummary::Map(ConstRef<Inst> ref, const SymbolicValue &value)
 {
-  auto it = values_.emplace(ref, value);
+  auto it = values_.Emplace(ref, value);
   if (!it.second) {
-    it.first->second.Merge(value);
+    it.first->Merge(value);
   }
 }
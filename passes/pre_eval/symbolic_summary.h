@@ -4,8 +4,7 @@
 
 #pragma once
 
-#include <unordered_map>
-
+#include "core/adt/dense_inst_map.h"
 #include "core/ref.h"
 #include "passes/pre_eval/symbolic_value.h"
 
@@ -24,5 +23,5 @@ public:
 
 private:
   /// Mapping from instructions to the LUB of all values.
-  std::unordered_map<ConstRef<Inst>, SymbolicValue> values_;
+  DenseInstMap<SymbolicValue> values_;
 };
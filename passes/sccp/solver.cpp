@@ -157,7 +157,7 @@ bool SCCPSolver::MarkBlock(Block *block)
 // -----------------------------------------------------------------------------
 Lattice &SCCPSolver::GetValue(Ref<Inst> inst)
 {
-  return values_.emplace(inst, Lattice::Unknown()).first->second;
+  return *values_.Emplace(inst, Lattice::Unknown()).first;
 }
 
 // -----------------------------------------------------------------------------
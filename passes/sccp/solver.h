@@ -5,6 +5,7 @@
 #include <set>
 #include <queue>
 
+#include "core/adt/dense_inst_map.h"
 #include "core/block.h"
 #include "core/cast.h"
 #include "core/constant.h"
@@ -106,7 +107,7 @@ private:
   std::queue<Inst *> instList_;
 
   /// Mapping from instructions to values.
-  std::unordered_map<Ref<Inst>, Lattice> values_;
+  DenseInstMap<Lattice> values_;
   /// Set of known edges.
   std::set<std::pair<Block *, Block *>> edges_;
   /// Set of executable blocks.
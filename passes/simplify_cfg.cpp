@@ -12,6 +12,7 @@
 #include "core/insts.h"
 #include "core/clone.h"
 #include "passes/simplify_cfg.h"
+#include "passes/pta.h"
 
 #define DEBUG_TYPE "simplify-cfg"
 
@@ -28,19 +29,15 @@ STATISTIC(NumBranchesFolded, "Branches folded");
 const char *SimplifyCfgPass::kPassID = "simplify-cfg";
 
 // -----------------------------------------------------------------------------
-bool SimplifyCfgPass::Run(Prog &prog)
+const char *SimplifyCfgPass::GetPassName() const
 {
-  bool changed = false;
-  for (Func &func : prog) {
-    changed = Run(func) || changed;
-  }
-  return changed;
+  return "Control Flow Simplification";
 }
 
 // -----------------------------------------------------------------------------
-const char *SimplifyCfgPass::GetPassName() const
+PreservedAnalyses SimplifyCfgPass::GetPreserved() const
 {
-  return "Control Flow Simplification";
+  return PreservedAnalyses().Preserve<PointsToAnalysis>();
 }
 
 // -----------------------------------------------------------------------------
@@ -13,20 +13,23 @@ class Func;
 /**
  * Pass to eliminate unnecessary moves.
  */
-class SimplifyCfgPass final : public Pass {
+class SimplifyCfgPass final : public FuncPass {
 public:
   /// Pass identifier.
   static const char *kPassID;
 
   /// Initialises the pass.
-  SimplifyCfgPass(PassManager *passManager) : Pass(passManager) {}
+  SimplifyCfgPass(PassManager *passManager) : FuncPass(passManager) {}
 
-  /// Runs the pass.
-  bool Run(Prog &prog) override;
+  /// Runs the pass on a function.
+  bool Run(Func &func) override;
 
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
   /// Eliminate conditional jumps with the same target.
   bool EliminateConditionalJumps(Func &func);
@@ -40,8 +43,4 @@ private:
   bool RemoveSinglePhis(Func &func);
   /// Merge basic blocks Func *funcinto predecessors if they have only one.
   bool MergeIntoPredecessor(Func &func);
-
-private:
-  /// Runs the pass on a function.
-  bool Run(Func &func);
 };
@@ -6,13 +6,18 @@
 #include <sstream>
 #include <unordered_set>
 
+#include <llvm/ADT/SetVector.h>
+
 #include "core/adt/hash.h"
+#include "core/adt/slab.h"
 #include "core/block.h"
 #include "core/cast.h"
 #include "core/clone.h"
 #include "core/func.h"
 #include "core/prog.h"
 #include "core/insts.h"
+#include "core/pass_manager.h"
+#include "core/analysis/call_graph.h"
 #include "passes/specialise.h"
 
 
@@ -26,6 +31,12 @@ const char *SpecialisePass::GetPassName() const
   return "Function Specialisation";
 }
 
+// -----------------------------------------------------------------------------
+PreservedAnalyses SpecialisePass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<CallGraphAnalysis>();
+}
+
 // -----------------------------------------------------------------------------
 static bool CanSpecialise(Func &func)
 {
@@ -355,9 +366,15 @@ void SpecialisePass::Specialise(
     const Parameters &params,
     const std::set<CallSite *> &callSites)
 {
+  auto &cg = getAnalysis<CallGraphAnalysis>(*func->getParent());
+
   Func *specialised = Specialise(func, params);
+  cg.Add(*specialised);
+
+  llvm::SetVector<Func *> callers;
   for (auto *inst : callSites) {
     Block *parent = inst->getParent();
+    callers.insert(parent->getParent());
     // Specialise the arguments, replacing some with values.
     const auto &[args, flags] = Specialise(inst, params);
 
@@ -424,6 +441,11 @@ void SpecialisePass::Specialise(
     inst->replaceAllUsesWith(newCall);
     inst->eraseFromParent();
   }
+
+  // Record the calls redirected to the specialised function.
+  for (Func *caller : callers) {
+    cg.Update(*caller);
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -483,6 +505,7 @@ Func *SpecialisePass::Specialise(Func *oldFunc, const Parameters &params)
 
   // Clone all blocks.
   {
+    SlabArena::Scope scope(newFunc->GetArena());
     SpecialiseClone clone(oldFunc, newFunc, argValues, args);
     for (auto &oldBlock : *oldFunc) {
       auto *newBlock = clone.Map(&oldBlock);
@@ -30,6 +30,9 @@ public:
   /// Returns the name of the pass.
   const char *GetPassName() const override;
 
+  /// Returns the preserved analyses.
+  PreservedAnalyses GetPreserved() const override;
+
 private:
   /// Forward declaration of the clone class.
   class SpecialiseClone;
@@ -12,6 +12,7 @@
 #include "core/insts.h"
 #include "core/inst_visitor.h"
 #include "core/inst_compare.h"
+#include "core/pass_manager.h"
 #include "core/analysis/dominator.h"
 #include "core/analysis/call_graph.h"
 #include "core/analysis/reference_graph.h"
@@ -56,9 +57,8 @@ using BlockToStores = std::map<Block *, StoreMap>;
 // -----------------------------------------------------------------------------
 class StoreToLoad final {
 public:
-  StoreToLoad(Prog &prog)
-    : cg_(prog)
-    , rg_(prog, cg_)
+  StoreToLoad(Prog &prog, CallGraphAnalysis &cg, ThreadPool *pool)
+    : rg_(prog, cg, pool)
   {
     for (Data &data : prog.data()) {
       for (Object &object : data) {
@@ -121,8 +121,6 @@ public:
   bool Escapes(Atom *atom) { return escapes_.count(atom); }
 
 private:
-  /// Call graph.
-  CallGraph cg_;
   /// Set of referenced globals for each symbol.
   ReferenceGraph rg_;
   /// Set of objects whose pointers escape.
@@ -183,15 +181,17 @@ public:
   void VisitCallSite(CallSite &call) override
   {
     if (auto *f = call.GetDirectCallee()) {
-      auto &n = stl_.GetReferenceGraph()[*f];
+      auto &rg = stl_.GetReferenceGraph();
+      auto &n = rg[*f];
       if (n.HasIndirectCalls || n.HasRaise || n.HasBarrier) {
         stores_.clear();
       } else {
         for (auto it = stores_.begin(); it != stores_.end(); ) {
           auto *g = it->first;
-          auto *o = g->getParent();
-          bool escapes = stl_.Escapes(g) || n.Escapes.count(g);
-          bool written = n.WrittenRanges.count(o) || n.WrittenOffsets.count(o);
+          auto id = rg.GetID(*g->getParent());
+          bool escapes = stl_.Escapes(g) || n.EscapedObjects.Contains(id);
+          bool written = n.WrittenRanges.Contains(id) ||
+                         n.WrittenOffsets.count(id);
           if (escapes || written) {
             stores_.erase(it++);
           } else {
@@ -307,7 +307,8 @@ bool StoreToLoad::Run(Func &func)
 // -----------------------------------------------------------------------------
 bool StoreToLoadPass::Run(Prog &prog)
 {
-  StoreToLoad stl(prog);
+  auto &cg = getAnalysis<CallGraphAnalysis>(prog);
+  StoreToLoad stl(prog, cg, GetThreadPool());
   bool changed = false;
   for (Func &func : prog) {
     changed = stl.Run(func) || changed;
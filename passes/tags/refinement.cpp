@@ -239,14 +239,16 @@ void Refinement::Refine(
   assert(analysis_.Find(ref) != nt && "no refinement");
 
   auto &doms = analysis_.GetDoms(*func);
-  if (doms.PDT.dominates(parent, ref->getParent()) || IsNonPolymorphic(ref, nt)) {
+  auto &PDT = doms.GetPostDominatorTree();
+  if (PDT.dominates(parent, ref->getParent()) || IsNonPolymorphic(ref, nt)) {
     Refine(ref, nt);
   } else {
     // Find the post-dominated nodes which are successors of the frontier.
+    auto &PDF = doms.GetPostDominanceFrontier();
     std::unordered_map<const Block *, TaggedType> splits;
-    for (auto *front : doms.PDF.calculate(doms.PDT, doms.PDT.getNode(parent))) {
+    for (auto *front : PDF.calculate(PDT, PDT.getNode(parent))) {
       for (auto *succ : front->successors()) {
-        if (doms.PDT.dominates(parent, succ)) {
+        if (PDT.dominates(parent, succ)) {
           splits.emplace(succ, nt);
         }
       }
@@ -271,14 +273,16 @@ void Refinement::Refine(
 
   // Refine the value.
   auto &doms = analysis_.GetDoms(*func);
-  if (doms.PDT.Dominates(st, en, ref->getParent()) || IsNonPolymorphic(ref, nt)) {
+  auto &PDT = doms.GetPostDominatorTree();
+  if (PDT.Dominates(st, en, ref->getParent()) || IsNonPolymorphic(ref, nt)) {
     Refine(ref, nt);
-  } else if (auto *node = doms.PDT.getNode(st)) {
+  } else if (auto *node = PDT.getNode(st)) {
     // Find the post-dominated nodes which are successors of the frontier.
+    auto &PDF = doms.GetPostDominanceFrontier();
     std::unordered_map<const Block *, TaggedType> splits;
-    for (auto *front : doms.PDF.calculate(doms.PDT, node)) {
+    for (auto *front : PDF.calculate(PDT, node)) {
       for (auto *succ : front->successors()) {
-        if (doms.PDT.Dominates(st, en, succ)) {
+        if (PDT.Dominates(st, en, succ)) {
           splits.emplace(succ, nt);
         }
       }
@@ -308,7 +312,8 @@ void Refinement::Refine(
         }
       }
       // Add a mov along this edge.
-      DefineSplits(analysis_.RebuildDoms(*func), ref, { { split, nt } });
+      doms.SplitEdge(st, split, en);
+      DefineSplits(doms, ref, { { split, nt } });
     } else {
       // Introduce the movs.
       DefineSplits(doms, ref, splits);
@@ -482,9 +487,10 @@ void Refinement::Specialise(
   assert(from->getParent() == ref->getParent()->getParent() && "invalid block");
 
   auto &doms = analysis_.GetDoms(*from->getParent());
+  auto &DT = doms.GetDominatorTree();
   std::unordered_map<const Block *, TaggedType> splits;
   for (auto &[ty, block] : branches) {
-    if (!doms.DT.Dominates(from, block, block)) {
+    if (!DT.Dominates(from, block, block)) {
       continue;
     }
     bool split = false;
@@ -576,10 +582,13 @@ Refinement::Liveness(
 
 // -----------------------------------------------------------------------------
 void Refinement::DefineSplits(
-    DominatorCache &doms,
+    DominatorAnalysis &doms,
     Ref<Inst> ref,
     const std::unordered_map<const Block *, TaggedType> &splits)
 {
+  auto &DT = doms.GetDominatorTree();
+  auto &DF = doms.GetDominanceFrontier();
+
   llvm::SmallPtrSet<const Block *, 8> blocks;
   for (auto &[block, ty] : splits) {
     blocks.insert(block);
@@ -599,8 +608,8 @@ void Refinement::DefineSplits(
     while (!q.empty()) {
       const Block *block = q.front();
       q.pop();
-      if (auto *node = doms.DT.getNode(block)) {
-        for (auto front : doms.DF.calculate(doms.DT, node)) {
+      if (auto *node = DT.getNode(block)) {
+        for (auto front : DF.calculate(DT, node)) {
           if (livePhi.count(front) && !phis.count(front)) {
             auto *phi = new PhiInst(ref.GetType(), {});
             front->AddPhi(phi);
@@ -609,7 +618,7 @@ void Refinement::DefineSplits(
               phi->Add(pred, ref);
               TaggedType predTy = TaggedType::Unknown();
               for (auto &[block, ty] : splits) {
-                if (doms.DT.dominates(block, pred)) {
+                if (DT.dominates(block, pred)) {
                   predTy |= ty;
                 }
               }
@@ -676,7 +685,7 @@ void Refinement::DefineSplits(
         }
       }
       // Rewrite dominated nodes.
-      for (auto *child : *doms.DT[block]) {
+      for (auto *child : *DT[block]) {
         rewrite(child->getBlock());
       }
       // Remove the definition.
@@ -684,7 +693,7 @@ void Refinement::DefineSplits(
         defs.pop();
       }
     };
-  rewrite(doms.DT.getRoot());
+  rewrite(DT.getRoot());
 
   // Recompute the types of the users of the refined instructions.
   for (auto &[mov, type] : newMovs) {
@@ -1001,7 +1010,7 @@ Ref<Inst> Refinement::Cast(Ref<Inst> ref, const TaggedType &ty)
       call->replaceAllUsesWith(newCall);
       call->eraseFromParent();
 
-      analysis_.RebuildDoms(*func);
+      analysis_.GetDoms(*func).SplitEdge(block, split, cont);
     }
   } else if (auto invoke = ::cast_or_null<InvokeInst>(&*ref)) {
     auto *cont = invoke->GetCont();
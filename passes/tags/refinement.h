@@ -12,12 +12,13 @@
 #include "core/target.h"
 #include "passes/tags/tagged_type.h"
 
+class DominatorAnalysis;
+
 
 
 namespace tags {
 
 class RegisterAnalysis;
-struct DominatorCache;
 
 /**
  * Helper to produce the initial types for known values.
@@ -118,7 +119,7 @@ private:
   );
   /// Define split points.
   void DefineSplits(
-      DominatorCache &doms,
+      DominatorAnalysis &doms,
       Ref<Inst> ref,
       const std::unordered_map<const Block *, TaggedType> &splits
   );
@@ -16,15 +16,6 @@ using namespace tags;
 
 
 
-// -----------------------------------------------------------------------------
-DominatorCache::DominatorCache(Func &func)
-  : DT(func)
-  , PDT(func)
-{
-  DF.analyze(DT);
-  PDF.analyze(PDT);
-}
-
 // -----------------------------------------------------------------------------
 static bool Converges(Type ty, TaggedType told, TaggedType tnew)
 {
@@ -35,9 +26,9 @@ static bool Converges(Type ty, TaggedType told, TaggedType tnew)
 void RegisterAnalysis::Erase(Ref<Inst> oldInst)
 {
 #ifdef NDEBUG
-  types_.erase(oldInst);
+  types_.Erase(oldInst);
 #else
-  assert(types_.erase(oldInst) == 1 && "value not erased");
+  assert(types_.Erase(oldInst) && "value not erased");
 #endif
 }
 
@@ -49,9 +40,9 @@ void RegisterAnalysis::Replace(
 {
   Erase(oldInst);
 #ifdef NDEBUG
-  types_[newInst] = type;
+  *types_.Emplace(newInst, type).first = type;
 #else
-  assert(types_.emplace(newInst, type).second && "value already exists");
+  assert(types_.Emplace(newInst, type).second && "value already exists");
 #endif
 }
 
@@ -72,12 +63,12 @@ void RegisterAnalysis::Replace(Inst *oldInst, Inst *newInst)
 // -----------------------------------------------------------------------------
 bool RegisterAnalysis::Mark(Ref<Inst> inst, const TaggedType &tnew)
 {
-  auto it = types_.emplace(inst, tnew);
+  auto it = types_.Emplace(inst, tnew);
   if (it.second) {
     ForwardQueue(inst);
     return true;
   } else {
-    auto told = it.first->second;
+    auto told = *it.first;
     if (told == tnew) {
       return false;
     } else {
@@ -93,7 +84,7 @@ bool RegisterAnalysis::Mark(Ref<Inst> inst, const TaggedType &tnew)
         llvm::report_fatal_error(msg.c_str());
       }
       #endif
-      it.first->second = tnew;
+      *it.first = tnew;
       ForwardQueue(inst);
       return true;
     }
@@ -104,10 +95,10 @@ bool RegisterAnalysis::Mark(Ref<Inst> inst, const TaggedType &tnew)
 bool RegisterAnalysis::Define(Ref<Inst> inst, const TaggedType &tnew)
 {
 #ifdef NDEBUG
-  types_.emplace(inst, tnew);
+  types_.Emplace(inst, tnew);
   defs_.emplace(inst);
 #else
-  assert(types_.emplace(inst, tnew).second);
+  assert(types_.Emplace(inst, tnew).second);
   assert(defs_.emplace(inst).second);
 #endif
   BackwardQueue(inst);
@@ -117,11 +108,11 @@ bool RegisterAnalysis::Define(Ref<Inst> inst, const TaggedType &tnew)
 // -----------------------------------------------------------------------------
 bool RegisterAnalysis::Refine(Ref<Inst> inst, const TaggedType &tnew)
 {
-  auto it = types_.emplace(inst, tnew);
+  auto it = types_.Emplace(inst, tnew);
   if (!it.second) {
-    auto told = it.first->second;
+    auto told = *it.first;
     if (tnew < told) {
-      it.first->second = tnew;
+      *it.first = tnew;
       BackwardQueue(inst);
       return true;
     } else {
@@ -9,7 +9,9 @@
 #include <unordered_map>
 #include <llvm/Support/raw_ostream.h>
 
+#include "core/adt/dense_inst_map.h"
 #include "core/inst_visitor.h"
+#include "core/pass_manager.h"
 #include "core/target.h"
 #include "core/analysis/dominator.h"
 #include "passes/tags/tagged_type.h"
@@ -20,24 +22,15 @@ namespace tags {
 class Init;
 class Step;
 
-/// Cache of dominator/post-dominator trees and frontiers.
-struct DominatorCache {
-  /// Dominator tree.
-  DominatorTree DT;
-  /// Dominance frontier.
-  DominanceFrontier DF;
-  /// Post-Dominator Tree.
-  PostDominatorTree PDT;
-  /// Post-Dominance Frontier.
-  PostDominanceFrontier PDF;
-
-  DominatorCache(Func &func);
-};
-
 class RegisterAnalysis {
 public:
-  RegisterAnalysis(Prog &prog, const Target *target, bool banPolymorphism)
+  RegisterAnalysis(
+      Prog &prog,
+      Pass *pass,
+      const Target *target,
+      bool banPolymorphism)
     : prog_(prog)
+    , pass_(pass)
     , target_(target)
     , banPolymorphism_(banPolymorphism)
   {
@@ -52,8 +45,8 @@ public:
   /// Find the type assigned to a vreg.
   TaggedType Find(ConstRef<Inst> ref)
   {
-    auto it = types_.find(ref);
-    return it == types_.end() ? TaggedType::Unknown() : it->second;
+    auto *type = types_.Find(ref);
+    return type ? *type : TaggedType::Unknown();
   }
 
   /// Set the type, typically after rewriting an instruction.
@@ -101,26 +94,17 @@ private:
   static bool IsPolymorphic(const Inst &inst);
 
 private:
-  /// Return cached dominance information.
-  DominatorCache &GetDoms(Func &func)
-  {
-    auto it = doms_.emplace(&func, nullptr);
-    if (it.second) {
-      it.first->second.reset(new DominatorCache(func));
-    }
-    return *it.first->second;
-  }
-  /// Rebuild cached dominance info.
-  DominatorCache &RebuildDoms(Func &func)
+  /// Return dominance information cached by the pass manager.
+  DominatorAnalysis &GetDoms(Func &func)
   {
-    auto it = doms_.emplace(&func, nullptr);
-    it.first->second.reset(new DominatorCache(func));
-    return *it.first->second;
+    return pass_->getAnalysis<DominatorAnalysis>(func);
   }
 
 private:
   /// Reference to the underlying program.
   Prog &prog_;
+  /// Pass owning the analysis, providing dominator trees.
+  Pass *pass_;
   /// Reference to the target arch.
   const Target *target_;
   /// Ban polymorphic arithmetic operators.
@@ -140,7 +124,7 @@ private:
   /// Set of functions in the refine queue.
   std::unordered_set<Inst *> inRefineQueue_;
   /// Mapping from instructions to their types.
-  std::unordered_map<ConstRef<Inst>, TaggedType> types_;
+  DenseInstMap<TaggedType> types_;
   /// Mapping from indices to arguments.
   std::unordered_map
     < std::pair<const Func *, unsigned>
@@ -148,8 +132,6 @@ private:
     > args_;
   /// Mapping from functions to their return values.
   std::unordered_map<const Func *, std::vector<TaggedType>> rets_;
-  /// Cache of dominators for functions.
-  std::unordered_map<Func *, std::unique_ptr<DominatorCache>> doms_;
   /// Set of defined references.
   std::unordered_set<Ref<Inst>> defs_;
 };
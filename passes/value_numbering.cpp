@@ -15,6 +15,7 @@
 #include "core/inst_compare.h"
 #include "core/inst_visitor.h"
 #include "core/analysis/dominator.h"
+#include "core/pass_manager.h"
 #include "passes/value_numbering.h"
 
 #define DEBUG_TYPE "global-value-numbering"
@@ -151,7 +152,11 @@ private:
 // -----------------------------------------------------------------------------
 class GlobalValueNumbering : ValueNumbering {
 public:
-  GlobalValueNumbering(Func &func) : func_(func), doms_(func_) {}
+  GlobalValueNumbering(Func &func, DominatorTree &doms)
+    : func_(func)
+    , doms_(doms)
+  {
+  }
 
   bool Run()
   {
@@ -180,7 +185,7 @@ private:
   /// Reference to the function.
   Func &func_;
   /// Dominator tree of the function.
-  DominatorTree doms_;
+  DominatorTree &doms_;
 };
 
 // -----------------------------------------------------------------------------
@@ -201,7 +206,8 @@ bool ValueNumberingPass::Run(Prog &prog)
       case CallingConv::XEN:
       case CallingConv::INTR:
       case CallingConv::MULTIBOOT:  {
-        changed = GlobalValueNumbering(func).Run() || changed;
+        auto &doms = getAnalysis<DominatorAnalysis>(func).GetDominatorTree();
+        changed = GlobalValueNumbering(func, doms).Run() || changed;
         continue;
       }
     }
@@ -215,3 +221,9 @@ const char *ValueNumberingPass::GetPassName() const
 {
   return "Move Elimination";
 }
+
+// -----------------------------------------------------------------------------
+PreservedAnalyses ValueNumberingPass::GetPreserved() const
+{
+  return PreservedAnalyses().Preserve<DominatorAnalysis>();
+}
@@ -54,8 +54,9 @@ def run_opt_test(path, output_dir, comment):
 
   # Open the file and parse the special lines, extracting the commands
   # to run and the strings to identify in sequence in the file.
-  run_line = None
+  run_lines = []
   checks = []
+  check_nots = []
   with open(path, 'r') as f:
     for source_line in f.readlines():
       line = ' '.join(source_line.strip().split())
@@ -67,18 +68,55 @@ def run_opt_test(path, output_dir, comment):
       cmd = line.split(':')[0].strip()
       args = ':'.join(line.split(':')[1:]).strip()
       if cmd == 'RUN':
-        run_line = args
+        run_lines.append(args)
         continue
       if cmd == 'CHECK':
         checks.append(args)
         continue
+      if cmd == 'CHECK-NOT':
+        check_nots.append(args)
+        continue
       if cmd == 'DISABLED':
         return True
       raise RunError(f'Invalid check line: {source_line}')
 
-  if run_line is None:
+  if not run_lines:
     raise RunError(f'Missing run command: {path}')
 
+  # Run all pipelines in order, checking the output of the last one.
+  all_stderr = b''
+  for run_line in run_lines:
+    stdout, stderr = run_pipeline(path, output_dir, run_line)
+    all_stderr += stderr
+
+  if all_stderr:
+    print('FAIL: {}'.format(all_stderr.decode('utf-8')))
+    return False
+
+  lines = stdout.decode('utf-8').split('\n')
+  for check in check_nots:
+    if any(check in _process(line) for line in lines):
+      print('FAIL: {} found ({})'.format(check, run_lines[-1]))
+      return False
+
+  if checks:
+    checked = 0
+    for check in checks:
+      while checked < len(lines) and check not in _process(lines[checked]):
+        checked += 1
+
+      if checked >= len(lines):
+        print('FAIL: {} not found ({})'.format(check, run_lines[-1]))
+        return False
+
+  return True
+
+
+def run_pipeline(path, output_dir, run_line):
+  """Runs a pipeline, feeding the test file to it."""
+
+  run_line = run_line.replace('%S', os.path.dirname(path))
+  run_line = run_line.replace('%t', output_dir)
   run_line = run_line.replace('%opt', OPT_EXE)
   run_line = run_line.replace('%objcopy', OBJCOPY_EXE)
   run_line = run_line.replace('%clang', CLANG_EXE)
@@ -116,22 +154,7 @@ def run_opt_test(path, output_dir, comment):
         raise RunError('Command {} failed: {}'.format(command, code))
     all_stderr += stderr
 
-  if all_stderr:
-    print('FAIL: {}'.format(all_stderr.decode('utf-8')))
-    return False
-
-  if checks:
-    lines = stdout.decode('utf-8').split('\n')
-    checked = 0
-    for check in checks:
-      while checked < len(lines) and check not in _process(lines[checked]):
-        checked += 1
-
-      if checked >= len(lines):
-        print('FAIL: {} not found ({})'.format(check, ' '.join(args)))
-        return False
-
-  return True
+  return stdout, all_stderr
 
 
 def run_test(path, output_dir=None):
@@ -176,7 +199,9 @@ if __name__ == '__main__':
   else:
     # Run all tests in the test directory.
     def find_tests():
-      for directory, _, files in os.walk(os.path.join(PROJECT, 'test')):
+      for directory, dirs, files in os.walk(os.path.join(PROJECT, 'test')):
+        # Inputs directories hold fixtures referenced by tests.
+        dirs[:] = [d for d in dirs if d != 'Inputs']
         for file in sorted(files):
           if not file.endswith('_ext.c'):
             yield os.path.join(directory, file)
@@ -10,6 +10,7 @@
 #include <llvm/Support/WithColor.h>
 #include <llvm/Object/ArchiveWriter.h>
 
+#include "core/archive_index.h"
 #include "core/prog.h"
 #include "core/bitcode.h"
 #include "core/util.h"
@@ -36,9 +37,6 @@ static void exitIfError(llvm::Error e, llvm::Twine ctx)
   exit(EXIT_FAILURE);
 }
 
-// -----------------------------------------------------------------------------
-static constexpr auto kKind = llvm::object::Archive::K_GNU;
-
 // -----------------------------------------------------------------------------
 static int CreateOrUpdateArchive(
     llvm::StringRef path,
@@ -74,6 +72,9 @@ static int CreateOrUpdateArchive(
       auto nameOrErr = child.getName();
       exitIfError(nameOrErr.takeError(), "cannot read name " + path);
       auto name = nameOrErr.get();
+      if (name == ArchiveIndex::kName) {
+        continue;
+      }
 
       bool found = false;
       for (const auto &newName : objs) {
@@ -119,13 +120,9 @@ static int CreateOrUpdateArchive(
     }
   }
 
-  auto writeErr = llvm::writeArchive(
+  auto writeErr = WriteIndexedArchive(
       path,
-      members,
-      false,
-      kKind,
-      true,
-      false,
+      std::move(members),
       std::move(buffer)
   );
   exitIfError(std::move(writeErr), "cannot write archive");
@@ -156,6 +153,9 @@ static int ExtractArchive(const std::string &path, bool verbose)
     auto nameOrErr = child.getName();
     exitIfError(nameOrErr.takeError(), "missing name " + path);
     llvm::StringRef path = sys::path::filename(nameOrErr.get());
+    if (path == ArchiveIndex::kName) {
+      continue;
+    }
 
     // Get the contents of the data item.
     auto bufferOrError = child.getBuffer();
@@ -203,6 +203,9 @@ static int ListArchive(const std::string &path)
   for (auto &child : libOrErr.get()->children(err)) {
     auto nameOrErr = child.getName();
     exitIfError(nameOrErr.takeError(), "cannot read name " + path);
+    if (nameOrErr.get() == ArchiveIndex::kName) {
+      continue;
+    }
     llvm::outs() << nameOrErr.get() << "\n";
   }
 
@@ -284,7 +287,8 @@ int main(int argc, char **argv)
   }
 
   if (do_index) {
-    return EXIT_SUCCESS;
+    // Rewrite the archive with a fresh index.
+    return CreateOrUpdateArchive(argv[2], {}, true);
   }
 
   llvm_unreachable("not implemented");
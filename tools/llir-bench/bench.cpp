@@ -0,0 +1,202 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/InitLLVM.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "core/atom.h"
+#include "core/cast.h"
+#include "core/data.h"
+#include "core/func.h"
+#include "core/insts.h"
+#include "core/object.h"
+#include "core/parser.h"
+#include "core/pass_manager.h"
+#include "core/prog.h"
+#include "core/analysis/kildall.h"
+#include "passes/dead_store.h"
+
+namespace cl = llvm::cl;
+
+
+
+// -----------------------------------------------------------------------------
+static cl::opt<unsigned>
+optBlocks("blocks", cl::desc("number of blocks"), cl::init(512));
+
+static cl::opt<unsigned>
+optGlobals("globals", cl::desc("number of globals"), cl::init(64));
+
+static cl::opt<unsigned>
+optIterations("n", cl::desc("number of runs"), cl::init(10));
+
+
+
+// -----------------------------------------------------------------------------
+static std::string Generate(unsigned numBlocks, unsigned numGlobals)
+{
+  // Blocks store to globals, occasionally loading from one. Every other
+  // block branches over its successor and every 16 blocks form a loop.
+  std::ostringstream os;
+  os << "\t.section .text\n";
+  os << "bench:\n";
+  os << "\t.args i8\n";
+  os << "\targ.i8 $0, 0\n";
+  os << "\tjmp .Lb0\n";
+  unsigned next = 1;
+  for (unsigned i = 0; i < numBlocks; ++i) {
+    os << ".Lb" << i << ":\n";
+    unsigned addr = next++, value = next++;
+    os << "\tmov.i64 $" << addr << ", g" << (i * 7) % numGlobals << "\n";
+    os << "\tmov.i64 $" << value << ", " << i << "\n";
+    os << "\tst [$" << addr << "], $" << value << "\n";
+    if (i % 8 == 7) {
+      unsigned from = next++, load = next++;
+      os << "\tmov.i64 $" << from << ", g" << (i * 13) % numGlobals << "\n";
+      os << "\tld.i64 $" << load << ", [$" << from << "]\n";
+    }
+    if (i % 16 == 15) {
+      os << "\tjcc $0, .Lb" << i - 15 << ", .Lb" << i + 1 << "\n";
+    } else if (i % 2 == 0 && i + 2 <= numBlocks) {
+      os << "\tjcc $0, .Lb" << i + 1 << ", .Lb" << i + 2 << "\n";
+    } else {
+      os << "\tjmp .Lb" << i + 1 << "\n";
+    }
+  }
+  os << ".Lb" << numBlocks << ":\n";
+  os << "\tret\n";
+  os << "\t.end\n";
+
+  os << "\t.section .data\n";
+  for (unsigned i = 0; i < numGlobals; ++i) {
+    os << "g" << i << ":\n";
+    os << "\t.quad 0\n";
+    os << "\t.end\n";
+  }
+  return os.str();
+}
+
+// -----------------------------------------------------------------------------
+static Atom *ToAtom(Ref<Inst> addr)
+{
+  if (auto mov = ::cast_or_null<MovInst>(addr)) {
+    if (auto atom = ::cast_or_null<Atom>(mov->GetArg())) {
+      return &*atom;
+    }
+  }
+  return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+using LivenessSolverBase = BitVectorSolver
+    < Direction::BACKWARD
+    , Meet::UNION
+    >;
+
+// -----------------------------------------------------------------------------
+class LivenessSolver final : public LivenessSolverBase {
+public:
+  LivenessSolver(Func &func, const llvm::DenseMap<Atom *, unsigned> &globals)
+    : LivenessSolverBase(func, globals.size())
+    , globals_(globals)
+  {
+  }
+
+private:
+  void Build(Inst &inst, KillGen &kg) override
+  {
+    if (auto *load = ::cast_or_null<MemoryLoadInst>(&inst)) {
+      if (auto *atom = ToAtom(load->GetAddr())) {
+        kg.Gen(globals_.find(atom)->second);
+      }
+    }
+    if (auto *store = ::cast_or_null<MemoryStoreInst>(&inst)) {
+      if (auto *atom = ToAtom(store->GetAddr())) {
+        kg.Kill(globals_.find(atom)->second);
+      }
+    }
+  }
+
+  void Traverse(Inst &inst, const llvm::BitVector &flow) override
+  {
+    total_ += flow.count();
+  }
+
+private:
+  /// Indices of the globals.
+  const llvm::DenseMap<Atom *, unsigned> &globals_;
+  /// Sum of flow sizes.
+  uint64_t total_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+template <typename T>
+static void Measure(const char *name, const std::string &src, T &&run)
+{
+  std::vector<double> times;
+  for (unsigned i = 0; i < optIterations; ++i) {
+    auto prog = Parser(src, "bench").Parse();
+
+    auto start = std::chrono::steady_clock::now();
+    run(*prog);
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::micro> time = end - start;
+    times.push_back(time.count());
+  }
+  std::sort(times.begin(), times.end());
+
+  llvm::outs()
+      << llvm::format("%-12s", name)
+      << " min " << llvm::format("%10.1f", times.front()) << "us"
+      << " median " << llvm::format("%10.1f", times[times.size() / 2]) << "us"
+      << "\n";
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  llvm::InitLLVM X(argc, argv);
+  if (!cl::ParseCommandLineOptions(argc, argv, "LLIR benchmarks\n\n")) {
+    return EXIT_FAILURE;
+  }
+  if (optBlocks == 0 || optGlobals == 0 || optIterations == 0) {
+    llvm::errs() << "[Error] Invalid benchmark size\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::string src = Generate(optBlocks, optGlobals);
+
+  // Dataflow solver alone, on a liveness problem over the globals.
+  Measure("solver", src, [](Prog &prog) {
+    for (Func &func : prog) {
+      llvm::DenseMap<Atom *, unsigned> globals;
+      for (Data &data : prog.data()) {
+        for (Object &object : data) {
+          for (Atom &atom : object) {
+            globals.try_emplace(&atom, globals.size());
+          }
+        }
+      }
+      LivenessSolver solver(func, globals);
+      solver.Solve();
+    }
+  });
+
+  // Dead store elimination, including the numbering of globals.
+  Measure("dead-store", src, [](Prog &prog) {
+    PassManager passMngr(PassConfig(), nullptr, "", false, false, false);
+    passMngr.Add<DeadStorePass>();
+    passMngr.Run(prog);
+  });
+
+  return EXIT_SUCCESS;
+}
@@ -43,6 +43,9 @@ optInput(cl::Positional, cl::desc("<input>"), cl::Required);
 static cl::opt<std::string>
 optOutput("o", cl::desc("output"), cl::init("-"));
 
+static cl::opt<unsigned>
+optThreads("j", cl::desc("number of threads decoding and printing"), cl::init(1));
+
 
 
 // -----------------------------------------------------------------------------
@@ -75,13 +78,13 @@ int main(int argc, char **argv)
   }
 
   // Create a printer.
-  Printer p(output->os());
+  Printer p(output->os(), optThreads);
 
   // Parse the input, alter it and simplify it.
   auto memBufferRef = FileOrErr.get()->getMemBufferRef();
   auto buffer = memBufferRef.getBuffer();
   if (IsLLIRObject(buffer)) {
-    std::unique_ptr<Prog> prog(BitcodeReader(buffer).Read());
+    std::unique_ptr<Prog> prog(BitcodeReader(buffer, optThreads).Read());
     if (!prog) {
       return EXIT_FAILURE;
     }
@@ -107,7 +110,7 @@ int main(int argc, char **argv)
       auto buffer = bufferOrErr.get();
 
       if (IsLLIRObject(buffer)) {
-        auto prog = BitcodeReader(buffer).Read();
+        auto prog = BitcodeReader(buffer, optThreads).Read();
         if (!prog) {
           llvm::errs() << "[error] Cannot decode: " << name << "\n";
           return EXIT_FAILURE;
@@ -5,18 +5,30 @@
 #include <set>
 #include <sstream>
 
+#include <llvm/ADT/StringSwitch.h>
 #include <llvm/BinaryFormat/Magic.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/Program.h>
 #include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Support/WithColor.h>
 #include <llvm/Object/Archive.h>
 
+#include "core/adt/thread_pool.h"
+#include "core/archive_index.h"
 #include "core/bitcode.h"
 #include "core/printer.h"
 #include "core/prog.h"
+#include "core/target.h"
+#include "core/use.h"
 #include "core/util.h"
 #include "core/error.h"
+#include "emitter/emitter.h"
+#include "passes/dead_code_elim.h"
+#include "passes/move_elim.h"
+#include "tools/llir-opt/compile_cache.h"
+#include "tools/llir-opt/pipeline.h"
 
 #include "driver.h"
 #include "options.h"
@@ -62,6 +74,48 @@ static OptLevel ParseOptLevel(llvm::opt::Arg *arg)
   }
 }
 
+// -----------------------------------------------------------------------------
+static std::optional<OptLevel> ParseOptLevel(llvm::StringRef flag)
+{
+  return llvm::StringSwitch<std::optional<OptLevel>>(flag)
+      .Case("-O0", OptLevel::O0)
+      .Case("-O1", OptLevel::O1)
+      .Case("-O2", OptLevel::O2)
+      .Case("-O3", OptLevel::O3)
+      .Case("-O4", OptLevel::O4)
+      .Case("-Os", OptLevel::Os)
+      .Default(std::nullopt);
+}
+
+// -----------------------------------------------------------------------------
+static unsigned ParseThreads(llvm::opt::Arg *arg)
+{
+  unsigned threads;
+  if (!arg || llvm::StringRef(arg->getValue()).getAsInteger(10, threads)) {
+    return 1;
+  }
+  return std::max(threads, 1u);
+}
+
+// -----------------------------------------------------------------------------
+static uint64_t ParseCacheSize(llvm::opt::Arg *arg)
+{
+  uint64_t size;
+  if (!arg || llvm::StringRef(arg->getValue()).getAsInteger(10, size)) {
+    return CompileCache::kDefaultSize;
+  }
+  return size;
+}
+
+// -----------------------------------------------------------------------------
+static std::string GetFlag(const char *env, const std::string &flag)
+{
+  if (auto *value = getenv(env)) {
+    return value;
+  }
+  return flag;
+}
+
 // -----------------------------------------------------------------------------
 Driver::Driver(
     const llvm::Triple &triple,
@@ -82,6 +136,12 @@ Driver::Driver(
   , entry_(args.getLastArgValue(OPT_entry))
   , rpath_(args.getLastArgValue(OPT_rpath))
   , optLevel_(ParseOptLevel(args.getLastArg(OPT_O_Group)))
+  , threads_(ParseThreads(args.getLastArg(OPT_threads)))
+  , externalOpt_(args.hasArg(OPT_external_opt))
+  , cacheDir_(args.getLastArgValue(OPT_cache_dir))
+  , cacheSize_(ParseCacheSize(args.getLastArg(OPT_cache_size)))
+  , ltoCacheDir_(args.getLastArgValue(OPT_thinlto_cache_dir))
+  , ltoCachePolicy_(args.getLastArgValue(OPT_thinlto_cache_policy))
   , libraryPaths_(args.getAllArgValues(OPT_library_path))
 {
   args.ClaimAllArgs(OPT_nostdlib);
@@ -146,9 +206,30 @@ Driver::LoadArchive(llvm::MemoryBufferRef buffer)
     return libOrErr.takeError();
   }
 
-  // Decode all LLIR objects, dump the rest to text files.
+  // Members to decode, in archive order.
+  struct Member {
+    /// Type of the member.
+    FileMagic Magic;
+    /// Contents of the member.
+    llvm::MemoryBufferRef Buffer;
+    /// Entry in the index, if the member is indexed.
+    const ArchiveIndex::Member *Entry = nullptr;
+    /// Path to the temporary file holding a data member.
+    std::string Path;
+    /// Decoded LLIR object and its reader.
+    std::unique_ptr<Prog> P;
+    std::unique_ptr<BitcodeReader> Reader;
+    /// Decoded LLVM bitcode object.
+    std::unique_ptr<llvm::lto::InputFile> Bitcode;
+    /// Error message, if decoding failed.
+    std::string Error;
+  };
+
+  // Find all members, dumping data to temporary files.
   llvm::Error err = llvm::Error::success();
-  Linker::Archive ar;
+  std::vector<Member> members;
+  std::optional<ArchiveIndex> index;
+  unsigned member = 0;
   for (auto &child : libOrErr.get()->children(err)) {
     // Get the name.
     auto nameOrErr = child.getName();
@@ -163,18 +244,29 @@ Driver::LoadArchive(llvm::MemoryBufferRef buffer)
       return bufferOrErr.takeError();
     }
     auto buffer = bufferOrErr.get();
+
+    // The index, if present, precedes all other members.
+    if (member == 0 && !index && nameOrErr.get() == ArchiveIndex::kName) {
+      index = ArchiveIndex::Read(buffer);
+      continue;
+    }
+    const ArchiveIndex::Member *entry = nullptr;
+    if (index) {
+      entry = index->Find(member, nameOrErr.get(), buffer);
+    }
+    ++member;
+
     if (buffer.empty()) {
       continue;
     }
 
-    // Parse bitcode or write data to a temporary file.
-    switch (Identify(buffer)) {
+    // Record objects to decode or write data to a temporary file.
+    switch (auto magic = Identify(buffer)) {
       case FileMagic::LLIR: {
-        auto prog = BitcodeReader(buffer).Read();
-        if (!prog) {
-          return MakeError("cannot parse bitcode");
-        }
-        ar.emplace_back(std::move(prog));
+        auto &object = members.emplace_back();
+        object.Magic = magic;
+        object.Buffer = llvm::MemoryBufferRef(buffer, name);
+        object.Entry = entry;
         continue;
       }
       case FileMagic::BITCODE: {
@@ -184,11 +276,9 @@ Driver::LoadArchive(llvm::MemoryBufferRef buffer)
         if (!memBuffer) {
           return MakeError("cannot create buffer");
         }
-        auto bitcodeOrError = llvm::lto::InputFile::create(*memBuffer);
-        if (!bitcodeOrError) {
-          return bitcodeOrError.takeError();
-        }
-        ar.emplace_back(std::move(bitcodeOrError.get()));
+        auto &object = members.emplace_back();
+        object.Magic = magic;
+        object.Buffer = memBuffer->getMemBufferRef();
         continue;
       }
       case FileMagic::OBJECT: {
@@ -209,7 +299,9 @@ Driver::LoadArchive(llvm::MemoryBufferRef buffer)
           return llvm::errorCodeToError(ec);
         }
         os.write(buffer.data(), buffer.size());
-        ar.emplace_back(Linker::Unit::Data{ tmp.TmpName });
+        auto &data = members.emplace_back();
+        data.Magic = magic;
+        data.Path = tmp.TmpName;
         tempFiles_.emplace_back(std::move(tmp));
         continue;
       }
@@ -222,9 +314,74 @@ Driver::LoadArchive(llvm::MemoryBufferRef buffer)
   }
   if (err) {
     return std::move(err);
-  } else {
-    return ar;
   }
+
+  // Decode the objects in parallel. Indexed LLIR objects are decoded later,
+  // if they resolve a symbol. Otherwise, only symbols are decoded, with the
+  // bodies being read if the object is linked.
+  {
+    ThreadPool pool(threads_);
+    Use::SetConcurrent(true);
+    pool.ParallelFor(members.size(), [&members](size_t i) {
+      auto &m = members[i];
+      switch (m.Magic) {
+        case FileMagic::LLIR: {
+          if (!m.Entry) {
+            m.Reader = std::make_unique<BitcodeReader>(m.Buffer.getBuffer());
+            m.P = m.Reader->ReadLazy();
+          }
+          return;
+        }
+        case FileMagic::BITCODE: {
+          auto bitcodeOrError = llvm::lto::InputFile::create(m.Buffer);
+          if (!bitcodeOrError) {
+            m.Error = llvm::toString(bitcodeOrError.takeError());
+          } else {
+            m.Bitcode = std::move(bitcodeOrError.get());
+          }
+          return;
+        }
+        default: {
+          return;
+        }
+      }
+    });
+    Use::SetConcurrent(false);
+  }
+
+  // Create the units in archive order.
+  Linker::Archive ar;
+  for (auto &m : members) {
+    switch (m.Magic) {
+      case FileMagic::LLIR: {
+        if (m.Entry) {
+          auto buffer = m.Buffer.getBuffer();
+          ar.emplace_back(Linker::Unit::Lazy{ buffer, m.Entry->Defined });
+          continue;
+        }
+        if (!m.P) {
+          return MakeError("cannot parse bitcode");
+        }
+        ar.emplace_back(std::move(m.P), std::move(m.Reader));
+        continue;
+      }
+      case FileMagic::BITCODE: {
+        if (!m.Bitcode) {
+          return MakeError(m.Error);
+        }
+        ar.emplace_back(std::move(m.Bitcode));
+        continue;
+      }
+      case FileMagic::BLOB: {
+        ar.emplace_back(Linker::Unit::Data{ m.Path });
+        continue;
+      }
+      default: {
+        llvm_unreachable("invalid archive member");
+      }
+    }
+  }
+  return ar;
 }
 
 // -----------------------------------------------------------------------------
@@ -238,8 +395,9 @@ Driver::TryLoadArchive(const std::string &path)
       return llvm::errorCodeToError(ec);
     }
 
-    // Load the archive.
-    auto buffer = fileOrErr.get()->getMemBufferRef();
+    // Load the archive, keeping the file mapped for lazy objects.
+    auto &file = buffers_.emplace_back(std::move(fileOrErr.get()));
+    auto buffer = file->getMemBufferRef();
     auto modulesOrErr = LoadArchive(buffer);
     if (!modulesOrErr) {
       return modulesOrErr.takeError();
@@ -254,8 +412,18 @@ Driver::TryLoadArchive(const std::string &path)
 // -----------------------------------------------------------------------------
 llvm::Error Driver::Link()
 {
+  // Set up the cache of LTO outputs.
+  std::optional<CompileCache> cache;
+  if (!ltoCacheDir_.empty()) {
+    auto policyOrErr = llvm::parseCachePruningPolicy(ltoCachePolicy_);
+    if (!policyOrErr) {
+      return policyOrErr.takeError();
+    }
+    cache.emplace(ltoCacheDir_, *policyOrErr);
+  }
+
   // Collect objects and archives.
-  Linker linker(llirTriple_, output_);
+  Linker linker(llirTriple_, output_, threads_, std::move(cache));
   bool wholeArchive = false;
   std::unique_ptr<std::list<Linker::Unit>> group = nullptr;
 
@@ -299,7 +467,7 @@ llvm::Error Driver::Link()
         switch (Identify(memBuffer.getBuffer())) {
           case FileMagic::LLIR: {
             // Decode an object.
-            auto prog = Parse(memBuffer.getBuffer(), fullPath);
+            auto prog = Parse(memBuffer.getBuffer(), fullPath, threads_);
             if (!prog) {
               return MakeError("cannot read object: " + fullPath);
             }
@@ -309,7 +477,8 @@ llvm::Error Driver::Link()
             continue;
           }
           case FileMagic::ARCHIVE: {
-            // Decode an archive.
+            // Decode an archive, keeping the file mapped for lazy objects.
+            buffers_.emplace_back(std::move(memBufferOrErr.get()));
             auto modulesOrErr = LoadArchive(memBuffer);
             if (!modulesOrErr) {
               return modulesOrErr.takeError();
@@ -501,7 +670,7 @@ llvm::Error Driver::Output(OutputType type, Prog &prog)
         return llvm::errorCodeToError(err);
       }
 
-      Printer(output->os()).Print(prog);
+      Printer(output->os(), threads_).Print(prog);
       output->keep();
       return llvm::Error::success();
     }
@@ -517,7 +686,7 @@ llvm::Error Driver::Output(OutputType type, Prog &prog)
         return llvm::errorCodeToError(err);
       }
 
-      BitcodeWriter(output->os()).Write(prog);
+      BitcodeWriter(output->os(), threads_).Write(prog);
       output->keep();
       return llvm::Error::success();
     }
@@ -525,113 +694,244 @@ llvm::Error Driver::Output(OutputType type, Prog &prog)
     case OutputType::OBJ:
     case OutputType::ASM: {
       // Lower the final program to the desired format.
-      return WithTemp(".llbc", [&](int fd, llvm::StringRef llirPath) {
-        {
-          llvm::raw_fd_ostream os(fd, false);
-          BitcodeWriter(os).Write(prog);
+      if (type != OutputType::EXE) {
+        return Compile(prog, output_, type);
+      }
+      return WithTemp(".o", [&](int, llvm::StringRef elfPath) {
+        if (auto error = Compile(prog, elfPath, OutputType::OBJ)) {
+          return error;
         }
 
-        if (type != OutputType::EXE) {
-          return RunOpt(llirPath, output_, type);
-        } else {
-          return WithTemp(".o", [&](int, llvm::StringRef elfPath) {
-            auto error = RunOpt(llirPath, elfPath, OutputType::OBJ);
-            if (error) {
-              return error;
-            }
-
-            const std::string ld = baseTriple_.str() + "-ld";
-            std::vector<llvm::StringRef> args;
-            args.push_back(ld);
+        const std::string ld = baseTriple_.str() + "-ld";
+        std::vector<llvm::StringRef> args;
+        args.push_back(ld);
 
-            // Architecture-specific flags.
-            switch (baseTriple_.getArch()) {
-              case llvm::Triple::x86:
-              case llvm::Triple::llir_x86: {
-                break;
-              }
-              case llvm::Triple::x86_64:
-              case llvm::Triple::llir_x86_64: {
-                args.push_back("--no-ld-generated-unwind-info");
-                break;
-              }
-              case llvm::Triple::aarch64:
-              case llvm::Triple::llir_aarch64: {
-                break;
-              }
-              case llvm::Triple::riscv64:
-              case llvm::Triple::llir_riscv64: {
-                break;
-              }
-              case llvm::Triple::ppc64le:
-              case llvm::Triple::llir_ppc64le: {
-                break;
-              }
-              default: {
-                return MakeError("unknown target: " + baseTriple_.str());
-              }
-            }
-            // Common flags.
-            args.push_back("-nostdlib");
-            // Output file.
-            args.push_back("-o");
-            args.push_back(output_);
-            // Entry point.
-            if (!entry_.empty()) {
-              args.push_back("-e");
-              args.push_back(entry_);
-            }
-            // rpath.
-            if (!rpath_.empty()) {
-              args.push_back("-rpath");
-              args.push_back(rpath_);
-            }
-            // Forwarded arguments.
-            for (const auto &forwarded : forwarded_) {
-              args.push_back(forwarded);
-            }
-            // Link the inputs.
-            args.push_back("--start-group");
-            // LLIR-to-ELF code.
-            args.push_back(elfPath);
-            // Library paths.
-            if (!externLibs_.empty()) {
-              for (llvm::StringRef lib : libraryPaths_) {
-                args.push_back("-L");
-                args.push_back(lib);
-              }
-              // External libraries.
-              for (llvm::StringRef lib : externLibs_) {
-                args.push_back(lib);
-              }
-            }
-            // Extern objects.
-            args.push_back("--end-group");
-            if (shared_) {
-              // Shared library options.
-              args.push_back("-shared");
-            } else {
-              // Executable options.
-              if (static_) {
-                // Static executable options.
-                args.push_back("-static");
-              } else {
-                // Dynamic executable options.
-                if (exportDynamic_) {
-                  args.push_back("-E");
-                }
-              }
+        // Architecture-specific flags.
+        switch (baseTriple_.getArch()) {
+          case llvm::Triple::x86:
+          case llvm::Triple::llir_x86: {
+            break;
+          }
+          case llvm::Triple::x86_64:
+          case llvm::Triple::llir_x86_64: {
+            args.push_back("--no-ld-generated-unwind-info");
+            break;
+          }
+          case llvm::Triple::aarch64:
+          case llvm::Triple::llir_aarch64: {
+            break;
+          }
+          case llvm::Triple::riscv64:
+          case llvm::Triple::llir_riscv64: {
+            break;
+          }
+          case llvm::Triple::ppc64le:
+          case llvm::Triple::llir_ppc64le: {
+            break;
+          }
+          default: {
+            return MakeError("unknown target: " + baseTriple_.str());
+          }
+        }
+        // Common flags.
+        args.push_back("-nostdlib");
+        // Output file.
+        args.push_back("-o");
+        args.push_back(output_);
+        // Entry point.
+        if (!entry_.empty()) {
+          args.push_back("-e");
+          args.push_back(entry_);
+        }
+        // rpath.
+        if (!rpath_.empty()) {
+          args.push_back("-rpath");
+          args.push_back(rpath_);
+        }
+        // Forwarded arguments.
+        for (const auto &forwarded : forwarded_) {
+          args.push_back(forwarded);
+        }
+        // Link the inputs.
+        args.push_back("--start-group");
+        // LLIR-to-ELF code.
+        args.push_back(elfPath);
+        // Library paths.
+        if (!externLibs_.empty()) {
+          for (llvm::StringRef lib : libraryPaths_) {
+            args.push_back("-L");
+            args.push_back(lib);
+          }
+          // External libraries.
+          for (llvm::StringRef lib : externLibs_) {
+            args.push_back(lib);
+          }
+        }
+        // Extern objects.
+        args.push_back("--end-group");
+        if (shared_) {
+          // Shared library options.
+          args.push_back("-shared");
+        } else {
+          // Executable options.
+          if (static_) {
+            // Static executable options.
+            args.push_back("-static");
+          } else {
+            // Dynamic executable options.
+            if (exportDynamic_) {
+              args.push_back("-E");
             }
-            // Run the linker.
-            return RunExecutable(ld, args);
-          });
+          }
         }
+        // Run the linker.
+        return RunExecutable(ld, args);
       });
     }
   }
   llvm_unreachable("invalid output type");
 }
 
+// -----------------------------------------------------------------------------
+llvm::Error Driver::Compile(
+    Prog &prog,
+    llvm::StringRef output,
+    OutputType type)
+{
+  if (cacheDir_.empty()) {
+    return Generate(prog, output, type);
+  }
+
+  // Key the output on the program and on all the flags which affect it,
+  // resolving the same overrides and defaults as the pipeline.
+  CompileCache::Key k(baseTriple_.str());
+  {
+    llvm::SmallString<0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    BitcodeWriter(os, threads_).Write(prog);
+    k.Add(bitcode);
+  }
+  std::string cpu = GetFlag("LLIR_OPT_CPU", targetCPU_);
+  llvm::Triple hostTriple(llvm::sys::getDefaultTargetTriple());
+  if (cpu.empty() && baseTriple_.getArch() == hostTriple.getArch()) {
+    cpu = std::string(llvm::sys::getHostCPUName());
+  }
+  k.Add(output_);
+  k.Add(static_cast<uint64_t>(type));
+  k.Add(static_cast<uint64_t>(optLevel_));
+  k.Add(GetFlag("LLIR_OPT_O", ""));
+  k.Add(GetFlag("LLIR_OPT_FLAGS", ""));
+  k.Add(externalOpt_);
+  k.Add(cpu);
+  k.Add(GetFlag("LLIR_OPT_ABI", targetABI_));
+  k.Add(GetFlag("LLIR_OPT_FS", targetFS_));
+  k.Add(shared_).Add(static_).Add(entry_);
+  std::string key = k.Hash();
+
+  // Reuse the cached output if available.
+  CompileCache cache(cacheDir_, cacheSize_);
+  if (auto entry = cache.Lookup(key)) {
+    std::error_code err;
+    llvm::raw_fd_ostream os(output, err, llvm::sys::fs::F_None);
+    if (err) {
+      return llvm::errorCodeToError(err);
+    }
+    os << entry->getBuffer();
+    return llvm::Error::success();
+  }
+
+  // Generate code and record the output.
+  if (auto err = Generate(prog, output, type)) {
+    return err;
+  }
+  if (auto fileOrErr = llvm::MemoryBuffer::getFile(output)) {
+    if (auto err = cache.Store(key, fileOrErr.get()->getBuffer())) {
+      llvm::WithColor::warning()
+          << "cannot cache output: " << llvm::toString(std::move(err)) << "\n";
+    }
+  }
+  return llvm::Error::success();
+}
+
+// -----------------------------------------------------------------------------
+llvm::Error Driver::Generate(
+    Prog &prog,
+    llvm::StringRef output,
+    OutputType type)
+{
+  // Additional flags can only be understood by the external optimiser.
+  if (!externalOpt_ && !getenv("LLIR_OPT_FLAGS")) {
+    return RunPipeline(prog, output, type);
+  }
+
+  return WithTemp(".llbc", [&](int fd, llvm::StringRef llirPath) {
+    {
+      llvm::raw_fd_ostream os(fd, false);
+      BitcodeWriter(os, threads_).Write(prog);
+    }
+    return RunOpt(llirPath, output, type);
+  });
+}
+
+// -----------------------------------------------------------------------------
+llvm::Error Driver::RunPipeline(
+    Prog &prog,
+    llvm::StringRef output,
+    OutputType type)
+{
+  // Find the optimisation level, which can be overridden.
+  OptLevel level = optLevel_;
+  if (auto *opt = getenv("LLIR_OPT_O")) {
+    if (auto optLevel = ParseOptLevel(opt)) {
+      level = *optLevel;
+    } else {
+      return MakeError("invalid LLIR_OPT_O: " + llvm::Twine(opt));
+    }
+  }
+
+  // Find the target, defaulting to the host CPU like llir-opt.
+  std::string cpu = GetFlag("LLIR_OPT_CPU", targetCPU_);
+  std::string abi = GetFlag("LLIR_OPT_ABI", targetABI_);
+  std::string fs = GetFlag("LLIR_OPT_FS", targetFS_);
+  llvm::Triple hostTriple(llvm::sys::getDefaultTargetTriple());
+  if (cpu.empty() && baseTriple_.getArch() == hostTriple.getArch()) {
+    cpu = std::string(llvm::sys::getHostCPUName());
+  }
+  auto target = CreateTarget(baseTriple_, cpu, cpu, fs, abi, shared_);
+  if (!target) {
+    return MakeError("cannot find target: " + baseTriple_.str());
+  }
+
+  // Optimise the program.
+  {
+    PassConfig cfg(level, static_, shared_, entry_);
+    PassManager mngr(cfg, target.get(), "", false, false, false, threads_);
+    AddPasses(mngr, level);
+    mngr.Add<MoveElimPass>();
+    mngr.Add<DeadCodeElimPass>();
+    mngr.Run(prog);
+  }
+
+  // Generate code.
+  std::error_code err;
+  auto file = std::make_unique<llvm::ToolOutputFile>(
+      output,
+      err,
+      type == OutputType::ASM ? llvm::sys::fs::F_Text : llvm::sys::fs::F_None
+  );
+  if (err) {
+    return llvm::errorCodeToError(err);
+  }
+  auto emitter = CreateEmitter(output_, file->os(), *target);
+  if (type == OutputType::ASM) {
+    emitter->EmitASM(prog);
+  } else {
+    emitter->EmitOBJ(prog);
+  }
+  file->keep();
+  return llvm::Error::success();
+}
+
 // -----------------------------------------------------------------------------
 llvm::Error Driver::RunOpt(
     llvm::StringRef input,
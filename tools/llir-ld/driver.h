@@ -9,28 +9,14 @@
 #include <llvm/Support/Error.h>
 #include <optional>
 
+#include "core/pass_manager.h"
+
 #include "linker.h"
 
 class Prog;
 
 
 
-/// Enumeration of optimisation levels.
-enum class OptLevel {
-  /// No optimisations.
-  O0,
-  /// Simple optimisations.
-  O1,
-  /// Aggressive optimisations.
-  O2,
-  /// Slow optimisations.
-  O3,
-  /// All optimisations.
-  O4,
-  /// Optimise for size.
-  Os
-};
-
 /**
  * Helper to create a string error.
  */
@@ -77,6 +63,16 @@ private:
 
   /// Emit the output.
   llvm::Error Output(OutputType type, Prog &prog);
+  /// Optimise and lower a program, reusing cached outputs.
+  llvm::Error Compile(Prog &prog, llvm::StringRef output, OutputType type);
+  /// Optimise and lower a program to an object or assembly file.
+  llvm::Error Generate(Prog &prog, llvm::StringRef output, OutputType type);
+  /// Run the optimiser and the code generator in-process.
+  llvm::Error RunPipeline(
+      Prog &prog,
+      llvm::StringRef output,
+      OutputType type
+  );
   // Run the optimiser on a binary.
   llvm::Error RunOpt(
       llvm::StringRef input,
@@ -122,6 +118,18 @@ private:
   std::string rpath_;
   /// Optimisation level.
   OptLevel optLevel_;
+  /// Number of threads used for I/O and optimisation.
+  unsigned threads_;
+  /// Flag to run the optimiser in a separate process.
+  bool externalOpt_;
+  /// Directory caching generated code, empty if disabled.
+  std::string cacheDir_;
+  /// Upper bound on the size of the cache.
+  uint64_t cacheSize_;
+  /// Directory caching LTO outputs, empty if disabled.
+  std::string ltoCacheDir_;
+  /// Pruning policy of the LTO cache.
+  std::string ltoCachePolicy_;
   /// Paths to libraries.
   std::vector<std::string> libraryPaths_;
 
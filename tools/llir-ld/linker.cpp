@@ -3,9 +3,12 @@
 // (C) 2018 Nandor Licker. All rights reserved.
 
 #include <llvm/Support/Error.h>
+#include <llvm/Support/WithColor.h>
 #include <llvm/CodeGen/CommandFlags.h>
+#include <llvm/LTO/Caching.h>
 
 #include "core/atom.h"
+#include "core/bitcode.h"
 #include "core/block.h"
 #include "core/cast.h"
 #include "core/error.h"
@@ -24,6 +27,16 @@ Linker::Unit::Unit(std::unique_ptr<Prog> &&prog)
   new (&s_.P) std::unique_ptr<Prog>(std::move(prog));
 }
 
+// -----------------------------------------------------------------------------
+Linker::Unit::Unit(
+    std::unique_ptr<Prog> &&prog,
+    std::unique_ptr<BitcodeReader> &&reader)
+  : kind_(Kind::LLIR)
+  , reader_(std::move(reader))
+{
+  new (&s_.P) std::unique_ptr<Prog>(std::move(prog));
+}
+
 // -----------------------------------------------------------------------------
 Linker::Unit::Unit(std::unique_ptr<llvm::lto::InputFile> &&bitcode)
   : kind_(Kind::BITCODE)
@@ -31,6 +44,14 @@ Linker::Unit::Unit(std::unique_ptr<llvm::lto::InputFile> &&bitcode)
   new (&s_.B) std::unique_ptr<llvm::lto::InputFile>(std::move(bitcode));
 }
 
+// -----------------------------------------------------------------------------
+Linker::Unit::Unit(Lazy &&lazy)
+  : kind_(Kind::LLIR)
+  , lazy_(std::move(lazy))
+{
+  new (&s_.P) std::unique_ptr<Prog>();
+}
+
 // -----------------------------------------------------------------------------
 Linker::Unit::Unit(const Object &object)
 {
@@ -47,6 +68,8 @@ Linker::Unit::Unit(const Data &data)
 // -----------------------------------------------------------------------------
 Linker::Unit::Unit(Unit &&that)
   : kind_(that.kind_)
+  , reader_(std::move(that.reader_))
+  , lazy_(std::move(that.lazy_))
 {
   switch (that.kind_) {
     case Unit::Kind::LLIR: {
@@ -96,6 +119,16 @@ Linker::Unit &Linker::Unit::operator=(Unit &&)
   llvm_unreachable("not implemented");
 }
 
+// -----------------------------------------------------------------------------
+void Linker::Unit::Load()
+{
+  assert(kind_ == Kind::LLIR && lazy_ && "unit already loaded");
+  auto reader = std::make_unique<BitcodeReader>(lazy_->Buffer);
+  s_.P = reader->ReadLazy();
+  reader_ = std::move(reader);
+  lazy_.reset();
+}
+
 // -----------------------------------------------------------------------------
 llvm::Error Linker::LinkUndefined(const std::string &symbol)
 {
@@ -108,6 +141,9 @@ llvm::Error Linker::LinkObject(Unit &&unit)
 {
   switch (unit.kind_) {
     case Unit::Kind::LLIR: {
+      if (unit.lazy_) {
+        unit.Load();
+      }
       auto &prog = *unit.s_.P;
       if (linked_.insert(prog.getName()).second) {
         Resolve(prog);
@@ -163,6 +199,14 @@ llvm::Error Linker::LinkGroup(std::list<Linker::Unit> &&units)
       for (auto it = units.begin(); it != units.end(); ) {
         switch (it->kind_) {
           case Unit::Kind::LLIR: {
+            // Decode indexed objects only if they are needed.
+            if (it->lazy_) {
+              if (!Resolves(*it->lazy_)) {
+                ++it;
+                continue;
+              }
+              it->Load();
+            }
             auto &p = *it->s_.P;
             if (!Resolves(p)) {
               ++it;
@@ -227,6 +271,17 @@ bool Linker::Resolves(Prog &p)
   return false;
 }
 
+// -----------------------------------------------------------------------------
+bool Linker::Resolves(const Unit::Lazy &lazy)
+{
+  for (const std::string &name : lazy.Defined) {
+    if (unresolved_.count(name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // -----------------------------------------------------------------------------
 bool Linker::Resolves(llvm::lto::InputFile &obj)
 {
@@ -333,6 +388,10 @@ llvm::Expected<std::vector<std::unique_ptr<Prog>>> Linker::Collect()
   for (auto &&unit : units_) {
     switch (unit.kind_) {
       case Unit::Kind::LLIR: {
+        // Decode the bodies of objects pulled in from archives.
+        if (unit.reader_) {
+          unit.reader_->MaterializeAll();
+        }
         objects.emplace_back(std::move(unit.s_.P));
         continue;
       }
@@ -587,18 +646,56 @@ llvm::Expected<std::vector<std::unique_ptr<Prog>>> Linker::LTO(
     );
   };
 
+  // Reuse the outputs of unchanged ThinLTO modules from the cache.
   llvm::lto::NativeObjectCache cache;
+  if (cache_) {
+    auto addBuffer = [&](unsigned task, std::unique_ptr<llvm::MemoryBuffer> mb)
+    {
+      outputs[task] = mb->getBuffer();
+    };
+    auto cacheOrError = llvm::lto::localCache(cache_->GetDir(), addBuffer);
+    if (!cacheOrError) {
+      return cacheOrError.takeError();
+    }
+    cache = std::move(*cacheOrError);
+  }
   if (auto err = opt->run(stream, cache)) {
     return std::move(err);
   }
 
   std::vector<std::unique_ptr<Prog>> progs;
   for (unsigned i = 0, n = outputs.size(); i < n; ++i) {
-    auto name = "lto." + llvm::Twine(i);
-    auto prog = Parser(outputs[i], name.str()).Parse();
+    auto name = ("lto." + llvm::Twine(i)).str();
+
+    // Decode the program from the cache if the output was parsed before.
+    std::string key;
+    if (cache_) {
+      key = CompileCache::Key(triple_.str()).Add(name).Add(outputs[i]).Hash();
+      if (auto entry = cache_->Lookup(key)) {
+        if (auto prog = BitcodeReader(entry->getBuffer(), threads_).Read()) {
+          progs.emplace_back(std::move(prog));
+          continue;
+        }
+      }
+    }
+
+    auto prog = Parser(outputs[i], name, threads_).Parse();
     if (!prog) {
       return MakeError("cannot parse LTO output");
     }
+
+    // Record the program in its compact bitcode form.
+    if (cache_) {
+      llvm::SmallString<0> buffer;
+      llvm::raw_svector_ostream os(buffer);
+      BitcodeWriter(os, threads_).Write(*prog);
+      if (auto err = cache_->Store(key, buffer)) {
+        // The cache is an optimisation: the link proceeds without it.
+        llvm::WithColor::warning()
+            << "cannot cache LTO output: "
+            << llvm::toString(std::move(err)) << "\n";
+      }
+    }
     progs.emplace_back(std::move(prog));
   }
   return std::move(progs);
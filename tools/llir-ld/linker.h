@@ -4,13 +4,18 @@
 
 #pragma once
 
+#include <optional>
 #include <set>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 #include <llvm/Support/WithColor.h>
 #include <llvm/LTO/LTO.h>
 
+#include "tools/llir-opt/compile_cache.h"
+
+class BitcodeReader;
 class Prog;
 class Func;
 class Data;
@@ -41,9 +46,23 @@ public:
 
     /// Create a unit for an LLIR program.
     Unit(std::unique_ptr<Prog> &&prog);
+    /// Create a unit for an LLIR program with bodies decoded on demand.
+    Unit(
+        std::unique_ptr<Prog> &&prog,
+        std::unique_ptr<BitcodeReader> &&reader
+    );
     /// Crete a unit for an LLVM bitcode object.
     Unit(std::unique_ptr<llvm::lto::InputFile> &&bitcode);
 
+    /// Create a unit for an indexed LLIR object, decoded only if linked.
+    struct Lazy {
+      /// Contents of the object.
+      llvm::StringRef Buffer;
+      /// Symbols defined by the object, as recorded in the index.
+      std::vector<std::string> Defined;
+    };
+    Unit(Lazy &&lazy);
+
     /// Create a unit for an ELF object.
     struct Object { llvm::StringRef Path; };
     Unit(const Object &object);
@@ -62,6 +81,10 @@ public:
 
   private:
     friend class Linker;
+    /// Decodes the symbols of a lazy unit.
+    void Load();
+
+  private:
     /// Kind of the unit.
     Kind kind_;
     /// Union of stored items.
@@ -72,15 +95,25 @@ public:
       S() {}
       ~S() {}
     } s_;
+    /// Reader of an LLIR program whose bodies were not yet decoded.
+    std::unique_ptr<BitcodeReader> reader_;
+    /// Indexed LLIR object whose symbols were not yet decoded.
+    std::optional<Lazy> lazy_;
   };
 
   /// Representation for an entire archive.
   using Archive = std::list<Linker::Unit>;
 
   /// Initialise the linker.
-  Linker(const llvm::Triple &triple, std::string_view output)
+  Linker(
+      const llvm::Triple &triple,
+      std::string_view output,
+      unsigned threads = 1,
+      std::optional<CompileCache> &&cache = std::nullopt)
     : triple_(triple)
     , output_(output)
+    , threads_(threads)
+    , cache_(std::move(cache))
     , lto_(false)
   {
   }
@@ -108,6 +141,8 @@ private:
 
   /// Checks whether the unit resolves a symbol.
   bool Resolves(Prog &prog);
+  /// Checks whether the indexed object resolves a symbol.
+  bool Resolves(const Unit::Lazy &lazy);
   /// Checks whether the bitcode module resolves a symbol.
   bool Resolves(llvm::lto::InputFile &prog);
 
@@ -139,6 +174,10 @@ private:
   llvm::Triple triple_;
   /// Name of the output.
   std::string output_;
+  /// Number of threads to parse LTO outputs with.
+  unsigned threads_;
+  /// Cache of LTO outputs and of the programs parsed from them.
+  std::optional<CompileCache> cache_;
   /// Set of object files to link.
   std::vector<Unit> units_;
   /// Set of linked-in external objects.
@@ -0,0 +1,162 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <chrono>
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include "tools/llir-opt/compile_cache.h"
+
+namespace fs = llvm::sys::fs;
+
+
+
+/// Prefix of entries, recognised by the LLVM cache pruner.
+static constexpr const char *kEntryPrefix = "llvmcache-";
+
+// -----------------------------------------------------------------------------
+static uint64_t GetExecutableHash()
+{
+  // The revision is only captured when the build is configured, thus tools
+  // rebuilt from modified sources are told apart by their contents.
+  static const uint64_t hash = []() -> uint64_t {
+    std::string exe = fs::getMainExecutable(nullptr, nullptr);
+    auto bufferOrErr = llvm::MemoryBuffer::getFile(exe);
+    if (exe.empty() || !bufferOrErr) {
+      return 0;
+    }
+    return llvm::xxHash64((*bufferOrErr)->getBuffer());
+  }();
+  return hash;
+}
+
+// -----------------------------------------------------------------------------
+CompileCache::Key::Key(llvm::StringRef triple)
+{
+  Add(LLIR_VERSION);
+  Add(LLIR_REVISION);
+  Add(GetExecutableHash());
+  Add(LLVM_VERSION_STRING);
+  Add(triple);
+}
+
+// -----------------------------------------------------------------------------
+CompileCache::Key &CompileCache::Key::Add(llvm::StringRef data)
+{
+  Add(static_cast<uint64_t>(data.size()));
+  sha_.update(data);
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+CompileCache::Key &CompileCache::Key::Add(uint64_t data)
+{
+  uint8_t bytes[sizeof(data)];
+  for (unsigned i = 0; i < sizeof(data); ++i) {
+    bytes[i] = (data >> (i * 8)) & 0xFF;
+  }
+  sha_.update(bytes);
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+std::string CompileCache::Key::Hash()
+{
+  return llvm::toHex(sha_.result(), true);
+}
+
+// -----------------------------------------------------------------------------
+CompileCache::CompileCache(llvm::StringRef dir, uint64_t maxSize)
+  : dir_(dir)
+{
+  // Bound the size only, evicting the least recently used entries.
+  policy_.Interval = std::chrono::seconds(0);
+  policy_.Expiration = std::chrono::seconds(0);
+  policy_.MaxSizePercentageOfAvailableSpace = 0;
+  policy_.MaxSizeBytes = maxSize;
+}
+
+// -----------------------------------------------------------------------------
+CompileCache::CompileCache(
+    llvm::StringRef dir,
+    const llvm::CachePruningPolicy &policy)
+  : dir_(dir)
+  , policy_(policy)
+{
+}
+
+// -----------------------------------------------------------------------------
+std::unique_ptr<llvm::MemoryBuffer> CompileCache::Lookup(llvm::StringRef key)
+{
+  std::string path = GetPath(key);
+  auto fdOrErr = fs::openNativeFileForRead(path);
+  if (!fdOrErr) {
+    llvm::consumeError(fdOrErr.takeError());
+    return nullptr;
+  }
+  fs::file_t fd = *fdOrErr;
+
+  auto bufferOrErr = llvm::MemoryBuffer::getOpenFile(fd, path, -1, false);
+  if (bufferOrErr) {
+    // The pruner evicts entries by access time, which is updated explicitly
+    // since file systems mounted with noatime or relatime do not track it.
+    fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+  }
+  fs::closeFile(fd);
+  if (!bufferOrErr) {
+    return nullptr;
+  }
+  return std::move(*bufferOrErr);
+}
+
+// -----------------------------------------------------------------------------
+llvm::Error CompileCache::Store(llvm::StringRef key, llvm::StringRef data)
+{
+  if (auto ec = fs::create_directories(dir_)) {
+    return llvm::errorCodeToError(ec);
+  }
+
+  // Write the entry to a temporary file first, renaming it once complete
+  // in order not to expose partial entries to concurrent readers.
+  llvm::SmallString<128> model(dir_);
+  llvm::sys::path::append(model, "tmp-%%%%%%%%");
+  auto tmpOrErr = fs::TempFile::create(model);
+  if (!tmpOrErr) {
+    return tmpOrErr.takeError();
+  }
+  auto &tmp = *tmpOrErr;
+  {
+    llvm::raw_fd_ostream os(tmp.FD, false);
+    os << data;
+    os.flush();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::consumeError(tmp.discard());
+      return llvm::createStringError(
+          llvm::inconvertibleErrorCode(),
+          "cannot write cache entry"
+      );
+    }
+  }
+  if (auto err = tmp.keep(GetPath(key))) {
+    return err;
+  }
+
+  // Evict entries if the cache is full.
+  llvm::pruneCache(dir_, policy_);
+  return llvm::Error::success();
+}
+
+// -----------------------------------------------------------------------------
+std::string CompileCache::GetPath(llvm::StringRef key) const
+{
+  llvm::SmallString<128> path(dir_);
+  llvm::sys::path::append(path, llvm::Twine(kEntryPrefix) + key);
+  return std::string(path);
+}
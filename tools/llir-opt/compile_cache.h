@@ -0,0 +1,78 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+
+
+
+/**
+ * Persistent, content-addressed cache of compiler outputs.
+ *
+ * Entries are files in a directory which can be shared by multiple processes,
+ * named after the hash of all the inputs which determine the output: the
+ * program, the options, the target and the revision and executable of the
+ * tool. Entries are written atomically and evicted according to an LLVM cache
+ * pruning policy, which by default drops the least recently used ones once
+ * the size of the directory exceeds a limit.
+ */
+class CompileCache final {
+public:
+  /// Default upper bound on the size of the cache.
+  static constexpr uint64_t kDefaultSize = 1ull << 30;
+
+  /**
+   * Hash of the inputs of a compilation, including the revision of the tool.
+   */
+  class Key final {
+  public:
+    /// Creates a key identifying the running tool and the target.
+    Key(llvm::StringRef triple);
+
+    /// Adds a string to the key.
+    Key &Add(llvm::StringRef data);
+    /// Adds an integer to the key.
+    Key &Add(uint64_t data);
+
+    /// Returns the hexadecimal digest of the key.
+    std::string Hash();
+
+  private:
+    /// Hash of all the items.
+    llvm::SHA1 sha_;
+  };
+
+public:
+  /// Opens a cache in a directory, which is created if it does not exist.
+  CompileCache(llvm::StringRef dir, uint64_t maxSize = kDefaultSize);
+  /// Opens a cache in a directory, with a custom eviction policy.
+  CompileCache(llvm::StringRef dir, const llvm::CachePruningPolicy &policy);
+
+  /// Returns the directory holding the entries.
+  llvm::StringRef GetDir() const { return dir_; }
+
+  /// Finds an entry, marking it as used. Returns null on a miss.
+  std::unique_ptr<llvm::MemoryBuffer> Lookup(llvm::StringRef key);
+  /// Adds an entry, evicting others as required by the policy.
+  llvm::Error Store(llvm::StringRef key, llvm::StringRef data);
+
+private:
+  /// Returns the path to an entry.
+  std::string GetPath(llvm::StringRef key) const;
+
+private:
+  /// Directory holding the entries.
+  std::string dir_;
+  /// Policy to evict entries by.
+  llvm::CachePruningPolicy policy_;
+};
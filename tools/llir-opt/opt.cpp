@@ -4,11 +4,18 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <optional>
 
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/InitLLVM.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/StringSaver.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Support/Host.h>
 
@@ -17,58 +24,14 @@
 #include "core/pass_registry.h"
 #include "core/printer.h"
 #include "core/prog.h"
+#include "core/target.h"
 #include "core/util.h"
-#include "core/target/x86.h"
-#include "core/target/ppc.h"
-#include "core/target/aarch64.h"
-#include "core/target/riscv.h"
-#include "emitter/aarch64/aarch64emitter.h"
+#include "emitter/emitter.h"
 #include "emitter/coq/coqemitter.h"
-#include "emitter/ppc/ppcemitter.h"
-#include "emitter/riscv/riscvemitter.h"
-#include "emitter/x86/x86emitter.h"
-#include "passes/atom_simplify.h"
-#include "passes/bypass_phi.h"
-#include "passes/caml_alloc_inliner.h"
-#include "passes/caml_assign.h"
-#include "passes/caml_global_simplify.h"
-#include "passes/code_layout.h"
-#include "passes/cond_simplify.h"
-#include "passes/const_global.h"
 #include "passes/dead_code_elim.h"
-#include "passes/dead_data_elim.h"
-#include "passes/dead_func_elim.h"
-#include "passes/dead_store.h"
-#include "passes/dedup_block.h"
-#include "passes/dedup_const.h"
-#include "passes/eliminate_select.h"
-#include "passes/eliminate_tags.h"
-#include "passes/global_forward.h"
-#include "passes/inliner.h"
-#include "passes/libc_simplify.h"
-#include "passes/linearise.h"
-#include "passes/link.h"
-#include "passes/localize_select.h"
-#include "passes/mem_to_reg.h"
-#include "passes/merge_stores.h"
 #include "passes/move_elim.h"
-#include "passes/move_push.h"
-#include "passes/object_split.h"
-#include "passes/phi_taut.h"
-#include "passes/peephole.h"
-#include "passes/pre_eval.h"
-#include "passes/pta.h"
-#include "passes/sccp.h"
-#include "passes/simplify_cfg.h"
-#include "passes/simplify_trampoline.h"
-#include "passes/specialise.h"
-#include "passes/stack_object_elim.h"
-#include "passes/store_to_load.h"
-#include "passes/tail_rec_elim.h"
-#include "passes/undef_elim.h"
-#include "passes/unused_arg.h"
-#include "passes/value_numbering.h"
-#include "stats/alloc_size.h"
+#include "tools/llir-opt/compile_cache.h"
+#include "tools/llir-opt/pipeline.h"
 
 namespace cl = llvm::cl;
 namespace sys = llvm::sys;
@@ -99,6 +62,19 @@ optOutput("o", cl::desc("output"), cl::init("-"));
 static cl::opt<bool>
 optTime("time", cl::desc("time passes"), cl::init(false));
 
+static cl::opt<std::string>
+optTimeReport("time-report", cl::desc("write a JSON pass profile to a file"));
+
+static cl::opt<std::string>
+optTrace("trace", cl::desc("write a Chrome trace of the run to a file"));
+
+static cl::opt<unsigned>
+optTraceGranularity(
+    "trace-granularity",
+    cl::desc("minimum duration of traced events, in microseconds"),
+    cl::init(500)
+);
+
 static cl::opt<OptLevel>
 optOptLevel(
   cl::desc("optimisation level:"),
@@ -158,244 +134,92 @@ optVerify("verify", cl::desc("Enable the verified pass"), cl::init(false));
 static cl::opt<std::string>
 optSaveBefore("save-before", cl::desc("save IR to file before all passes"));
 
+static cl::opt<unsigned>
+optSaveRotate(
+    "save-rotate",
+    cl::desc(
+        "with -save-before, keep the last N snapshots taken in the "
+        "background before passes which follow a change"
+    ),
+    cl::init(0)
+);
 
+static cl::opt<std::string>
+optCacheDir("cache-dir", cl::desc("directory caching outputs across runs"));
 
-// -----------------------------------------------------------------------------
-static void AddOpt0(PassManager &mngr)
-{
-}
-
-// -----------------------------------------------------------------------------
-static void AddOpt1(PassManager &mngr)
-{
-  mngr.Add<LinkPass>();
-  // Initial simplification.
-  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
-  mngr.Add<DeadCodeElimPass>();
-  mngr.Add<MoveElimPass>();
-  mngr.Add<SimplifyCfgPass>();
-  mngr.Add<TailRecElimPass>();
-  mngr.Add<CamlAssignPass>();
-  // General simplification.
-  mngr.Group
-    < ConstGlobalPass
-    , SCCPPass
-    , SimplifyCfgPass
-    , DeadCodeElimPass
-    , DeadFuncElimPass
-    , DeadDataElimPass
-    , DedupBlockPass
-    , UnusedArgPass
-    >();
-  // Final transformation.
-  mngr.Add<MergeStoresPass>();
-  mngr.Add<StackObjectElimPass>();
-  mngr.Add<LocalizeSelectPass>();
-  mngr.Add<CamlAllocInlinerPass>();
-}
+static cl::opt<uint64_t>
+optCacheSize(
+    "cache-size",
+    cl::desc("maximum size of the cache, in bytes"),
+    cl::init(CompileCache::kDefaultSize)
+);
 
-// -----------------------------------------------------------------------------
-static void AddOpt2(PassManager &mngr)
-{
-  mngr.Add<LinkPass>();
-  // Initial simplification.
-  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
-  mngr.Add<DeadCodeElimPass>();
-  mngr.Add<MoveElimPass>();
-  mngr.Add<SimplifyCfgPass>();
-  mngr.Add<TailRecElimPass>();
-  mngr.Add<CamlAssignPass>();
-  // General simplification.
-  mngr.Group
-    < ConstGlobalPass
-    , SCCPPass
-    , LibCSimplifyPass
-    , SimplifyCfgPass
-    , DedupConstPass
-    , BypassPhiPass
-    , SpecialisePass
-    , DeadCodeElimPass
-    , DeadFuncElimPass
-    , DeadDataElimPass
-    , MoveElimPass
-    , MovePushPass
-    , PhiTautPass
-    , InlinerPass
-    , CondSimplifyPass
-    , DedupBlockPass
-    , UnusedArgPass
-    >();
-  // Final transformation.
-  mngr.Add<MergeStoresPass>();
-  mngr.Add<StackObjectElimPass>();
-  mngr.Add<LocalizeSelectPass>();
-  mngr.Add<CamlAllocInlinerPass>();
-}
+static cl::opt<unsigned>
+optThreads("j", cl::desc("number of threads running function passes and I/O"), cl::init(1));
 
-// -----------------------------------------------------------------------------
-static void AddOpt3(PassManager &mngr)
-{
-  mngr.Add<LinkPass>();
-  // Initial simplification.
-  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
-  mngr.Add<DeadCodeElimPass>();
-  mngr.Add<MoveElimPass>();
-  mngr.Add<SimplifyCfgPass>();
-  mngr.Add<TailRecElimPass>();
-  mngr.Add<CamlAssignPass>();
-  // General simplification.
-  mngr.Group
-    < ConstGlobalPass
-    , SCCPPass
-    , LibCSimplifyPass
-    , SimplifyCfgPass
-    , DedupConstPass
-    , BypassPhiPass
-    , SpecialisePass
-    , DeadCodeElimPass
-    , DeadFuncElimPass
-    , DeadDataElimPass
-    , MoveElimPass
-    , MovePushPass
-    , PhiTautPass
-    , InlinerPass
-    , CondSimplifyPass
-    , DedupBlockPass
-    , UnusedArgPass
-    >();
-  // Final transformation.
-  mngr.Add<MergeStoresPass>();
-  mngr.Add<StackObjectElimPass>();
-  mngr.Add<LocalizeSelectPass>();
-  mngr.Add<CamlAllocInlinerPass>();
-}
 
-// -----------------------------------------------------------------------------
-static void AddOpt4(PassManager &mngr)
-{
-  mngr.Add<LinkPass>();
-  // Initial simplification.
-  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
-  mngr.Add<DeadCodeElimPass>();
-  mngr.Add<MoveElimPass>();
-  mngr.Add<SimplifyCfgPass>();
-  mngr.Add<TailRecElimPass>();
-  mngr.Add<CamlAssignPass>();
-  // General simplification.
-  mngr.Group
-    < PeepholePass
-    , CamlGlobalSimplifyPass
-    , ConstGlobalPass
-    , LibCSimplifyPass
-    , SCCPPass
-    , DedupConstPass
-    , SimplifyCfgPass
-    , BypassPhiPass
-    , SpecialisePass
-    , EliminateSelectPass
-    , DeadCodeElimPass
-    , DeadFuncElimPass
-    , DeadDataElimPass
-    , MoveElimPass
-    , MovePushPass
-    , PhiTautPass
-    , InlinerPass
-    , CondSimplifyPass
-    , DedupBlockPass
-    , UnusedArgPass
-    >();
-  // Final transformation.
-  mngr.Add<MergeStoresPass>();
-  mngr.Add<StackObjectElimPass>();
-  mngr.Add<LocalizeSelectPass>();
-  mngr.Add<CodeLayoutPass>();
-  mngr.Add<CamlAllocInlinerPass>();
-}
 
 // -----------------------------------------------------------------------------
-static void AddOptS(PassManager &mngr)
-{
-  // First round - compact
-  mngr.Add<LinkPass>();
-  // Simplify functions and eliminate trivial items.
-  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
-  mngr.Add<DeadCodeElimPass>();
-  mngr.Add<MoveElimPass>();
-  mngr.Add<MovePushPass>();
-  mngr.Add<SimplifyCfgPass>();
-  mngr.Add<TailRecElimPass>();
-  mngr.Add<SimplifyTrampolinePass>();
-  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
-  mngr.Add<DeadCodeElimPass>();
-  mngr.Add<AtomSimplifyPass>();
-  mngr.Add<CamlAssignPass>();
-  // Optimise, evaluate and optimise again.
-  mngr.Group
-    < PeepholePass
-    , CamlGlobalSimplifyPass
-    , ConstGlobalPass
-    , LibCSimplifyPass
-    , ValueNumberingPass
-    , SCCPPass
-    , DedupBlockPass
-    , SimplifyCfgPass
-    , DedupConstPass
-    , BypassPhiPass
-    , DeadCodeElimPass
-    , DeadFuncElimPass
-    , DeadDataElimPass
-    , MoveElimPass
-    , MovePushPass
-    , PhiTautPass
-    , EliminateSelectPass
-    , EliminateTagsPass
-    , SpecialisePass
-    , InlinerPass
-    , CondSimplifyPass
-    , ObjectSplitPass
-    , StoreToLoadPass
-    , DeadStorePass
-    , MemoryToRegisterPass
-    , UnusedArgPass
-    , GlobalForwardPass
-    >();
-  // Final simplification.
-  mngr.Add<MergeStoresPass>();
-  mngr.Add<LocalizeSelectPass>();
-  mngr.Add<CodeLayoutPass>();
-  mngr.Add<StackObjectElimPass>();
-}
+/// Options which do not affect the output, thus they are not part of keys.
+static const char *kUnkeyedOptions[] = {
+  "o", "v", "time", "time-report", "trace", "trace-granularity",
+  "save-before", "save-rotate", "cache-dir", "cache-size", "j",
+};
 
 // -----------------------------------------------------------------------------
-static std::unique_ptr<Target>
-GetTarget(
-    const llvm::Triple &tt,
-    const std::string &cpu,
-    const std::string &tuneCPU,
-    const std::string &fs,
-    const std::string &abi,
-    bool shared)
+static void AddOptions(CompileCache::Key &k, int argc, char **argv)
 {
-  switch (tt.getArch()) {
-    case llvm::Triple::x86:
-    case llvm::Triple::x86_64: {
-      return std::make_unique<X86Target>(tt, cpu, tuneCPU, fs, abi, shared);
-    }
-    case llvm::Triple::aarch64: {
-      return std::make_unique<AArch64Target>(tt, cpu, tuneCPU, fs, abi, shared);
+  // Hash the command line instead of the parsed options, covering hidden
+  // options registered by passes and the options of the LLVM backend.
+  llvm::BumpPtrAllocator alloc;
+  llvm::StringSaver saver(alloc);
+  llvm::SmallVector<const char *, 32> args(argv + 1, argv + argc);
+  cl::ExpandResponseFiles(saver, cl::TokenizeGNUCommandLine, args);
+
+  auto &opts = cl::getRegisteredOptions();
+  for (unsigned i = 0, n = args.size(); i < n; ++i) {
+    llvm::StringRef arg(args[i]);
+    if (!arg.startswith("-") || arg == "-") {
+      // Skip the input, which is keyed on its contents instead of its path.
+      continue;
     }
-    case llvm::Triple::riscv64: {
-      return std::make_unique<RISCVTarget>(tt, cpu, tuneCPU, fs, abi, shared);
+
+    // Find the value if it is a separate argument.
+    llvm::StringRef name = arg.ltrim('-').split('=').first;
+    std::optional<llvm::StringRef> value;
+    auto it = opts.find(name);
+    if (!arg.contains('=') && it != opts.end() && i + 1 < n) {
+      if (it->second->getValueExpectedFlag() == cl::ValueRequired) {
+        value = args[++i];
+      }
     }
-    case llvm::Triple::ppc64le: {
-      return std::make_unique<PPCTarget>(tt, cpu, tuneCPU, fs, abi, shared);
+    if (llvm::is_contained(kUnkeyedOptions, name)) {
+      continue;
     }
-    default: {
-      return nullptr;
+    k.Add(arg);
+    if (value) {
+      k.Add(*value);
     }
   }
 }
 
+// -----------------------------------------------------------------------------
+static bool WriteTrace()
+{
+  if (optTrace.empty()) {
+    return true;
+  }
+  std::error_code err;
+  llvm::raw_fd_ostream os(optTrace, err, sys::fs::F_Text);
+  if (err) {
+    llvm::errs() << "[Error] Cannot write trace: " << err.message() << "\n";
+    return false;
+  }
+  llvm::timeTraceProfilerWrite(os);
+  llvm::timeTraceProfilerCleanup();
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 int main(int argc, char **argv)
 {
@@ -412,6 +236,11 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  // Start tracing if requested.
+  if (!optTrace.empty()) {
+    llvm::timeTraceProfilerInitialize(optTraceGranularity, argv[0]);
+  }
+
   // Find the host triple.
   llvm::Triple hostTriple(llvm::sys::getDefaultTargetTriple());
 
@@ -438,12 +267,34 @@ int main(int argc, char **argv)
   std::string tuneCPU = optTuneCPU.empty() ? CPU : optTuneCPU;
 
   // Find the target architecture.
-  auto t = GetTarget(triple, CPU, tuneCPU, optFS, optABI, optShared);
+  auto t = CreateTarget(triple, CPU, tuneCPU, optFS, optABI, optShared);
   if (!t) {
     llvm::errs() << "[Error] Cannot find target: " + triple.str() + "\n";
     return EXIT_FAILURE;
   }
 
+  // Determine the output type.
+  llvm::StringRef out = optOutput;
+
+  // Figure out the output type.
+  OutputType type;
+  if (optEmit.getNumOccurrences()) {
+    type = optEmit;
+  } else if (out.endswith(".llir")) {
+    type = OutputType::LLIR;
+  } else if (out.endswith(".llbc")) {
+    type = OutputType::LLBC;
+  } else if (out.endswith(".S") || out.endswith(".s") || out == "-") {
+    type = OutputType::ASM;
+  } else if (out.endswith(".o")) {
+    type = OutputType::OBJ;
+  } else if (out.endswith(".v")) {
+    type = OutputType::COQ;
+  } else {
+    llvm::errs() << "[Error] Unknown output format\n";
+    return EXIT_FAILURE;
+  }
+
   // Open the input.
   auto FileOrErr = llvm::MemoryBuffer::getFileOrSTDIN(optInput);
   if (auto EC = FileOrErr.getError()) {
@@ -451,92 +302,78 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  // Parse the linked blob: if file starts with magic, parse bitcode.
   auto buffer = FileOrErr.get()->getMemBufferRef().getBuffer();
-  std::unique_ptr<Prog> prog(Parse(buffer, Abspath(optInput)));
+
+  // Look up the output in the cache, keyed on the input and on all the
+  // flags which affect the output.
+  std::optional<CompileCache> cache;
+  std::string key;
+  if (!optCacheDir.empty() && optOutput != "-") {
+    cache.emplace(optCacheDir, optCacheSize);
+
+    CompileCache::Key k(triple.str());
+    k.Add(buffer);
+    k.Add(static_cast<uint64_t>(type));
+    k.Add(CPU).Add(tuneCPU);
+    AddOptions(k, argc, argv);
+    // Of the input path, outputs only record the name of the program:
+    // the absolute path in IR and the file name in objects.
+    if (type == OutputType::LLIR || type == OutputType::LLBC) {
+      k.Add(Abspath(optInput));
+    } else {
+      k.Add(sys::path::filename(optInput));
+    }
+    key = k.Hash();
+
+    if (auto entry = cache->Lookup(key)) {
+      std::error_code err;
+      auto output = std::make_unique<llvm::ToolOutputFile>(
+          optOutput,
+          err,
+          sys::fs::F_None
+      );
+      if (err) {
+        llvm::errs() << err.message() << "\n";
+        return EXIT_FAILURE;
+      }
+      output->os() << entry->getBuffer();
+      if (!WriteTrace()) {
+        return EXIT_FAILURE;
+      }
+      output->keep();
+      return EXIT_SUCCESS;
+    }
+  }
+
+  // Parse the linked blob: if file starts with magic, parse bitcode.
+  std::unique_ptr<Prog> prog(Parse(buffer, Abspath(optInput), optThreads));
   if (!prog) {
     return EXIT_FAILURE;
   }
 
   // Register all the passes.
   PassRegistry registry;
-  registry.Register<AllocSizePass>();
-  registry.Register<CamlAllocInlinerPass>();
-  registry.Register<CamlGlobalSimplifyPass>();
-  registry.Register<CamlAssignPass>();
-  registry.Register<DeadCodeElimPass>();
-  registry.Register<DeadDataElimPass>();
-  registry.Register<DeadFuncElimPass>();
-  registry.Register<DeadStorePass>();
-  registry.Register<DedupBlockPass>();
-  registry.Register<SpecialisePass>();
-  registry.Register<InlinerPass>();
-  registry.Register<LinkPass>();
-  registry.Register<MoveElimPass>();
-  registry.Register<MovePushPass>();
-  registry.Register<PreEvalPass>();
-  registry.Register<SCCPPass>();
-  registry.Register<SimplifyCfgPass>();
-  registry.Register<SimplifyTrampolinePass>();
-  registry.Register<StackObjectElimPass>();
-  registry.Register<TailRecElimPass>();
-  registry.Register<ConstGlobalPass>();
-  registry.Register<UndefElimPass>();
-  registry.Register<MemoryToRegisterPass>();
-  registry.Register<PointsToAnalysis>();
-  registry.Register<AtomSimplifyPass>();
-  registry.Register<EliminateSelectPass>();
-  registry.Register<CondSimplifyPass>();
-  registry.Register<StoreToLoadPass>();
-  registry.Register<LibCSimplifyPass>();
-  registry.Register<UnusedArgPass>();
-  registry.Register<GlobalForwardPass>();
-  registry.Register<ObjectSplitPass>();
-  registry.Register<ValueNumberingPass>();
-  registry.Register<LinearisePass>();
-  registry.Register<PhiTautPass>();
-  registry.Register<CodeLayoutPass>();
-  registry.Register<LocalizeSelectPass>();
-  registry.Register<EliminateTagsPass>();
+  RegisterPasses(registry);
 
   // Set up the pipeline.
   PassConfig cfg(optOptLevel, optStatic, optShared, optEntry);
-  PassManager passMngr(cfg, t.get(), optSaveBefore, optVerbose, optTime, optVerify);
+  PassManager passMngr(
+      cfg,
+      t.get(),
+      optSaveBefore,
+      optVerbose,
+      optTime,
+      optVerify,
+      optThreads,
+      optTimeReport,
+      optSaveRotate
+  );
   if (!optPasses.empty()) {
     for (auto &passName : optPasses) {
       registry.Add(passMngr, std::string(passName));
     }
   } else {
-    switch (optOptLevel) {
-      case OptLevel::O0: AddOpt0(passMngr); break;
-      case OptLevel::O1: AddOpt1(passMngr); break;
-      case OptLevel::O2: AddOpt2(passMngr); break;
-      case OptLevel::O3: AddOpt3(passMngr); break;
-      case OptLevel::O4: AddOpt4(passMngr); break;
-      case OptLevel::Os: AddOptS(passMngr); break;
-    }
-  }
-
-  // Determine the output type.
-  llvm::StringRef out = optOutput;
-
-  // Figure out the output type.
-  OutputType type;
-  if (optEmit.getNumOccurrences()) {
-    type = optEmit;
-  } else if (out.endswith(".llir")) {
-    type = OutputType::LLIR;
-  } else if (out.endswith(".llbc")) {
-    type = OutputType::LLBC;
-  } else if (out.endswith(".S") || out.endswith(".s") || out == "-") {
-    type = OutputType::ASM;
-  } else if (out.endswith(".o")) {
-    type = OutputType::OBJ;
-  } else if (out.endswith(".v")) {
-    type = OutputType::COQ;
-  } else {
-    llvm::errs() << "[Error] Unknown output format\n";
-    return EXIT_FAILURE;
+    AddPasses(passMngr, optOptLevel);
   }
 
   // Check if output is binary.
@@ -583,28 +420,11 @@ int main(int argc, char **argv)
 
   // Helper to create an emitter.
   auto getEmitter = [&] () -> std::unique_ptr<Emitter> {
-    auto &os = output->os();
-    switch (triple.getArch()) {
-      case llvm::Triple::x86:
-      case llvm::Triple::x86_64: {
-        return std::make_unique<X86Emitter>(optInput, os, *t->As<X86Target>());
-      }
-      case llvm::Triple::aarch64: {
-        return std::make_unique<AArch64Emitter>(optInput, os, *t->As<AArch64Target>());
-      }
-      case llvm::Triple::riscv64: {
-        return std::make_unique<RISCVEmitter>(optInput, os, *t->As<RISCVTarget>());
-      }
-      case llvm::Triple::ppc64le: {
-        return std::make_unique<PPCEmitter>(optInput, os, *t->As<PPCTarget>());
-      }
-      default: {
-        llvm::report_fatal_error("Unknown architecture: " + triple.normalize());
-      }
-    }
+    return CreateEmitter(optInput, output->os(), *t);
   };
 
   // Generate code.
+  llvm::timeTraceProfilerBegin("Emit", optOutput);
   switch (type) {
     case OutputType::ASM: {
       getEmitter()->EmitASM(*prog);
@@ -615,11 +435,11 @@ int main(int argc, char **argv)
       break;
     }
     case OutputType::LLIR: {
-      Printer(output->os()).Print(*prog);
+      Printer(output->os(), optThreads).Print(*prog);
       break;
     }
     case OutputType::LLBC: {
-      BitcodeWriter(output->os()).Write(*prog);
+      BitcodeWriter(output->os(), optThreads).Write(*prog);
       break;
     }
     case OutputType::COQ: {
@@ -627,7 +447,23 @@ int main(int argc, char **argv)
       break;
     }
   }
+  llvm::timeTraceProfilerEnd();
 
+  // Write the trace.
+  if (!WriteTrace()) {
+    return EXIT_FAILURE;
+  }
   output->keep();
+
+  // Record the output in the cache.
+  if (cache) {
+    output->os().flush();
+    if (auto fileOrErr = llvm::MemoryBuffer::getFile(optOutput)) {
+      auto data = fileOrErr.get()->getBuffer();
+      if (auto err = cache->Store(key, data)) {
+        llvm::errs() << "[Warning] Cannot cache output: " << err << "\n";
+      }
+    }
+  }
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,375 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#include <llvm/Support/ErrorHandling.h>
+
+#include "core/pass_registry.h"
+#include "core/target/x86.h"
+#include "core/target/ppc.h"
+#include "core/target/aarch64.h"
+#include "core/target/riscv.h"
+#include "emitter/aarch64/aarch64emitter.h"
+#include "emitter/ppc/ppcemitter.h"
+#include "emitter/riscv/riscvemitter.h"
+#include "emitter/x86/x86emitter.h"
+#include "passes/atom_simplify.h"
+#include "passes/bypass_phi.h"
+#include "passes/caml_alloc_inliner.h"
+#include "passes/caml_assign.h"
+#include "passes/caml_global_simplify.h"
+#include "passes/code_layout.h"
+#include "passes/cond_simplify.h"
+#include "passes/const_global.h"
+#include "passes/dead_code_elim.h"
+#include "passes/dead_data_elim.h"
+#include "passes/dead_func_elim.h"
+#include "passes/dead_store.h"
+#include "passes/dedup_block.h"
+#include "passes/dedup_const.h"
+#include "passes/eliminate_select.h"
+#include "passes/eliminate_tags.h"
+#include "passes/global_forward.h"
+#include "passes/inliner.h"
+#include "passes/libc_simplify.h"
+#include "passes/linearise.h"
+#include "passes/link.h"
+#include "passes/localize_select.h"
+#include "passes/mem_to_reg.h"
+#include "passes/merge_stores.h"
+#include "passes/move_elim.h"
+#include "passes/move_push.h"
+#include "passes/object_split.h"
+#include "passes/phi_taut.h"
+#include "passes/peephole.h"
+#include "passes/pre_eval.h"
+#include "passes/pta.h"
+#include "passes/sccp.h"
+#include "passes/simplify_cfg.h"
+#include "passes/simplify_trampoline.h"
+#include "passes/specialise.h"
+#include "passes/stack_object_elim.h"
+#include "passes/store_to_load.h"
+#include "passes/tail_rec_elim.h"
+#include "passes/undef_elim.h"
+#include "passes/unused_arg.h"
+#include "passes/value_numbering.h"
+#include "stats/alloc_size.h"
+#include "tools/llir-opt/pipeline.h"
+
+
+
+// -----------------------------------------------------------------------------
+static void AddOpt0(PassManager &mngr)
+{
+}
+
+// -----------------------------------------------------------------------------
+static void AddOpt1(PassManager &mngr)
+{
+  mngr.Add<LinkPass>();
+  // Initial simplification.
+  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
+  mngr.Add<DeadCodeElimPass>();
+  mngr.Add<MoveElimPass>();
+  mngr.Add<SimplifyCfgPass>();
+  mngr.Add<TailRecElimPass>();
+  mngr.Add<CamlAssignPass>();
+  // General simplification.
+  mngr.Group
+    < ConstGlobalPass
+    , SCCPPass
+    , SimplifyCfgPass
+    , DeadCodeElimPass
+    , DeadFuncElimPass
+    , DeadDataElimPass
+    , DedupBlockPass
+    , UnusedArgPass
+    >();
+  // Final transformation.
+  mngr.Add<MergeStoresPass>();
+  mngr.Add<StackObjectElimPass>();
+  mngr.Add<LocalizeSelectPass>();
+  mngr.Add<CamlAllocInlinerPass>();
+}
+
+// -----------------------------------------------------------------------------
+static void AddOpt2(PassManager &mngr)
+{
+  mngr.Add<LinkPass>();
+  // Initial simplification.
+  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
+  mngr.Add<DeadCodeElimPass>();
+  mngr.Add<MoveElimPass>();
+  mngr.Add<SimplifyCfgPass>();
+  mngr.Add<TailRecElimPass>();
+  mngr.Add<CamlAssignPass>();
+  // General simplification.
+  mngr.Group
+    < ConstGlobalPass
+    , SCCPPass
+    , LibCSimplifyPass
+    , SimplifyCfgPass
+    , DedupConstPass
+    , BypassPhiPass
+    , SpecialisePass
+    , DeadCodeElimPass
+    , DeadFuncElimPass
+    , DeadDataElimPass
+    , MoveElimPass
+    , MovePushPass
+    , PhiTautPass
+    , InlinerPass
+    , CondSimplifyPass
+    , DedupBlockPass
+    , UnusedArgPass
+    >();
+  // Final transformation.
+  mngr.Add<MergeStoresPass>();
+  mngr.Add<StackObjectElimPass>();
+  mngr.Add<LocalizeSelectPass>();
+  mngr.Add<CamlAllocInlinerPass>();
+}
+
+// -----------------------------------------------------------------------------
+static void AddOpt3(PassManager &mngr)
+{
+  mngr.Add<LinkPass>();
+  // Initial simplification.
+  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
+  mngr.Add<DeadCodeElimPass>();
+  mngr.Add<MoveElimPass>();
+  mngr.Add<SimplifyCfgPass>();
+  mngr.Add<TailRecElimPass>();
+  mngr.Add<CamlAssignPass>();
+  // General simplification.
+  mngr.Group
+    < ConstGlobalPass
+    , SCCPPass
+    , LibCSimplifyPass
+    , SimplifyCfgPass
+    , DedupConstPass
+    , BypassPhiPass
+    , SpecialisePass
+    , DeadCodeElimPass
+    , DeadFuncElimPass
+    , DeadDataElimPass
+    , MoveElimPass
+    , MovePushPass
+    , PhiTautPass
+    , InlinerPass
+    , CondSimplifyPass
+    , DedupBlockPass
+    , UnusedArgPass
+    >();
+  // Final transformation.
+  mngr.Add<MergeStoresPass>();
+  mngr.Add<StackObjectElimPass>();
+  mngr.Add<LocalizeSelectPass>();
+  mngr.Add<CamlAllocInlinerPass>();
+}
+
+// -----------------------------------------------------------------------------
+static void AddOpt4(PassManager &mngr)
+{
+  mngr.Add<LinkPass>();
+  // Initial simplification.
+  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
+  mngr.Add<DeadCodeElimPass>();
+  mngr.Add<MoveElimPass>();
+  mngr.Add<SimplifyCfgPass>();
+  mngr.Add<TailRecElimPass>();
+  mngr.Add<CamlAssignPass>();
+  // General simplification.
+  mngr.Group
+    < PeepholePass
+    , CamlGlobalSimplifyPass
+    , ConstGlobalPass
+    , LibCSimplifyPass
+    , SCCPPass
+    , DedupConstPass
+    , SimplifyCfgPass
+    , BypassPhiPass
+    , SpecialisePass
+    , EliminateSelectPass
+    , DeadCodeElimPass
+    , DeadFuncElimPass
+    , DeadDataElimPass
+    , MoveElimPass
+    , MovePushPass
+    , PhiTautPass
+    , InlinerPass
+    , CondSimplifyPass
+    , DedupBlockPass
+    , UnusedArgPass
+    >();
+  // Final transformation.
+  mngr.Add<MergeStoresPass>();
+  mngr.Add<StackObjectElimPass>();
+  mngr.Add<LocalizeSelectPass>();
+  mngr.Add<CodeLayoutPass>();
+  mngr.Add<CamlAllocInlinerPass>();
+}
+
+// -----------------------------------------------------------------------------
+static void AddOptS(PassManager &mngr)
+{
+  // First round - compact
+  mngr.Add<LinkPass>();
+  // Simplify functions and eliminate trivial items.
+  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
+  mngr.Add<DeadCodeElimPass>();
+  mngr.Add<MoveElimPass>();
+  mngr.Add<MovePushPass>();
+  mngr.Add<SimplifyCfgPass>();
+  mngr.Add<TailRecElimPass>();
+  mngr.Add<SimplifyTrampolinePass>();
+  mngr.Group<DeadFuncElimPass, DeadDataElimPass>();
+  mngr.Add<DeadCodeElimPass>();
+  mngr.Add<AtomSimplifyPass>();
+  mngr.Add<CamlAssignPass>();
+  // Optimise, evaluate and optimise again.
+  mngr.Group
+    < PeepholePass
+    , CamlGlobalSimplifyPass
+    , ConstGlobalPass
+    , LibCSimplifyPass
+    , ValueNumberingPass
+    , SCCPPass
+    , DedupBlockPass
+    , SimplifyCfgPass
+    , DedupConstPass
+    , BypassPhiPass
+    , DeadCodeElimPass
+    , DeadFuncElimPass
+    , DeadDataElimPass
+    , MoveElimPass
+    , MovePushPass
+    , PhiTautPass
+    , EliminateSelectPass
+    , EliminateTagsPass
+    , SpecialisePass
+    , InlinerPass
+    , CondSimplifyPass
+    , ObjectSplitPass
+    , StoreToLoadPass
+    , DeadStorePass
+    , MemoryToRegisterPass
+    , UnusedArgPass
+    , GlobalForwardPass
+    >();
+  // Final simplification.
+  mngr.Add<MergeStoresPass>();
+  mngr.Add<LocalizeSelectPass>();
+  mngr.Add<CodeLayoutPass>();
+  mngr.Add<StackObjectElimPass>();
+}
+
+// -----------------------------------------------------------------------------
+void AddPasses(PassManager &mngr, OptLevel level)
+{
+  switch (level) {
+    case OptLevel::O0: return AddOpt0(mngr);
+    case OptLevel::O1: return AddOpt1(mngr);
+    case OptLevel::O2: return AddOpt2(mngr);
+    case OptLevel::O3: return AddOpt3(mngr);
+    case OptLevel::O4: return AddOpt4(mngr);
+    case OptLevel::Os: return AddOptS(mngr);
+  }
+  llvm_unreachable("invalid optimisation level");
+}
+
+// -----------------------------------------------------------------------------
+void RegisterPasses(PassRegistry &registry)
+{
+  registry.Register<AllocSizePass>();
+  registry.Register<CamlAllocInlinerPass>();
+  registry.Register<CamlGlobalSimplifyPass>();
+  registry.Register<CamlAssignPass>();
+  registry.Register<DeadCodeElimPass>();
+  registry.Register<DeadDataElimPass>();
+  registry.Register<DeadFuncElimPass>();
+  registry.Register<DeadStorePass>();
+  registry.Register<DedupBlockPass>();
+  registry.Register<SpecialisePass>();
+  registry.Register<InlinerPass>();
+  registry.Register<LinkPass>();
+  registry.Register<MoveElimPass>();
+  registry.Register<MovePushPass>();
+  registry.Register<PreEvalPass>();
+  registry.Register<SCCPPass>();
+  registry.Register<SimplifyCfgPass>();
+  registry.Register<SimplifyTrampolinePass>();
+  registry.Register<StackObjectElimPass>();
+  registry.Register<TailRecElimPass>();
+  registry.Register<ConstGlobalPass>();
+  registry.Register<UndefElimPass>();
+  registry.Register<MemoryToRegisterPass>();
+  registry.Register<PointsToAnalysis>();
+  registry.Register<AtomSimplifyPass>();
+  registry.Register<EliminateSelectPass>();
+  registry.Register<CondSimplifyPass>();
+  registry.Register<StoreToLoadPass>();
+  registry.Register<LibCSimplifyPass>();
+  registry.Register<UnusedArgPass>();
+  registry.Register<GlobalForwardPass>();
+  registry.Register<ObjectSplitPass>();
+  registry.Register<ValueNumberingPass>();
+  registry.Register<LinearisePass>();
+  registry.Register<PhiTautPass>();
+  registry.Register<CodeLayoutPass>();
+  registry.Register<LocalizeSelectPass>();
+  registry.Register<EliminateTagsPass>();
+}
+
+// -----------------------------------------------------------------------------
+std::unique_ptr<Target> CreateTarget(
+    const llvm::Triple &tt,
+    const std::string &cpu,
+    const std::string &tuneCPU,
+    const std::string &fs,
+    const std::string &abi,
+    bool shared)
+{
+  switch (tt.getArch()) {
+    case llvm::Triple::x86:
+    case llvm::Triple::x86_64: {
+      return std::make_unique<X86Target>(tt, cpu, tuneCPU, fs, abi, shared);
+    }
+    case llvm::Triple::aarch64: {
+      return std::make_unique<AArch64Target>(tt, cpu, tuneCPU, fs, abi, shared);
+    }
+    case llvm::Triple::riscv64: {
+      return std::make_unique<RISCVTarget>(tt, cpu, tuneCPU, fs, abi, shared);
+    }
+    case llvm::Triple::ppc64le: {
+      return std::make_unique<PPCTarget>(tt, cpu, tuneCPU, fs, abi, shared);
+    }
+    default: {
+      return nullptr;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::unique_ptr<Emitter> CreateEmitter(
+    const std::string &path,
+    llvm::raw_fd_ostream &os,
+    Target &target)
+{
+  if (auto *t = target.As<X86Target>()) {
+    return std::make_unique<X86Emitter>(path, os, *t);
+  }
+  if (auto *t = target.As<AArch64Target>()) {
+    return std::make_unique<AArch64Emitter>(path, os, *t);
+  }
+  if (auto *t = target.As<RISCVTarget>()) {
+    return std::make_unique<RISCVEmitter>(path, os, *t);
+  }
+  if (auto *t = target.As<PPCTarget>()) {
+    return std::make_unique<PPCEmitter>(path, os, *t);
+  }
+  llvm::report_fatal_error(
+      "Unknown architecture: " + target.GetTriple().normalize()
+  );
+}
@@ -0,0 +1,50 @@
+// This file if part of the llir-opt project.
+// Licensing information can be found in the LICENSE file.
+// (C) 2018 Nandor Licker. All rights reserved.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <llvm/ADT/Triple.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "core/pass_manager.h"
+
+class Emitter;
+class PassRegistry;
+class Target;
+
+
+
+/**
+ * Registers all passes which can be requested by name.
+ */
+void RegisterPasses(PassRegistry &registry);
+
+/**
+ * Adds the default pipeline of an optimisation level to a pass manager.
+ */
+void AddPasses(PassManager &mngr, OptLevel level);
+
+/**
+ * Creates the description of a target, returning null if not supported.
+ */
+std::unique_ptr<Target> CreateTarget(
+    const llvm::Triple &tt,
+    const std::string &cpu,
+    const std::string &tuneCPU,
+    const std::string &fs,
+    const std::string &abi,
+    bool shared
+);
+
+/**
+ * Creates the code generator for a target.
+ */
+std::unique_ptr<Emitter> CreateEmitter(
+    const std::string &path,
+    llvm::raw_fd_ostream &os,
+    Target &target
+);
@@ -3,11 +3,93 @@
 // (C) 2018 Nandor Licker. All rights reserved.
 
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/WithColor.h>
+#include <llvm/Object/Archive.h>
+#include <llvm/Object/ArchiveWriter.h>
 
+#include "core/archive_index.h"
+#include "core/util.h"
 
+namespace cl = llvm::cl;
+
+
+// -----------------------------------------------------------------------------
+static llvm::StringRef ToolName;
+
+// -----------------------------------------------------------------------------
+static cl::list<std::string>
+optInputs(cl::Positional, cl::desc("<archive>..."), cl::OneOrMore);
+
+// -----------------------------------------------------------------------------
+static llvm::Error IndexArchive(llvm::StringRef path)
+{
+  // Open the file.
+  auto fileOrErr = llvm::MemoryBuffer::getFile(path);
+  if (auto ec = fileOrErr.getError()) {
+    return llvm::errorCodeToError(ec);
+  }
+
+  // Parse the archive.
+  auto buffer = fileOrErr.get()->getMemBufferRef();
+  auto libOrErr = llvm::object::Archive::create(buffer);
+  if (!libOrErr) {
+    return libOrErr.takeError();
+  }
+  auto &lib = *libOrErr.get();
+
+  // Thin archives only reference their members: they are left untouched.
+  if (lib.isThin()) {
+    return llvm::Error::success();
+  }
+
+  // Record all members, replacing the index.
+  std::vector<llvm::NewArchiveMember> members;
+  bool hasLLIR = false;
+  llvm::Error err = llvm::Error::success();
+  for (auto &child : lib.children(err)) {
+    auto memberOrErr = llvm::NewArchiveMember::getOldMember(child, false);
+    if (!memberOrErr) {
+      return memberOrErr.takeError();
+    }
+    hasLLIR = hasLLIR || IsLLIRObject(memberOrErr->Buf->getBuffer());
+    members.emplace_back(std::move(memberOrErr.get()));
+  }
+  if (err) {
+    return err;
+  }
+
+  // Archives without LLIR objects are not rewritten.
+  if (!hasLLIR) {
+    return llvm::Error::success();
+  }
+
+  const auto kind = lib.kind();
+  return WriteIndexedArchive(
+      path,
+      std::move(members),
+      std::move(fileOrErr.get()),
+      kind
+  );
+}
 
 // -----------------------------------------------------------------------------
 int main(int argc, char **argv)
 {
+  ToolName = argc > 0 ? argv[0] : "llir-ranlib";
+
+  if (!cl::ParseCommandLineOptions(argc, argv, "LLIR archive indexer\n\n")) {
+    return EXIT_FAILURE;
+  }
+
+  for (const std::string &input : optInputs) {
+    if (auto err = IndexArchive(input)) {
+      llvm::handleAllErrors(std::move(err), [&](const llvm::ErrorInfoBase &e) {
+        llvm::WithColor::error(llvm::errs(), ToolName)
+            << input << ": " << e.message() << "\n";
+      });
+      return EXIT_FAILURE;
+    }
+  }
   return EXIT_SUCCESS;
 }